@@ -9,35 +9,79 @@ CONFIG += c++17 resources_big
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# Trace points (trace.h) are compiled into debug builds only. Add DEFINES+=REMOTECONTROL_TRACE
+# to the qmake call to trace a release build.
+CONFIG(debug, debug|release): DEFINES += REMOTECONTROL_TRACE
+
+# shm_open lives in librt on glibc before 2.34
+linux: LIBS += -lrt
+
 SOURCES += \
+    batchreceiver.cpp \
+    batchsender.cpp \
     camerahandler.cpp \
+    clocksync.cpp \
     communicationhandler.cpp \
+    controlchannel.cpp \
     custom3dwindow.cpp \
     gamepadhandler.cpp \
     helper.cpp \
+    hostresolver.cpp \
     inputhandler.cpp \
+    kinematics.cpp \
+    kinematicsbatch.cpp \
     kinematicshandler.cpp \
+    latencyhistogram.cpp \
+    linkestimator.cpp \
     loggerhandler.cpp \
     main.cpp \
     mainwindow.cpp \
     outputhandler.cpp \
+    protocol.cpp \
+    robotendpoint.cpp \
     settingshandler.cpp \
-    simulationhandler.cpp
+    setpointmailbox.cpp \
+    sharedmemorylink.cpp \
+    simulationhandler.cpp \
+    stopsender.cpp \
+    telemetryrecorder.cpp \
+    telemetryring.cpp \
+    trace.cpp \
+    trajectorypredictor.cpp
 
 HEADERS += \
+    batchreceiver.h \
+    batchsender.h \
     camerahandler.h \
+    clocksync.h \
     communicationhandler.h \
+    controlchannel.h \
     constants.h \
     custom3dwindow.h \
+    drivemodel.h \
     gamepadhandler.h \
     helper.h \
+    hostresolver.h \
     inputhandler.h \
+    kinematics.h \
     kinematicshandler.h \
+    latencyhistogram.h \
+    linkestimator.h \
+    linkstatistics.h \
     loggerhandler.h \
     mainwindow.h \
     outputhandler.h \
+    protocol.h \
+    robotendpoint.h \
     settingshandler.h \
-    simulationhandler.h
+    setpointmailbox.h \
+    sharedmemorylink.h \
+    simulationhandler.h \
+    stopsender.h \
+    telemetryrecorder.h \
+    telemetryring.h \
+    trace.h \
+    trajectorypredictor.h
 
 FORMS += \
     mainwindow.ui
@@ -0,0 +1,120 @@
+#include "batchreceiver.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <arpa/inet.h>
+#endif
+
+BatchReceiver::BatchReceiver()
+{
+    size = ProtocolConstants::MAX_RECEIVE_BATCH;
+    for (int i = 0; i < ProtocolConstants::MAX_RECEIVE_BATCH; i++) {
+        views[i].data = slab[i];
+        views[i].size = 0;
+        views[i].senderPort = 0;
+    }
+
+#ifdef Q_OS_LINUX
+    // The message headers point into the slab once, receive() only resets the lengths
+    std::memset(messages, 0, sizeof(messages));
+    for (int i = 0; i < ProtocolConstants::MAX_RECEIVE_BATCH; i++) {
+        vectors[i].iov_base = slab[i];
+        vectors[i].iov_len = ProtocolConstants::MAX_PACKET_SIZE;
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_name = &senders[i];
+    }
+    std::memset(&lastSender, 0, sizeof(lastSender));
+    lastSenderPort = 0;
+#endif
+}
+
+/**
+ * @brief Checks if batched receiving is available on this platform.
+ * @return True on Linux, otherwise false.
+ */
+bool BatchReceiver::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Sets the maximum number of datagrams drained per receive call.
+ * @param Batch size, clamped to 1 - ProtocolConstants::MAX_RECEIVE_BATCH.
+ */
+void BatchReceiver::setBatchSize(int size)
+{
+    this->size = std::clamp(size, 1, ProtocolConstants::MAX_RECEIVE_BATCH);
+}
+
+/**
+ * @brief Gets the maximum number of datagrams drained per receive call.
+ * @return Batch size.
+ */
+int BatchReceiver::batchSize() const
+{
+    return size;
+}
+
+/**
+ * @brief Reads up to batchSize() datagrams from the socket without blocking. Views returned
+ * by datagram() are overwritten by the next call.
+ * @param Native descriptor of a bound UDP socket.
+ * @return Number of datagrams received, 0 if none were pending or -1 on error.
+ */
+int BatchReceiver::receive(qintptr socketDescriptor)
+{
+#ifdef Q_OS_LINUX
+    for (int i = 0; i < size; i++) {
+        messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        messages[i].msg_hdr.msg_flags = 0;
+    }
+
+    int received;
+    do {
+        received = recvmmsg(int(socketDescriptor), messages, size, MSG_DONTWAIT, nullptr);
+    } while (received < 0 && errno == EINTR);
+    if (received < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+
+    for (int i = 0; i < received; i++) {
+        const msghdr &header = messages[i].msg_hdr;
+        views[i].size = std::min<qint64>(messages[i].msg_len, ProtocolConstants::MAX_PACKET_SIZE);
+
+        if (!(std::memcmp(&senders[i], &lastSender, header.msg_namelen) == 0)) {
+            std::memcpy(&lastSender, &senders[i], header.msg_namelen);
+            const sockaddr *address = reinterpret_cast<const sockaddr *>(&senders[i]);
+            lastSenderAddress.setAddress(address);
+            if (address->sa_family == AF_INET6) {
+                lastSenderPort = ntohs(reinterpret_cast<const sockaddr_in6 *>(address)->sin6_port);
+            } else {
+                lastSenderPort = ntohs(reinterpret_cast<const sockaddr_in *>(address)->sin_port);
+            }
+        }
+        views[i].senderAddress = lastSenderAddress; // Shared, no allocation
+        views[i].senderPort = lastSenderPort;
+    }
+    return received;
+#else
+    Q_UNUSED(socketDescriptor)
+    return -1;
+#endif
+}
+
+/**
+ * @brief Gets a datagram from the last receive call.
+ * @param Index below the count returned by receive().
+ * @return View into the receive slab.
+ */
+const DatagramView &BatchReceiver::datagram(int index) const
+{
+    return views[index];
+}
@@ -0,0 +1,46 @@
+#ifndef BATCHRECEIVER_H
+#define BATCHRECEIVER_H
+
+#include "constants.h"
+#include "protocol.h"
+
+#include <QtGlobal>
+
+#ifdef Q_OS_LINUX
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+/**
+ * Drains several datagrams per system call into a preallocated slab. Only available on Linux,
+ * isSupported() is false everywhere else and callers fall back to QUdpSocket.
+ */
+class BatchReceiver
+{
+public:
+    BatchReceiver();
+
+    static bool isSupported();
+    void setBatchSize(int size);
+    int batchSize() const;
+    int receive(qintptr socketDescriptor);
+    const DatagramView &datagram(int index) const;
+
+private:
+    int size;
+    DatagramView views[ProtocolConstants::MAX_RECEIVE_BATCH];
+    char slab[ProtocolConstants::MAX_RECEIVE_BATCH][ProtocolConstants::MAX_PACKET_SIZE];
+
+#ifdef Q_OS_LINUX
+    mmsghdr messages[ProtocolConstants::MAX_RECEIVE_BATCH];
+    iovec vectors[ProtocolConstants::MAX_RECEIVE_BATCH];
+    sockaddr_storage senders[ProtocolConstants::MAX_RECEIVE_BATCH];
+
+    // Most datagrams come from the same robot, the address is only rebuilt when it changes
+    sockaddr_storage lastSender;
+    QHostAddress lastSenderAddress;
+    quint16 lastSenderPort;
+#endif
+};
+
+#endif // BATCHRECEIVER_H
@@ -0,0 +1,200 @@
+#include "batchsender.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <arpa/inet.h>
+#endif
+
+BatchSender::BatchSender()
+{
+    socket = -1;
+    lastError = 0;
+    for (int i = 0; i < ProtocolConstants::MAX_FLEET_SIZE; i++) {
+        sizes[i] = 0;
+    }
+
+#ifdef Q_OS_LINUX
+    family = AF_INET;
+    std::memset(messages, 0, sizeof(messages));
+    std::memset(destinations, 0, sizeof(destinations));
+    for (int i = 0; i < ProtocolConstants::MAX_FLEET_SIZE; i++) {
+        vectors[i].iov_base = slab[i];
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_name = &destinations[i];
+    }
+#endif
+}
+
+/**
+ * @brief Checks if batched sending is available on this platform.
+ * @return True on Linux, otherwise false.
+ */
+bool BatchSender::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Sets the socket to send from. Must be called after every bind and before any
+ * destination is set, since the destination format depends on the socket family.
+ * @param Native descriptor of a bound UDP socket.
+ */
+void BatchSender::setSocket(qintptr socketDescriptor)
+{
+    socket = socketDescriptor;
+#ifdef Q_OS_LINUX
+    sockaddr_storage local;
+    socklen_t length = sizeof(local);
+    family = AF_INET;
+    if (getsockname(int(socket), reinterpret_cast<sockaddr *>(&local), &length) == 0) {
+        family = local.ss_family;
+    }
+#endif
+}
+
+/**
+ * @brief Converts a destination once so sends do not touch QHostAddress.
+ * @param Slot index below ProtocolConstants::MAX_FLEET_SIZE.
+ * @param Destination address.
+ * @param Destination port.
+ */
+void BatchSender::setDestination(int index, const QHostAddress &address, quint16 port)
+{
+#ifdef Q_OS_LINUX
+    sockaddr_storage &destination = destinations[index];
+    std::memset(&destination, 0, sizeof(destination));
+    if (family == AF_INET6) {
+        // IPv4 destinations on a dual stack socket have to be IPv4 mapped, which is what
+        // toIPv6Address returns for them
+        sockaddr_in6 *ipv6 = reinterpret_cast<sockaddr_in6 *>(&destination);
+        Q_IPV6ADDR bytes = address.toIPv6Address();
+        ipv6->sin6_family = AF_INET6;
+        ipv6->sin6_port = htons(port);
+        std::memcpy(&ipv6->sin6_addr, &bytes, sizeof(bytes));
+        messages[index].msg_hdr.msg_namelen = sizeof(sockaddr_in6);
+    } else {
+        sockaddr_in *ipv4 = reinterpret_cast<sockaddr_in *>(&destination);
+        ipv4->sin_family = AF_INET;
+        ipv4->sin_port = htons(port);
+        ipv4->sin_addr.s_addr = htonl(address.toIPv4Address());
+        messages[index].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    }
+#else
+    Q_UNUSED(index)
+    Q_UNUSED(address)
+    Q_UNUSED(port)
+#endif
+}
+
+/**
+ * @brief Gets the payload buffer of a slot.
+ * @param Slot index below ProtocolConstants::MAX_FLEET_SIZE.
+ * @return Buffer of ProtocolConstants::MAX_PACKET_SIZE bytes.
+ */
+char *BatchSender::buffer(int index)
+{
+    return slab[index];
+}
+
+/**
+ * @brief Gets the payload size of a slot.
+ * @param Slot index below ProtocolConstants::MAX_FLEET_SIZE.
+ * @return Size in bytes as set by setSize.
+ */
+int BatchSender::size(int index) const
+{
+    return sizes[index];
+}
+
+/**
+ * @brief Sets how many bytes of a slot's buffer are sent.
+ * @param Slot index below ProtocolConstants::MAX_FLEET_SIZE.
+ * @param Payload size in bytes.
+ */
+void BatchSender::setSize(int index, int size)
+{
+    sizes[index] = size;
+}
+
+/**
+ * @brief Sends slots first to count - 1 without blocking. Stops at the first datagram the
+ * kernel refuses, error tells why.
+ * @param End of the slot range.
+ * @param First slot to send.
+ * @return Number of datagrams handed to the kernel or -1 if the first one failed.
+ */
+int BatchSender::send(int count, int first)
+{
+    lastError = 0;
+#ifdef Q_OS_LINUX
+    for (int i = first; i < count; i++) {
+        vectors[i].iov_len = size_t(sizes[i]);
+    }
+
+    int sent = 0;
+    while (first + sent < count) {
+        int result = sendmmsg(int(socket),
+                              messages + first + sent,
+                              count - first - sent,
+                              MSG_DONTWAIT);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            lastError = errno;
+            return sent > 0 ? sent : -1;
+        }
+        sent += result;
+    }
+    return sent;
+#else
+    Q_UNUSED(count)
+    Q_UNUSED(first)
+    return -1;
+#endif
+}
+
+/**
+ * @brief Gets the error that ended the last send.
+ * @return errno value, 0 if every datagram was sent.
+ */
+int BatchSender::error() const
+{
+    return lastError;
+}
+
+/**
+ * @brief Checks if the last send ended because the socket send buffer is full. The socket
+ * takes datagrams again once it turns writable.
+ * @return True for EAGAIN and ENOBUFS, otherwise false.
+ */
+bool BatchSender::isBlocked() const
+{
+#ifdef Q_OS_LINUX
+    return lastError == EAGAIN || lastError == EWOULDBLOCK || lastError == ENOBUFS;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Checks if the last send ended because the destination cannot be reached, like when
+ * the interface is down or there is no route to it.
+ * @return True for unreachable and down networks and hosts, otherwise false.
+ */
+bool BatchSender::isUnreachable() const
+{
+#ifdef Q_OS_LINUX
+    return lastError == ENETUNREACH || lastError == EHOSTUNREACH || lastError == ENETDOWN
+           || lastError == EHOSTDOWN;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,48 @@
+#ifndef BATCHSENDER_H
+#define BATCHSENDER_H
+
+#include "constants.h"
+
+#include <QHostAddress>
+#include <QtGlobal>
+
+#ifdef Q_OS_LINUX
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+/**
+ * Sends one datagram per destination slot with a single system call. Only available on Linux,
+ * isSupported() is false everywhere else and callers write each slot through QUdpSocket.
+ */
+class BatchSender
+{
+public:
+    BatchSender();
+
+    static bool isSupported();
+    void setSocket(qintptr socketDescriptor);
+    void setDestination(int index, const QHostAddress &address, quint16 port);
+    char *buffer(int index);
+    int size(int index) const;
+    void setSize(int index, int size);
+    int send(int count, int first = 0);
+    int error() const;
+    bool isBlocked() const;
+    bool isUnreachable() const;
+
+private:
+    qintptr socket;
+    int lastError; // errno of the failure that ended the last send, 0 if it sent everything
+    char slab[ProtocolConstants::MAX_FLEET_SIZE][ProtocolConstants::MAX_PACKET_SIZE];
+    int sizes[ProtocolConstants::MAX_FLEET_SIZE];
+
+#ifdef Q_OS_LINUX
+    int family;
+    mmsghdr messages[ProtocolConstants::MAX_FLEET_SIZE];
+    iovec vectors[ProtocolConstants::MAX_FLEET_SIZE];
+    sockaddr_storage destinations[ProtocolConstants::MAX_FLEET_SIZE];
+#endif
+};
+
+#endif // BATCHSENDER_H
@@ -1,5 +1,7 @@
 #include "camerahandler.h"
 
+#include <QTimer>
+
 CameraHandler::CameraHandler(LoggerHandler *loggerRef, QSettings *settingsRef)
 {
     logger = loggerRef;
@@ -7,6 +9,10 @@ CameraHandler::CameraHandler(LoggerHandler *loggerRef, QSettings *settingsRef)
     vw = new QVideoWidget();
     mp = new QMediaPlayer(this);
     mp->setVideoOutput(vw);
+    resolver = new HostResolver(this);
+    resolveFailed = false;
+    connect(resolver, &HostResolver::resolved, this, &CameraHandler::hostResolved);
+    connect(resolver, &HostResolver::failed, this, &CameraHandler::hostFailed);
 
     connect(mp, SIGNAL(error(QMediaPlayer::Error)), this, SLOT(reportErrors(QMediaPlayer::Error)));
     connect(mp, &QMediaPlayer::mediaStatusChanged, this, [this](QMediaPlayer::MediaStatus s) {
@@ -27,6 +33,65 @@ void CameraHandler::connectCamera(QNetworkRequest networkRequest)
     mp->play();
 }
 
+/**
+ * @brief Connects to the configured camera URL with its host replaced by an address. Camera
+ * servers on the robots are addressed by IP, so the name is not needed past this point.
+ * @param Resolved host address, null to use the URL as it is.
+ */
+void CameraHandler::connectResolved(const QHostAddress &address)
+{
+    QUrl url = cameraUrl;
+    if (!address.isNull()) {
+        url.setHost(address.toString());
+    }
+    TRACE(TraceConstants::CAMERA,
+          TraceConstants::CAMERA_CONNECT,
+          address.toIPv4Address(),
+          url.port(0),
+          0);
+    connectCamera(QNetworkRequest(url));
+}
+
+/**
+ * @brief Connects once the camera host resolved, or reconnects when it moved to another
+ * address.
+ * @param Host name.
+ * @param Resolved address.
+ */
+void CameraHandler::hostResolved(const QString &host, const QHostAddress &address)
+{
+    if (!(host == cameraUrl.host())) {
+        return; // Setting changed meanwhile
+    }
+    resolveFailed = false;
+    logger->write(LoggerConstants::INFO,
+                  QString("Resolved camera host ") + host + " to " + address.toString());
+    connectResolved(address);
+}
+
+/**
+ * @brief Reports a camera host that could not be resolved, once until it resolves, and tries
+ * again after ResolverConstants::FAILURE_TTL while it is still configured.
+ * @param Host name.
+ * @param Resolver error.
+ */
+void CameraHandler::hostFailed(const QString &host, const QString &error)
+{
+    if (!(host == cameraUrl.host())) {
+        return;
+    }
+    if (!resolveFailed) {
+        resolveFailed = true;
+        logger->write(LoggerConstants::WARNING,
+                      QString("Could not resolve camera host ") + host + ": " + error);
+    }
+    QTimer::singleShot(ResolverConstants::FAILURE_TTL, this, [this, host]() {
+        if (host == cameraUrl.host()) {
+            resolver->refresh(host);
+        }
+    });
+}
+
 void CameraHandler::reportErrors(QMediaPlayer::Error e)
 {
     int lastLevel = logger->getLevel();
@@ -56,6 +121,12 @@ void CameraHandler::reportErrors(QMediaPlayer::Error e)
     }
 
     logger->setLevel(lastLevel);
+
+    // The camera may have moved to another address, look its name up again in the background
+    if ((e == QMediaPlayer::Error::ResourceError || e == QMediaPlayer::Error::NetworkError)
+        && !cameraUrl.host().isEmpty()) {
+        resolver->refresh(cameraUrl.host());
+    }
 }
 
 void CameraHandler::updateWithSettings()
@@ -73,8 +144,18 @@ void CameraHandler::updateWithSettings()
                       ->value(SettingsConstants::CONN_CAM_ADDRESS,
                               SettingsConstants::D_CONN_CAM_ADDRESS)
                       .toString();
-    qDebug() << url;
-    connectCamera(QNetworkRequest(QUrl(url)));
+    cameraUrl = QUrl(url);
+    resolveFailed = false;
+
+    // Names are looked up in the background, the camera connects once hostResolved ran
+    QString host = cameraUrl.host();
+    QHostAddress address;
+    if (host.isEmpty() || resolver->lookup(host, address)) {
+        connectResolved(address);
+    } else {
+        logger->write(LoggerConstants::INFO, QString("Resolving camera host ") + host + "...");
+        mp->stop();
+    }
 }
 
 QVideoWidget *CameraHandler::getWidget()
@@ -1,12 +1,15 @@
 #ifndef CAMERAHANDLER_H
 #define CAMERAHANDLER_H
 
+#include "hostresolver.h"
 #include "loggerhandler.h"
+#include "trace.h"
 
 #include <QMediaPlayer>
 #include <QNetworkRequest>
 #include <QObject>
 #include <QSettings>
+#include <QUrl>
 #include <QVideoWidget>
 
 class CameraHandler : public QObject
@@ -24,11 +27,17 @@ private:
     QSettings *settings;
     QVideoWidget *vw;
     QMediaPlayer *mp;
+    HostResolver *resolver;
+    QUrl cameraUrl; // As configured, its host may still need resolving
+    bool resolveFailed;
 
     void connectCamera(QNetworkRequest networkRequest);
+    void connectResolved(const QHostAddress &address);
 
 private slots:
     void reportErrors(QMediaPlayer::Error e);
+    void hostResolved(const QString &host, const QHostAddress &address);
+    void hostFailed(const QString &host, const QString &error);
 };
 
 #endif // CAMERAHANDLER_H
@@ -0,0 +1,162 @@
+#include "clocksync.h"
+
+#include "constants.h"
+
+#include <algorithm>
+
+ClockSync::ClockSync()
+{
+    reset();
+}
+
+/**
+ * @brief Forgets every exchange, done when a different robot answers.
+ */
+void ClockSync::reset()
+{
+    recentCount = 0;
+    recentNewest = FILTER - 1;
+    trustedCount = 0;
+    trustedNewest = HISTORY - 1;
+    samples = 0;
+    baseOffset = 0.0;
+    slope = 0.0;
+    baseTime = 0;
+    trustedDelay = 0.0;
+}
+
+/**
+ * @brief Adds a completed exchange. All times in microseconds, t1 and t4 on the server clock,
+ * t2 and t3 on the robot clock.
+ * @param Request sent.
+ * @param Request received by the robot.
+ * @param Reply sent by the robot.
+ * @param Reply received.
+ */
+void ClockSync::addSample(quint64 t1, quint64 t2, quint64 t3, quint64 t4)
+{
+    if (t4 < t1 || t3 < t2) {
+        return; // Not from this server session or a broken robot clock
+    }
+    Exchange exchange;
+    exchange.time = qint64(t1 + (t4 - t1) / 2);
+    exchange.offset = ((double(t2) - double(t1)) + (double(t3) - double(t4))) / 2.0;
+    exchange.delay = std::max(double(t4 - t1) - double(t3 - t2), 0.0);
+    recentNewest = (recentNewest + 1) % FILTER;
+    recent[recentNewest] = exchange;
+    recentCount = std::min(recentCount + 1, FILTER);
+    samples++;
+
+    // Queueing only ever adds delay, so the fastest exchange has the least skewed offset
+    int best = recentNewest;
+    for (int i = 0; i < recentCount; i++) {
+        if (recent[i].delay < recent[best].delay) {
+            best = i;
+        }
+    }
+    if (trustedCount > 0 && recent[best].time == trusted[trustedNewest].time) {
+        return; // Still the same trusted exchange
+    }
+    trustedNewest = (trustedNewest + 1) % HISTORY;
+    trusted[trustedNewest] = recent[best];
+    trustedCount = std::min(trustedCount + 1, HISTORY);
+    trustedDelay = recent[best].delay;
+    fit();
+}
+
+/**
+ * @brief Fits offset = baseOffset + slope * (time - baseTime) through the trusted exchanges
+ * with least squares. The slope stays 0 until two exchanges span at least a second.
+ */
+void ClockSync::fit()
+{
+    baseTime = trusted[trustedNewest].time;
+    double sumT = 0.0;
+    double sumTT = 0.0;
+    double sumO = 0.0;
+    double sumTO = 0.0;
+    double first = 0.0;
+    double last = 0.0;
+    for (int i = 0; i < trustedCount; i++) {
+        double t = double(trusted[i].time - baseTime);
+        sumT += t;
+        sumTT += t * t;
+        sumO += trusted[i].offset;
+        sumTO += t * trusted[i].offset;
+        first = std::min(first, t);
+        last = std::max(last, t);
+    }
+
+    double n = trustedCount;
+    double denominator = n * sumTT - sumT * sumT;
+    if (trustedCount < 2 || last - first < 1000000.0 || denominator <= 0.0) {
+        slope = 0.0;
+        baseOffset = trusted[trustedNewest].offset;
+        return;
+    }
+    // Real crystals stay well within the limit, anything beyond is a fit on noise
+    const double limit = ClockConstants::MAX_DRIFT / 1000000.0;
+    slope = std::clamp((n * sumTO - sumT * sumO) / denominator, -limit, limit);
+    baseOffset = (sumO - slope * sumT) / n;
+}
+
+/**
+ * @brief Checks if enough exchanges completed for the robot clock to be converted.
+ * @return True once ClockConstants::MIN_SAMPLES exchanges arrived, otherwise false.
+ */
+bool ClockSync::isSynchronized() const
+{
+    return samples >= ClockConstants::MIN_SAMPLES;
+}
+
+/**
+ * @brief Gets the number of exchanges added since the last reset.
+ * @return Exchange count.
+ */
+int ClockSync::sampleCount() const
+{
+    return samples;
+}
+
+/**
+ * @brief Gets the fitted offset at the newest trusted exchange.
+ * @return Microseconds the robot clock is ahead of the server clock.
+ */
+double ClockSync::offset() const
+{
+    return baseOffset;
+}
+
+/**
+ * @brief Gets the fitted drift.
+ * @return Parts per million the robot clock runs faster than the server clock.
+ */
+double ClockSync::drift() const
+{
+    return slope * 1000000.0;
+}
+
+/**
+ * @brief Gets the round trip of the newest trusted exchange, the offset is accurate to within
+ * half of it.
+ * @return Microseconds.
+ */
+double ClockSync::delay() const
+{
+    return trustedDelay;
+}
+
+/**
+ * @brief Converts a robot timestamp to the server clock, extrapolating the drift from the
+ * newest trusted exchange.
+ * @param Robot time in microseconds.
+ * @return Server time in microseconds.
+ */
+qint64 ClockSync::toServer(quint64 robotTime) const
+{
+    // The offset is a function of server time, robot time minus the base offset is close
+    // enough to it for a drift of a few hundred ppm
+    double approximate = double(robotTime) - baseOffset;
+    double offsetThen = baseOffset + slope * (approximate - double(baseTime));
+    return qint64(double(robotTime) - offsetThen);
+}
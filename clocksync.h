@@ -0,0 +1,54 @@
+#ifndef CLOCKSYNC_H
+#define CLOCKSYNC_H
+
+#include <QtGlobal>
+
+/**
+ * Estimates the offset and drift of a robot clock against the server clock from NTP style
+ * exchanges: the server stamps a request when it is sent (t1), the robot when it arrives (t2)
+ * and when the reply leaves (t3), and the server again when the reply arrives (t4). Like the
+ * NTP clock filter only the exchange with the smallest round trip out of the last few is
+ * trusted, and the drift is the slope of a line fitted through those trusted offsets.
+ */
+class ClockSync
+{
+public:
+    ClockSync();
+    void reset();
+    void addSample(quint64 t1, quint64 t2, quint64 t3, quint64 t4);
+
+    bool isSynchronized() const;
+    int sampleCount() const;
+    double offset() const; // us, robot clock minus server clock now
+    double drift() const;  // ppm, robot clock rate minus server clock rate
+    double delay() const;  // us, round trip of the trusted exchange
+    qint64 toServer(quint64 robotTime) const;
+
+private:
+    static constexpr int FILTER = 8;   // Exchanges the trusted one is picked from
+    static constexpr int HISTORY = 16; // Trusted offsets the drift is fitted over
+
+    struct Exchange
+    {
+        qint64 time; // Server time between send and receive, us
+        double offset;
+        double delay;
+    };
+
+    Exchange recent[FILTER];
+    Exchange trusted[HISTORY];
+    int recentCount;
+    int recentNewest;
+    int trustedCount;
+    int trustedNewest;
+    int samples;
+
+    double baseOffset; // Fitted offset at baseTime
+    double slope;      // Offset change per us
+    qint64 baseTime;
+    double trustedDelay;
+
+    void fit();
+};
+
+#endif // CLOCKSYNC_H
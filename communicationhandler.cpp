@@ -1,121 +1,1930 @@
 #include "communicationhandler.h"
 
-CommunicationHandler::CommunicationHandler(LoggerHandler *loggerRef, QSettings *settingsRef)
+#include <cmath>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+CommunicationHandler::CommunicationHandler(LoggerHandler *loggerRef,
+                                           QSettings *settingsRef,
+                                           LatencyTracker *latencyRef,
+                                           TelemetryRing *telemetryRef)
 {
     logger = loggerRef;
-    settings = settingsRef;
+    latency = latencyRef;
+    telemetry = telemetryRef;
+    // Own settings instance, this handler runs on its own thread and QSettings objects must
+    // not be shared between threads.
+    settings = new QSettings(settingsRef->fileName(), settingsRef->format(), this);
 
     lastConnectedPort = 0;
+    listenPort = 0;
     sendAddress = QHostAddress::LocalHost;
     enabled = false;
+    packetFormat = SettingsConstants::D_CONN_COMM_FORMAT;
+    sendRate = ProtocolConstants::SEND_RATES[SettingsConstants::D_CONN_COMM_RATE];
+    batchReceive = false;
+    fleetMode = false;
+    unresolvedRobots = 0;
+    controlPort = SettingsConstants::D_CONN_COMM_CONTROL_PORT;
+    driveModel = SettingsConstants::D_CONN_COMM_DRIVE;
+    writeNotifier = nullptr;
+    writeDescriptor = -1;
+    sendBlocked = false;
+    unsentRobot = 0;
+    packetWritten = false;
+    latencyPending = false;
+    bindAddress = QHostAddress(QHostAddress::AnyIPv4);
+    discovery = false;
+    discovering = false;
+    discoveryNonce = 0;
+    discoveryStart = 0;
+    producerMoving = false;
+    suppressEpsilon = ProtocolConstants::SUPPRESS_EPSILONS[SettingsConstants::D_CONN_COMM_SUPPRESS];
+    keepaliveInterval = SettingsConstants::D_CONN_COMM_KEEPALIVE;
+    stopPolicy = SettingsConstants::D_CONN_COMM_STOP;
+    movementSent = false;
+    horizonPoints = ProtocolConstants::TRAJECTORY_HORIZONS[SettingsConstants::D_CONN_COMM_HORIZON];
+    trajectorySteady = true;
+    quantizationBits
+        = ProtocolConstants::QUANTIZATION_BITS[SettingsConstants::D_CONN_COMM_QUANTIZATION];
+    stopLatched.store(false);
+    lastSendTime = 0;
+    sequence = 0;
+    syncId = 0;
+    clock.start();
+    resetStatistics();
+
+    qRegisterMetaType<LinkStatistics>();
 
     initSocket();
-    initTimer();
+    initSendTimer();
+    initStatsTimer();
+    initDiscoveryTimer();
+    initSyncTimer();
+    initHelloTimer();
+    initResolver();
+
+    // Control channels block on the network as they please, so they get a thread of their own
+    controlThread = new QThread();
+    controlThread->setObjectName("Control");
+    controlThread->start(QThread::LowPriority);
+}
+
+/**
+ * @brief Closes every control channel and stops their thread. The handler's own thread must
+ * already be finished.
+ */
+CommunicationHandler::~CommunicationHandler()
+{
+    for (int i = 0; i < robots.size(); i++) {
+        closeControl(i);
+    }
+    // Channels still waiting for their deferred delete are deleted as the thread finishes
+    controlThread->quit();
+    controlThread->wait();
+    delete controlThread;
+}
+
+/**
+ * @brief Stores the newest wheel speeds in the mailbox. Nothing is sent here, the send timer
+ * picks up whatever setpoint is the most recent on its next tick so intermediate updates are
+ * dropped. Must be connected with Qt::DirectConnection, it runs on the producer (GUI) thread.
+ */
+void CommunicationHandler::setMovementData(double FL, double BR, double FR, double BL)
+{
+    Setpoint setpoint;
+    setpoint.speeds[0] = FL;
+    setpoint.speeds[1] = BR;
+    setpoint.speeds[2] = FR;
+    setpoint.speeds[3] = BL;
+    // Runs right after the kinematics update that produced these speeds
+    setpoint.inputTime = latency->lastInput();
+    setpoint.kinematicsTime = latency->lastKinematics();
+    mailbox.publish(setpoint);
+
+    bool moving = !(FL == 0.0 && BR == 0.0 && FR == 0.0 && BL == 0.0);
+    if (producerMoving && !moving) {
+        // Stops do not wait for the next scheduler tick
+        QMetaObject::invokeMethod(this, [this]() { sendMovementData(); }, Qt::QueuedConnection);
+    }
+    producerMoving = moving;
+}
+
+/**
+ * @brief Stops every robot right away. The stop skips the setpoint mailbox and the send
+ * scheduler, and latches until the inputs return to zero so the next tick can not drive the
+ * robots again. Safe to call from any thread.
+ */
+void CommunicationHandler::emergencyStop()
+{
+    stopLatched.store(true, std::memory_order_release);
+    sendStop(~quint32(0));
+    // Keep the text log off the caller's thread, that is the hot path here
+    QMetaObject::invokeMethod(
+        this,
+        [this]() { logger->write(LoggerConstants::WARNING, "Emergency stop"); },
+        Qt::QueuedConnection);
+}
+
+/**
+ * @brief Sends redundant stop packets to some robots. Written directly from the calling
+ * thread where supported, otherwise queued to the communication thread. Safe to call from any
+ * thread.
+ * @param Bit mask of robot indices.
+ */
+void CommunicationHandler::sendStop(quint32 robotMask)
+{
+    quint32 id;
+    if (stopSender.stop(robotMask, id)) {
+        return;
+    }
+    QMetaObject::invokeMethod(
+        this,
+        [this, robotMask, id]() {
+            for (int copy = 0; copy < ProtocolConstants::STOP_COPIES; copy++) {
+                QTimer::singleShot(copy * ProtocolConstants::STOP_SPACING,
+                                   Qt::PreciseTimer,
+                                   this,
+                                   [this, robotMask, id]() { writeStop(robotMask, id); });
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+/**
+ * @brief Portable stop path, writes one copy of a stop through the Qt socket or the shared
+ * memory link.
+ * @param Bit mask of robot indices.
+ * @param Stop id.
+ */
+void CommunicationHandler::writeStop(quint32 robotMask, quint32 id)
+{
+    if (!enabled
+        || (commSocket->state() == QUdpSocket::UnconnectedState && !sharedLink.isOpen())) {
+        return;
+    }
+    char packet[ProtocolConstants::MAX_PACKET_SIZE];
+    for (int i = 0; i < robots.size(); i++) {
+        if ((robotMask & (quint32(1) << i)) && !robots[i].endpoint.address.isNull()) {
+            writeDatagram(packet,
+                          StopSender::encode(id, robots[i].format, packet),
+                          robots[i].endpoint.address,
+                          robots[i].endpoint.port);
+        }
+    }
+}
+
+/**
+ * @brief Sends the latest setpoint to every robot in the packet format selected for it.
+ * Called once per send timer tick, which also doubles as a keepalive for the robots.
+ */
+void CommunicationHandler::sendMovementData()
+{
+    Setpoint setpoint;
+    bool fresh = mailbox.fetch(setpoint);
+
+    if (!(lastConnectedPort == 0) && enabled && !robots.isEmpty()) {
+        bool released = setpoint.speeds[0] == 0.0 && setpoint.speeds[1] == 0.0
+                        && setpoint.speeds[2] == 0.0 && setpoint.speeds[3] == 0.0;
+        if (stopLatched.load(std::memory_order_acquire) && released) {
+            stopLatched.store(false, std::memory_order_release);
+            logger->write(LoggerConstants::INFO, "Emergency stop released");
+        }
+        // Latched stops hold every robot at zero until the inputs were let go
+        bool latched = stopLatched.load(std::memory_order_acquire);
+        bool trajectoryFormat = false;
+        for (const Robot &robot : qAsConst(robots)) {
+            trajectoryFormat = trajectoryFormat
+                               || robot.format == ProtocolConstants::TRAJECTORY_FORMAT;
+        }
+        if (trajectoryFormat) {
+            if (released) {
+                // The trend that led to zero must not carry on once the input is let go
+                predictor.reset();
+            }
+            predictor.add(timestamp(), setpoint.speeds);
+        }
+        // A chunk still ramping away from its setpoint has to be replaced even if the
+        // setpoint itself held still
+        bool steady = predictor.isSteady();
+        if (!latched && (!trajectoryFormat || (steady && trajectorySteady))
+            && suppressMovement(setpoint.speeds)) {
+            linkStats.packetsSuppressed++;
+            return;
+        }
+        if (trajectoryFormat) {
+            predictor.predict(horizonPoints, 1000000 / sendRate, trajectory);
+        }
+
+        if (fresh) {
+            unsentSetpoint = setpoint;
+            latencyPending = true;
+        }
+        // Every robot gets the same sequence so heartbeats from any of them match the history.
+        // It is used up by movementWritten, a packet replaced or lost before any of it went out
+        // leaves no gap for the robots to count as loss.
+        MovementPacket packet;
+        packet.sequence = sequence;
+        packet.timestamp = timestamp();
+        packetWritten = false;
+        static const double stop[4] = {0.0, 0.0, 0.0, 0.0};
+        for (int i = 0; i < robots.size(); i++) {
+            bool held = latched || robots[i].stopped;
+            int format = robots[i].format;
+            int size;
+            if (format == ProtocolConstants::TRAJECTORY_FORMAT) {
+                // A released input is a single flat point like a held robot
+                size = serializeTrajectory(packet,
+                                           robots[i].endpoint,
+                                           held || released,
+                                           batchSender.buffer(i));
+            } else {
+                double speeds[4];
+                robots[i].endpoint.apply(held ? stop : setpoint.speeds, speeds);
+                size = serializeMovement(packet, format, speeds, batchSender.buffer(i));
+            }
+            batchSender.setSize(i, size);
+        }
+        // Cleared again by writeMovementData if a datagram is lost
+        movementSent = true;
+        if (sendBlocked) {
+            // Latest wins, the newest setpoint replaces the one still waiting for the socket
+            linkStats.packetsReplaced++;
+            TRACE(TraceConstants::SEND,
+                  TraceConstants::SEND_REPLACED,
+                  packet.sequence,
+                  unsentRobot,
+                  0);
+            unsentRobot = 0;
+        } else {
+            writeMovementData(0);
+            TRACE(TraceConstants::SEND,
+                  TraceConstants::MOVEMENT_SENT,
+                  packet.sequence,
+                  robots.size(),
+                  fresh);
+        }
+        trajectorySteady = steady;
+        lastSendTime = packet.timestamp;
+        for (int i = 0; i < 4; i++) {
+            lastSentSpeeds[i] = setpoint.speeds[i];
+        }
+    }
+}
+
+/**
+ * @brief Counts the newest packet as sent once its first datagram was written. Uses up its
+ * sequence, remembers the send time for the round trip and records the send latency of its
+ * setpoint, unless a packet with the same setpoint was already written.
+ */
+void CommunicationHandler::movementWritten()
+{
+    if (packetWritten) {
+        return;
+    }
+    packetWritten = true;
+    sentTimestamps[sequence & (ProtocolConstants::SEND_HISTORY - 1)] = timestamp();
+    sequence++;
+    linkStats.packetsSent++;
+
+    // Repeated sends of the same setpoint are keepalives, only the first one is latency
+    if (latencyPending) {
+        latencyPending = false;
+        qint64 written = LatencyTracker::now();
+        latency->record(LatencyConstants::KINEMATICS_TO_SEND,
+                        written - unsentSetpoint.kinematicsTime);
+        latency->record(LatencyConstants::INPUT_TO_SEND, written - unsentSetpoint.inputTime);
+    }
 }
 
-void CommunicationHandler::sendMovementData(double FL, double BR, double FR, double BL)
+/**
+ * @brief Decides if a setpoint is close enough to the last one sent to be skipped. A packet is
+ * always sent once the keepalive interval has passed and whenever the robot is told to stop.
+ * @param Four wheel speeds of the setpoint.
+ * @return True if the packet should be skipped, otherwise false.
+ */
+bool CommunicationHandler::suppressMovement(const double *speeds)
 {
-    if (!(lastConnectedPort == 0) && enabled) {
-        QString concatData = QString("m,") + QString::number(FL) + ',' + QString::number(BR) + ','
-                             + QString::number(FR) + ',' + QString::number(BL);
-        commSocket->writeDatagram(QByteArray(concatData.toUtf8()), sendAddress, lastConnectedPort);
-        qDebug() << "S" << sendAddress.toString() << QString::number(lastConnectedPort) << "<-"
-                 << concatData;
+    if (suppressEpsilon <= 0.0 || !movementSent) {
+        return false;
     }
+    if (timestamp() - lastSendTime >= quint64(keepaliveInterval) * 1000) {
+        return false;
+    }
+
+    bool stopped = true;
+    bool wasStopped = true;
+    double change = 0.0;
+    for (int i = 0; i < 4; i++) {
+        stopped = stopped && speeds[i] == 0.0;
+        wasStopped = wasStopped && lastSentSpeeds[i] == 0.0;
+        change = std::max(change, std::abs(speeds[i] - lastSentSpeeds[i]));
+    }
+    if (stopped && !wasStopped) {
+        return false;
+    }
+    return change < suppressEpsilon;
+}
+
+/**
+ * @brief Serializes one robot's wheel speeds into a send buffer. The text format is the legacy
+ * "m,FL,BR,FR,BL" datagram kept for clients that do not understand the binary format yet, the
+ * binary and quantized formats are written without any heap allocation. Quantized speeds add
+ * their rounding error to the quantization statistics.
+ * @param Packet with the sequence and timestamp of this tick, speeds are filled in here.
+ * @param ProtocolConstants::TEXT_FORMAT, BINARY_FORMAT or QUANTIZED_FORMAT.
+ * @param Four wheel speeds for this robot.
+ * @param Buffer of ProtocolConstants::MAX_PACKET_SIZE bytes.
+ * @return Number of bytes written.
+ */
+int CommunicationHandler::serializeMovement(MovementPacket &packet,
+                                            int format,
+                                            const double *speeds,
+                                            char *buffer)
+{
+    if (format == ProtocolConstants::TEXT_FORMAT) {
+        QByteArray text = (QString("m,") + QString::number(speeds[0]) + ','
+                           + QString::number(speeds[1]) + ',' + QString::number(speeds[2]) + ','
+                           + QString::number(speeds[3]))
+                              .toUtf8();
+        int size = std::min(int(text.size()), ProtocolConstants::MAX_PACKET_SIZE);
+        std::memcpy(buffer, text.constData(), size);
+        return size;
+    }
+    if (format == ProtocolConstants::QUANTIZED_FORMAT) {
+        QuantizedPacket quantized;
+        quantized.sequence = quint8(packet.sequence);
+        quantized.bits = quantizationBits;
+        for (int i = 0; i < 4; i++) {
+            quantized.speeds[i] = Protocol::quantize(speeds[i], quantizationBits);
+            double error = std::abs(Protocol::dequantize(quantized.speeds[i], quantizationBits)
+                                    - speeds[i]);
+            quantizationSquares += error * error;
+            quantizationPeak = std::max(quantizationPeak, error);
+            quantizationCount++;
+        }
+        return Protocol::encodeQuantized(quantized, buffer);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        packet.speeds[i] = float(speeds[i]);
+    }
+    return Protocol::encodeMovement(packet, buffer);
+}
+
+/**
+ * @brief Serializes one robot's share of the predicted trajectory into a send buffer. Points
+ * are spaced by the send interval, so the chunk reaches as many ticks ahead as it has points.
+ * @param Packet with the sequence and timestamp of this tick.
+ * @param Robot the chunk is for.
+ * @param True if the robot is held at zero or the input was released, it then gets a single
+ * stopped point.
+ * @param Buffer of ProtocolConstants::MAX_PACKET_SIZE bytes.
+ * @return Number of bytes written.
+ */
+int CommunicationHandler::serializeTrajectory(const MovementPacket &packet,
+                                              const RobotEndpoint &endpoint,
+                                              bool held,
+                                              char *buffer)
+{
+    static const double stop[4] = {0.0, 0.0, 0.0, 0.0};
+    TrajectoryPacket chunk;
+    chunk.sequence = packet.sequence;
+    chunk.timestamp = packet.timestamp;
+    chunk.count = held ? 1 : horizonPoints;
+    int spacing = 1000000 / sendRate;
+    for (int n = 0; n < chunk.count; n++) {
+        double speeds[4];
+        endpoint.apply(held ? stop : trajectory[n], speeds);
+        chunk.points[n].offset = quint32(n * spacing);
+        for (int i = 0; i < 4; i++) {
+            chunk.points[n].speeds[i] = float(speeds[i]);
+        }
+    }
+    return Protocol::encodeTrajectory(chunk, buffer);
+}
+
+/**
+ * @brief Writes the serialized setpoints of the robots from first on, into the shared memory
+ * ring when that transport is selected, with one sendmmsg call where available and one
+ * writeDatagram per robot otherwise. Robots whose host is not resolved
+ * yet are skipped, which takes the per robot path. Every refused datagram is counted by cause.
+ * A full send buffer leaves the remaining robots to retryMovementData, which runs once the
+ * socket is writable again. Other failures only lose the one datagram. The packet counts as
+ * sent with the first datagram that was written.
+ * @param First robot to write.
+ */
+void CommunicationHandler::writeMovementData(int first)
+{
+    int count = robots.size();
+    unsentRobot = count;
+    if (sharedLink.isOpen()) {
+        for (int i = first; i < count; i++) {
+            if (sharedLink.send(batchSender.buffer(i), batchSender.size(i))) {
+                movementWritten();
+            } else {
+                // The simulator fell a whole ring behind, it gets the next tick's setpoint
+                TRACE(TraceConstants::SEND, TraceConstants::SEND_FAILED, i, 0, -1);
+                linkStats.sendBlocked++;
+                movementSent = false;
+            }
+        }
+        return;
+    }
+    if (BatchSender::isSupported() && commSocket->state() == QUdpSocket::BoundState
+        && unresolvedRobots == 0) {
+        int next = first;
+        while (next < count) {
+            int sent = std::max(batchSender.send(count, next), 0);
+            if (sent > 0) {
+                movementWritten();
+            }
+            next += sent;
+            if (next == count) {
+                break;
+            }
+            if (sent > 0) {
+                linkStats.sendPartial++;
+            }
+            TRACE(TraceConstants::SEND, TraceConstants::SEND_FAILED, next, batchSender.error(), -1);
+            if (batchSender.isBlocked() && writeNotifier) {
+                linkStats.sendBlocked += count - next;
+                unsentRobot = next;
+                sendBlocked = true;
+                writeNotifier->setEnabled(true);
+                return;
+            }
+            if (batchSender.isBlocked()) {
+                linkStats.sendBlocked++;
+            } else if (batchSender.isUnreachable()) {
+                linkStats.sendUnreachable++;
+            } else {
+                linkStats.sendErrors++;
+            }
+            movementSent = false; // Not suppressed on the next tick, it has to go out again
+            next++;
+        }
+        return;
+    }
+    for (int i = first; i < count; i++) {
+        if (robots[i].endpoint.address.isNull()) {
+            continue;
+        }
+        qint64 written = commSocket->writeDatagram(batchSender.buffer(i),
+                                                   batchSender.size(i),
+                                                   robots[i].endpoint.address,
+                                                   robots[i].endpoint.port);
+        if (written == batchSender.size(i)) {
+            movementWritten();
+            continue;
+        }
+        TRACE(TraceConstants::SEND, TraceConstants::SEND_FAILED, i, commSocket->error(), written);
+        if (written >= 0) {
+            linkStats.sendPartial++;
+        } else if (commSocket->error() == QAbstractSocket::TemporaryError) {
+            // Qt has no writable signal for UDP, the next tick sends the newest setpoint
+            linkStats.sendBlocked++;
+        } else {
+            // Qt does not tell unreachable destinations apart from other send errors
+            linkStats.sendErrors++;
+        }
+        movementSent = false;
+    }
+}
+
+/**
+ * @brief Sends the newest setpoint to the robots it did not reach once the socket that
+ * refused it is writable again. Setpoints that arrived meanwhile replaced the refused one.
+ */
+void CommunicationHandler::retryMovementData()
+{
+    writeNotifier->setEnabled(false);
+    sendBlocked = false;
+    linkStats.sendRetries++;
+    writeMovementData(unsentRobot);
+}
+
+/**
+ * @brief Gets the current server time used for packet timestamps.
+ * @return Monotonic time in microseconds since the handler was created.
+ */
+quint64 CommunicationHandler::timestamp()
+{
+    return quint64(clock.nsecsElapsed() / 1000);
 }
 
 void CommunicationHandler::initSocket()
 {
-    commSocket = new QUdpSocket();
+    commSocket = new QUdpSocket(this); // Parented so it follows the handler to its thread
     connect(commSocket, &QUdpSocket::readyRead, this, &CommunicationHandler::readPendingDatagrams);
 }
 
-void CommunicationHandler::initTimer()
+void CommunicationHandler::initSendTimer()
 {
-    timeoutTimer = new QTimer(this);
-    connect(timeoutTimer, &QTimer::timeout, this, [this]() {
-        emit connectionStatus(false);
-        qDebug() << "timedout";
+    sendTimer = new QTimer(this);
+    sendTimer->setTimerType(Qt::PreciseTimer);
+    connect(sendTimer, &QTimer::timeout, this, &CommunicationHandler::sendMovementData);
+}
+
+void CommunicationHandler::initStatsTimer()
+{
+    // Statistics are published at a fixed rate instead of per heartbeat to keep UI updates cheap
+    statsTimer = new QTimer(this);
+    connect(statsTimer, &QTimer::timeout, this, [this]() {
+        // Quantization error covers the speeds sent since the last update
+        linkStats.quantizationBits = 0;
+        for (const Robot &robot : qAsConst(robots)) {
+            if (robot.format == ProtocolConstants::QUANTIZED_FORMAT) {
+                linkStats.quantizationBits = quantizationBits;
+            }
+        }
+        if (quantizationCount > 0) {
+            linkStats.quantizationRms = std::sqrt(quantizationSquares / quantizationCount);
+            linkStats.quantizationMax = quantizationPeak;
+        }
+        quantizationSquares = 0.0;
+        quantizationPeak = 0.0;
+        quantizationCount = 0;
+        emit linkStatisticsChanged(linkStats);
     });
-    timeoutTimer->setSingleShot(true);
+}
+
+void CommunicationHandler::initDiscoveryTimer()
+{
+    discoveryTimer = new QTimer(this);
+    connect(discoveryTimer, &QTimer::timeout, this, &CommunicationHandler::sendAnnounce);
+}
+
+void CommunicationHandler::initSyncTimer()
+{
+    syncTimer = new QTimer(this);
+    connect(syncTimer, &QTimer::timeout, this, &CommunicationHandler::sendTimeSync);
+}
+
+void CommunicationHandler::initHelloTimer()
+{
+    helloTimer = new QTimer(this);
+    connect(helloTimer, &QTimer::timeout, this, &CommunicationHandler::sendHello);
+}
+
+void CommunicationHandler::initResolver()
+{
+    // Lookups finish on resolver threads and are delivered here, they never block a send
+    resolver = new HostResolver(this);
+    connect(resolver, &HostResolver::resolved, this, &CommunicationHandler::hostResolved);
+    connect(resolver, &HostResolver::failed, this, &CommunicationHandler::hostFailed);
 }
 
 void CommunicationHandler::refreshConnection()
 {
-    timeoutTimer->stop();
     emit connectionStatus(false);
     updateWithSettings(); //Closes and rebinds to currently saved settings
 }
 
+/**
+ * @brief Drains all pending datagrams, batched through recvmmsg where available.
+ */
 void CommunicationHandler::readPendingDatagrams()
+{
+    if (batchReceive) {
+        readBatchedDatagrams();
+    } else {
+        readQtDatagrams();
+    }
+}
+
+/**
+ * @brief Reads datagrams a full batch per system call straight into the receive slab, no
+ * QNetworkDatagram is allocated for them.
+ */
+void CommunicationHandler::readBatchedDatagrams()
+{
+    int received;
+    do {
+        received = batchReceiver.receive(commSocket->socketDescriptor());
+        for (int i = 0; i < received; i++) {
+            processDatagrams(batchReceiver.datagram(i));
+        }
+    } while (received == batchReceiver.batchSize());
+
+    // QUdpSocket only re-arms its read notifier from its own read calls, so finish with one.
+    // It either picks up a datagram that arrived after the last batch or finds nothing.
+    char *buffer = const_cast<char *>(batchReceiver.datagram(0).data);
+    DatagramView view;
+    view.data = buffer;
+    view.size = commSocket->readDatagram(buffer,
+                                         ProtocolConstants::MAX_PACKET_SIZE,
+                                         &view.senderAddress,
+                                         &view.senderPort);
+    if (view.size >= 0) {
+        processDatagrams(view);
+    }
+}
+
+/**
+ * @brief Portable receive path, one QNetworkDatagram per packet.
+ */
+void CommunicationHandler::readQtDatagrams()
 {
     while (commSocket->hasPendingDatagrams()) {
         QNetworkDatagram datagram = commSocket->receiveDatagram();
-        processDatagrams(datagram);
+        const QByteArray data = datagram.data(); // Keeps the payload alive for the view
+
+        DatagramView view;
+        view.data = data.constData();
+        view.size = data.size();
+        view.senderAddress = datagram.senderAddress();
+        view.senderPort = quint16(datagram.senderPort());
+        processDatagrams(view);
     }
 }
 
-void CommunicationHandler::processDatagrams(QNetworkDatagram datagram)
+/**
+ * @brief Dispatches a received datagram by packet type.
+ * @param View of the datagram, only valid for the duration of this call.
+ */
+void CommunicationHandler::processDatagrams(const DatagramView &datagram)
 {
-    // TODO Implement switch for incoming gyro etc.
-    lastConnectedPort = datagram.senderPort();
-    if (datagram.data() == "") {
-        emit connectionStatus(true);
-        timeoutTimer->start(500);
+    TRACE(TraceConstants::RECEIVE,
+          TraceConstants::DATAGRAM,
+          datagram.senderAddress.toIPv4Address(),
+          datagram.senderPort,
+          datagram.size);
+    if (Protocol::isBinary(datagram.data, datagram.size)) {
+        unsigned char type = Protocol::packetType(datagram.data);
+        if (type == ProtocolConstants::ANNOUNCE_REPLY) {
+            processAnnounceReply(datagram); // May come from an address not known yet
+            return;
+        }
+        if (type == ProtocolConstants::ANNOUNCE) {
+            return; // Our own broadcast looped back
+        }
+    }
+
+    int robot = findRobot(datagram);
+    if (robot < 0) {
+        return; // Not part of the fleet
+    }
+    if (datagram.size == 0) {
+        heartbeatReceived(robot); // Legacy heartbeat, carries no statistics
+    } else if (Protocol::isBinary(datagram.data, datagram.size)) {
+        switch (Protocol::packetType(datagram.data)) {
+        case ProtocolConstants::HEARTBEAT: {
+            HeartbeatPacket heartbeat;
+            if (Protocol::decodeHeartbeat(datagram.data, datagram.size, heartbeat)) {
+                if (robots[robot].format == ProtocolConstants::QUANTIZED_FORMAT) {
+                    // Quantized packets only carry the low 8 bits of the sequence
+                    quint8 low = quint8(heartbeat.echoSequence);
+                    heartbeat.echoSequence = Protocol::expandSequence(low, sequence - 1);
+                }
+                heartbeatReceived(robot);
+                // Link statistics follow the first robot, the others share its sequences
+                if (robot == 0) {
+                    processHeartbeat(heartbeat);
+                }
+                processEchoTime(heartbeat, robot);
+            }
+            break;
+        }
+        case ProtocolConstants::TIME_REPLY:
+            processTimeReply(datagram, robot);
+            break;
+        case ProtocolConstants::HELLO:
+        case ProtocolConstants::HELLO_ACK:
+            processHello(datagram, robot);
+            break;
+        case ProtocolConstants::IMU:
+        case ProtocolConstants::ENCODER:
+        case ProtocolConstants::BATTERY:
+            processTelemetry(datagram, robot);
+            break;
+        }
+    } else {
+        TRACE(TraceConstants::RECEIVE,
+              TraceConstants::TEXT_DATAGRAM,
+              robot,
+              datagram.size,
+              Trace::packBytes(datagram.data, datagram.size));
+    }
+}
+
+/**
+ * @brief Decodes a telemetry packet straight from the receive buffer into the telemetry ring.
+ * @param Datagram holding an IMU, encoder or battery packet.
+ * @param Fleet index of the sender.
+ */
+void CommunicationHandler::processTelemetry(const DatagramView &datagram, int robot)
+{
+    if (!Protocol::isTelemetry(datagram.data, datagram.size)) {
+        return; // Truncated
+    }
+    TelemetrySample &sample = telemetry->beginWrite();
+    Protocol::decodeTelemetry(datagram.data, sample);
+    sample.robot = (unsigned char) robot;
+    sample.receiveTime = LatencyTracker::now();
+    sample.sendTime = 0;
+    const ClockSync &sync = robots[robot].sync;
+    if (sync.isSynchronized()) {
+        qint64 transit = std::max(qint64(timestamp()) - sync.toServer(sample.robotTime),
+                                  qint64(0));
+        sample.sendTime = sample.receiveTime - transit * 1000;
+        latency->record(LatencyConstants::ROBOT_TO_RECEIVE, transit * 1000);
+    }
+    telemetry->commitWrite();
+}
+
+/**
+ * @brief Finds the robot a datagram came from. With a single client every datagram belongs to
+ * it and replies go to the port it sent from. In fleet mode an exact address and port match
+ * wins, otherwise the first robot with the same address is used.
+ * @param Received datagram.
+ * @return Robot index or -1 if the sender is not part of the fleet.
+ */
+int CommunicationHandler::findRobot(const DatagramView &datagram)
+{
+    if (!fleetMode) {
+        if (!robots.isEmpty() && !(lastConnectedPort == datagram.senderPort)) {
+            lastConnectedPort = datagram.senderPort;
+            robots[0].endpoint.port = datagram.senderPort;
+            startNegotiation(0);
+        }
+        return robots.isEmpty() ? -1 : 0;
+    }
+
+    int match = -1;
+    for (int i = 0; i < robots.size(); i++) {
+        if (robots[i].endpoint.address.isEqual(datagram.senderAddress,
+                                               QHostAddress::TolerantConversion)) {
+            if (robots[i].endpoint.port == datagram.senderPort) {
+                return i;
+            }
+            if (match < 0) {
+                match = i;
+            }
+        }
+    }
+    return match;
+}
+
+/**
+ * @brief Feeds a heartbeat to the robot's link estimate, marks the link as good and arms the
+ * timer for when it would turn degraded.
+ * @param Robot index.
+ */
+void CommunicationHandler::heartbeatReceived(int robot)
+{
+    Robot &entry = robots[robot];
+    entry.link.heartbeat(timestamp());
+    if (robot == 0) {
+        linkStats.heartbeatInterval = entry.link.mean();
+        linkStats.heartbeatJitter = entry.link.jitter();
+        linkStats.linkTimeout = entry.link.lostTimeout();
+    }
+    setLinkState(robot, LinkConstants::GOOD);
+    entry.timeoutTimer->start(entry.link.degradedTimeout());
+}
+
+/**
+ * @brief Re-evaluates a robot's link once its timeout timer fired.
+ * @param Robot index.
+ */
+void CommunicationHandler::checkLink(int robot)
+{
+    Robot &entry = robots[robot];
+    quint64 now = timestamp();
+    int state = entry.link.state(now);
+    if (state == LinkConstants::DEGRADED) {
+        entry.timeoutTimer->start(std::max(entry.link.lostTimeout() - entry.link.silence(now), 1));
+    }
+    setLinkState(robot, state);
+}
+
+/**
+ * @brief Updates a robot's link state and applies the stop policy. A robot is stopped once
+ * its link is at least as bad as the policy state, and only if it was ever heard from so
+ * robots without heartbeats are still driven.
+ * @param Robot index.
+ * @param State from LinkConstants.
+ */
+void CommunicationHandler::setLinkState(int robot, int state)
+{
+    Robot &entry = robots[robot];
+    if (entry.linkState == state) {
+        return;
+    }
+    int previous = entry.linkState;
+    entry.linkState = state;
+    if (robot == 0) {
+        linkStats.linkState = state;
+    }
+    if (state == LinkConstants::DEGRADED
+        || (state == LinkConstants::GOOD && previous == LinkConstants::DEGRADED)) {
+        logger->write(state == LinkConstants::GOOD ? LoggerConstants::INFO
+                                                   : LoggerConstants::WARNING,
+                      QString("Link to ") + entry.endpoint.toString()
+                          + (state == LinkConstants::GOOD ? " recovered" : " degraded"));
+    }
+
+    if (state == LinkConstants::LOST && !entry.endpoint.host.isEmpty()) {
+        // The name may point to a new address by now, e.g. after a DHCP renewal
+        resolver->refresh(entry.endpoint.host);
+    }
+
+    bool stopped = stopPolicy > 0 && state >= stopPolicy && entry.link.isMeasured();
+    if (!(entry.stopped == stopped)) {
+        entry.stopped = stopped;
+        if (stopped) {
+            linkStats.linkStops++;
+            logger->write(LoggerConstants::WARNING,
+                          QString("Stopping ") + entry.endpoint.toString()
+                              + " until the link recovers");
+            sendStop(quint32(1) << robot);
+        } else {
+            // Bypass change suppression so the resumed setpoint goes out right away
+            movementSent = false;
+            sendMovementData();
+        }
+    }
+
+    setRobotConnected(robot, !(state == LinkConstants::LOST));
+}
+
+/**
+ * @brief Updates a robot's connection status and publishes the fleet status when it changes.
+ * @param Robot index.
+ * @param New status.
+ */
+void CommunicationHandler::setRobotConnected(int robot, bool connected)
+{
+    if (robots[robot].connected == connected) {
+        return;
+    }
+    robots[robot].connected = connected;
+    if (!connected && !fleetMode) {
+        startDiscovery(); // The robot may have moved to another network
+    }
+
+    if (fleetMode) {
+        logger->write(connected ? LoggerConstants::INFO : LoggerConstants::WARNING,
+                      QString("Robot ") + QString::number(robot + 1) + " ("
+                          + robots[robot].endpoint.toString() + ")"
+                          + (connected ? " connected" : " timed out"));
+    }
+
+    int connectedCount = 0;
+    for (const Robot &entry : qAsConst(robots)) {
+        connectedCount += entry.connected ? 1 : 0;
+    }
+    emit connectionStatus(connectedCount > 0);
+    emit fleetStatus(connectedCount, robots.size());
+}
+
+/**
+ * @brief Rebuilds the robot list from the current settings. An empty fleet setting drives the
+ * single client address and port, as before fleet mode existed.
+ * @param Fleet setting text.
+ */
+void CommunicationHandler::configureRobots(const QString &fleetText)
+{
+    for (int i = 0; i < robots.size(); i++) {
+        delete robots[i].timeoutTimer;
+        closeControl(i);
+    }
+    robots.clear();
+
+    QVector<RobotEndpoint> endpoints;
+    QString error;
+    if (!Fleet::parse(fleetText, endpoints, error)) {
+        logger->write(LoggerConstants::WARNING,
+                      QString("Ignoring fleet setting: ") + error + ".");
+        endpoints.clear();
+    }
+    fleetMode = !endpoints.isEmpty();
+    if (!fleetMode) {
+        RobotEndpoint single;
+        single.host = sendHost;
+        single.address = sendAddress;
+        single.port = quint16(lastConnectedPort);
+        single.gain = 1.0;
+        single.offset = 0.0;
+        endpoints.append(single);
+    }
+
+    for (int i = 0; i < endpoints.size(); i++) {
+        Robot robot;
+        robot.endpoint = endpoints[i];
+        robot.linkState = LinkConstants::LOST;
+        robot.stopped = false;
+        robot.connected = false;
+        robot.lastEchoReceiveTime = 0;
+        robot.format = packetFormat;
+        robot.version = 0;
+        robot.capabilities = 0;
+        robot.helloAttempts = 0;
+        robot.negotiated = false;
+        robot.resolveFailed = false;
+        robot.control = nullptr;
+        if (!robot.endpoint.host.isEmpty()) {
+            // Cached names are used right away, the rest are sent to once hostResolved ran
+            resolver->lookup(robot.endpoint.host, robot.endpoint.address);
+        }
+        robot.timeoutTimer = new QTimer(this);
+        robot.timeoutTimer->setSingleShot(true);
+        connect(robot.timeoutTimer, &QTimer::timeout, this, [this, i]() { checkLink(i); });
+        robots.append(robot);
+    }
+    for (int i = 0; i < robots.size(); i++) {
+        robots[i].format = selectFormat(i);
+    }
+    countUnresolved();
+    attachSocket();
+    emit fleetStatus(0, robots.size());
+}
+
+/**
+ * @brief Updates round trip time, loss and reordering statistics from a heartbeat that echoes
+ * the last movement sequence the client received.
+ *
+ * Heartbeats are periodic, so the client keeps echoing the same sequence until a newer packet
+ * arrives. Only the first echo of a sequence is a round trip sample, and the time the client
+ * held the packet before answering is taken off when the heartbeat carries it.
+ * @param Decoded heartbeat.
+ */
+void CommunicationHandler::processHeartbeat(const HeartbeatPacket &heartbeat)
+{
+    quint64 now = timestamp();
+    linkStats.heartbeatsReceived++;
+
+    bool advanced = !echoReceived || qint32(heartbeat.echoSequence - lastEchoSequence) > 0;
+    // Only sequences still in the send history can be matched to a send time
+    quint32 age = sequence - heartbeat.echoSequence;
+    if (advanced && age >= 1 && age <= quint32(ProtocolConstants::SEND_HISTORY)) {
+        int slot = heartbeat.echoSequence & (ProtocolConstants::SEND_HISTORY - 1);
+        qint64 elapsed = qint64(now - sentTimestamps[slot]);
+        if (heartbeat.echoReceiveTime > 0 && heartbeat.transmitTime >= heartbeat.echoReceiveTime) {
+            // Hold time on the client clock, older clients do not send it
+            elapsed -= qint64(heartbeat.transmitTime - heartbeat.echoReceiveTime);
+        }
+        elapsed = std::max(elapsed, qint64(0));
+        double rtt = elapsed / 1000.0;
+        if (linkStats.rttSmoothed == 0.0) {
+            linkStats.rttSmoothed = rtt;
+            linkStats.rttMin = rtt;
+            linkStats.rttMax = rtt;
+        } else {
+            linkStats.rttSmoothed += (rtt - linkStats.rttSmoothed) / 8.0;
+            linkStats.rttMin = std::min(linkStats.rttMin, rtt);
+            linkStats.rttMax = std::max(linkStats.rttMax, rtt);
+        }
+        linkStats.rttLast = rtt;
+        latency->record(LatencyConstants::SEND_TO_ACK, elapsed * 1000);
+    }
+
+    if (echoReceived) {
+        qint32 sentDelta = qint32(heartbeat.echoSequence - lastEchoSequence);
+        if (sentDelta < 0) {
+            // Echo went backwards, the client saw packets out of order
+            linkStats.reordered++;
+            return;
+        }
+        if (sentDelta > 0) {
+            quint32 receivedDelta = heartbeat.receivedCount - lastReceivedCount;
+            double lost = sentDelta - std::min(receivedDelta, quint32(sentDelta));
+            linkStats.lossPercent += ((lost / sentDelta * 100.0) - linkStats.lossPercent) / 8.0;
+        }
+    }
+    echoReceived = true;
+    lastEchoSequence = heartbeat.echoSequence;
+    lastReceivedCount = heartbeat.receivedCount;
+}
+
+/**
+ * @brief Clears all link statistics, done whenever the link is rebound.
+ */
+void CommunicationHandler::resetStatistics()
+{
+    linkStats = LinkStatistics();
+    echoReceived = false;
+    quantizationSquares = 0.0;
+    quantizationPeak = 0.0;
+    quantizationCount = 0;
+    lastEchoSequence = 0;
+    lastReceivedCount = 0;
+    for (int i = 0; i < ProtocolConstants::SEND_HISTORY; i++) {
+        sentTimestamps[i] = 0;
     }
-    qDebug() << "R" << datagram.senderAddress() << datagram.senderPort() << "->" << datagram.data();
 }
 
 void CommunicationHandler::updateWithSettings()
 {
     enabled = settings->value(SettingsConstants::CONN_COMM_EN, SettingsConstants::D_CONN_COMM_EN)
                   .toBool();
+    packetFormat = settings
+                       ->value(SettingsConstants::CONN_COMM_FORMAT,
+                               SettingsConstants::D_CONN_COMM_FORMAT)
+                       .toInt();
+    int rateIndex = std::clamp(settings
+                                   ->value(SettingsConstants::CONN_COMM_RATE,
+                                           SettingsConstants::D_CONN_COMM_RATE)
+                                   .toInt(),
+                               0,
+                               ProtocolConstants::SEND_RATES_COUNT - 1);
+    sendRate = ProtocolConstants::SEND_RATES[rateIndex];
+
+    // Not exposed in the UI, a batch size of 0 in the settings file selects the Qt path
+    int batchSize = settings
+                        ->value(SettingsConstants::CONN_COMM_BATCH,
+                                SettingsConstants::D_CONN_COMM_BATCH)
+                        .toInt();
+    batchReceive = BatchReceiver::isSupported() && batchSize > 0;
+    batchReceiver.setBatchSize(batchSize);
+
+    int suppressIndex = std::clamp(settings
+                                       ->value(SettingsConstants::CONN_COMM_SUPPRESS,
+                                               SettingsConstants::D_CONN_COMM_SUPPRESS)
+                                       .toInt(),
+                                   0,
+                                   ProtocolConstants::SUPPRESS_EPSILONS_COUNT - 1);
+    suppressEpsilon = ProtocolConstants::SUPPRESS_EPSILONS[suppressIndex];
+    // Not exposed in the UI, has to stay below the robot's own command timeout
+    keepaliveInterval = std::max(settings
+                                     ->value(SettingsConstants::CONN_COMM_KEEPALIVE,
+                                             SettingsConstants::D_CONN_COMM_KEEPALIVE)
+                                     .toInt(),
+                                 1);
+    stopPolicy = std::clamp(settings
+                                ->value(SettingsConstants::CONN_COMM_STOP,
+                                        SettingsConstants::D_CONN_COMM_STOP)
+                                .toInt(),
+                            0,
+                            LinkConstants::LOST);
+    int horizonIndex = std::clamp(settings
+                                      ->value(SettingsConstants::CONN_COMM_HORIZON,
+                                              SettingsConstants::D_CONN_COMM_HORIZON)
+                                      .toInt(),
+                                  0,
+                                  ProtocolConstants::TRAJECTORY_HORIZONS_COUNT - 1);
+    horizonPoints = ProtocolConstants::TRAJECTORY_HORIZONS[horizonIndex];
+    int quantizationIndex = std::clamp(settings
+                                           ->value(SettingsConstants::CONN_COMM_QUANTIZATION,
+                                                   SettingsConstants::D_CONN_COMM_QUANTIZATION)
+                                           .toInt(),
+                                       0,
+                                       ProtocolConstants::QUANTIZATION_BITS_COUNT - 1);
+    quantizationBits = ProtocolConstants::QUANTIZATION_BITS[quantizationIndex];
+    // Not exposed in the UI, robots only get a control channel if they announce one
+    controlPort = std::min(settings
+                               ->value(SettingsConstants::CONN_COMM_CONTROL_PORT,
+                                       SettingsConstants::D_CONN_COMM_CONTROL_PORT)
+                               .toInt(),
+                           0xFFFF);
+    driveModel = std::clamp(settings
+                                ->value(SettingsConstants::CONN_COMM_DRIVE,
+                                        SettingsConstants::D_CONN_COMM_DRIVE)
+                                .toInt(),
+                            0,
+                            DriveConstants::MODEL_COUNT - 1);
+    predictor.reset();
+    trajectorySteady = true;
+    movementSent = false;
 
     //Update sending address and port
     lastConnectedPort = settings
                             ->value(SettingsConstants::CONN_COMM_PORT,
                                     SettingsConstants::D_CONN_COMM_PORT)
                             .toInt();
-    sendAddress = QHostAddress(
-        settings->value(SettingsConstants::CONN_COMM_ADDRESS, SettingsConstants::D_CONN_COMM_ADDRESS)
-            .toString());
+    listenPort = quint16(lastConnectedPort);
+    QString addressText = settings
+                              ->value(SettingsConstants::CONN_COMM_ADDRESS,
+                                      SettingsConstants::D_CONN_COMM_ADDRESS)
+                              .toString()
+                              .trimmed();
+    sendHost.clear();
+    sharedName.clear();
+    if (SharedMemoryLink::isSharedMemoryAddress(addressText)) {
+        // Stands in for the simulator's address, every datagram goes through the segment
+        sendAddress = QHostAddress::LocalHost;
+        sharedName = SharedMemoryLink::nameFromAddress(addressText);
+        if (sharedName.isEmpty()) {
+            logger->write(LoggerConstants::WARNING,
+                          QString("Invalid shared memory address \"") + addressText + "\"");
+        }
+    } else if (!sendAddress.setAddress(addressText)) {
+        if (Fleet::isHostName(addressText)) {
+            sendHost = addressText;
+        } else {
+            logger->write(LoggerConstants::WARNING,
+                          QString("Invalid client address \"") + addressText + "\"");
+        }
+    }
+
+    // Empty listens on every IPv4 interface, loopback included for local test clients
+    QString bindText = settings
+                           ->value(SettingsConstants::CONN_COMM_BIND,
+                                   SettingsConstants::D_CONN_COMM_BIND)
+                           .toString();
+    bindAddress = QHostAddress(QHostAddress::AnyIPv4);
+    if (!bindText.isEmpty() && !bindAddress.setAddress(bindText)) {
+        logger->write(LoggerConstants::WARNING,
+                      QString("Invalid bind address ") + bindText
+                          + ", listening on all interfaces instead.");
+        bindAddress = QHostAddress(QHostAddress::AnyIPv4);
+    }
+    discovery = settings
+                    ->value(SettingsConstants::CONN_COMM_DISCOVERY,
+                            SettingsConstants::D_CONN_COMM_DISCOVERY)
+                    .toBool();
 
     // Make sure closed before rebinding.
+    sendTimer->stop();
+    discoveryTimer->stop();
+    syncTimer->stop();
+    helloTimer->stop();
+    discovering = false;
+    statsTimer->stop();
+    resetStatistics();
+    emit linkStatisticsChanged(linkStats);
+    stopSender.setSocket(-1);
+    releaseWriteNotifier();
+    sharedLink.close();
     if (!(commSocket->state() == QUdpSocket::UnconnectedState)) {
         commSocket->close();
     }
     //Bind to local ip to see if any data is being sent over.
+    bool shared = enabled && !sharedName.isEmpty() && openSharedMemory();
+    if (enabled && sharedName.isEmpty()) {
+        bindSocket(bindAddress);
+    }
+
+    // Destinations depend on the bound socket, so robots are set up after binding. A shared
+    // memory segment connects exactly one simulator, so the fleet is ignored then.
+    QString fleetText = settings
+                            ->value(SettingsConstants::CONN_COMM_FLEET,
+                                    SettingsConstants::D_CONN_COMM_FLEET)
+                            .toString();
+    configureRobots(sharedName.isEmpty() ? fleetText : QString());
+
     if (enabled) {
-        // TODO: FIX THIS TO BE MORE DYNAMIC
-        // Just assume first address is what we are looking for.
-        QHostAddress recvaddress = QHostAddress(QHostAddress::LocalHost);
-        const QHostAddress &localhost = QHostAddress(QHostAddress::LocalHost);
-        for (auto &address : QNetworkInterface::allAddresses()) {
-            if (address.protocol() == QAbstractSocket::IPv4Protocol && address != localhost) {
-                qDebug() << address.toString();
-                recvaddress = address;
-                break; // Will break after the first IPv4 found.
-            }
+        for (const Robot &robot : qAsConst(robots)) {
+            QString destination = shared ? SharedMemoryConstants::SCHEME + sharedName
+                                         : robot.endpoint.toString();
+            logger->write(LoggerConstants::INFO,
+                          QString("Communication sending on: ") + destination
+                              + QString(" at ") + QString::number(sendRate) + QString(" Hz"));
         }
+        sendTimer->start(1000 / sendRate);
+        statsTimer->start(250);
+        syncTimer->start(ClockConstants::SYNC_FAST_INTERVAL);
+        helloTimer->start(ProtocolConstants::HELLO_INTERVAL);
+        sendHello();
+        startDiscovery();
+    }
+}
 
-        if (recvaddress == localhost) {
-            logger->write(LoggerConstants::WARNING,
-                          "Could not find other IPv4 Addresses! Using Local Host instead.");
+/**
+ * @brief Binds the communication socket, closing it first if it is open, and points the batch
+ * and stop senders at the new socket.
+ * @param Local address to listen on, the port is the configured one.
+ * @return True if the socket is bound, otherwise false.
+ */
+bool CommunicationHandler::bindSocket(const QHostAddress &address)
+{
+    stopSender.setSocket(-1);
+    releaseWriteNotifier();
+    if (!(commSocket->state() == QUdpSocket::UnconnectedState)) {
+        commSocket->close();
+    }
+    if (!commSocket->bind(address, listenPort)) {
+        logger->write(LoggerConstants::WARNING,
+                      QString("Communication failed to bind to: ") + address.toString()
+                          + QString(":") + QString::number(listenPort) + ": "
+                          + commSocket->errorString() + ".");
+        return false;
+    }
+    logger->write(LoggerConstants::INFO,
+                  QString("Communication listening on: ") + address.toString() + QString(":")
+                      + QString::number(listenPort));
+    attachSocket();
+    return true;
+}
+
+/**
+ * @brief Creates the shared memory segment named by the client address and starts waiting for
+ * datagrams from the simulator. The UDP socket stays closed meanwhile.
+ * @return True if the segment is open, otherwise false.
+ */
+bool CommunicationHandler::openSharedMemory()
+{
+    QString address = SharedMemoryConstants::SCHEME + sharedName;
+    if (!sharedLink.create(sharedName)) {
+        logger->write(LoggerConstants::WARNING,
+                      QString("Communication failed to open ") + address + ": "
+                          + sharedLink.errorString() + ".");
+        return false;
+    }
+    // The waiter thread only queues the read, datagrams are processed on this thread
+    sharedLink.startWaiting([this]() {
+        QMetaObject::invokeMethod(this, [this]() { readSharedMemory(); }, Qt::QueuedConnection);
+    });
+    logger->write(LoggerConstants::INFO, QString("Communication listening on: ") + address);
+    return true;
+}
+
+/**
+ * @brief Processes every datagram the simulator queued in the shared memory segment, in place.
+ * They all come from the single robot.
+ */
+void CommunicationHandler::readSharedMemory()
+{
+    DatagramView view;
+    if (!robots.isEmpty()) {
+        view.senderAddress = robots[0].endpoint.address;
+        view.senderPort = robots[0].endpoint.port;
+    } else {
+        view.senderPort = 0;
+    }
+    while (sharedLink.receive(view.data, view.size)) {
+        processDatagrams(view);
+        sharedLink.release();
+    }
+    sharedLink.receiveFinished();
+}
+
+/**
+ * @brief Writes one datagram to a robot, through the shared memory segment when that transport
+ * is selected and through the UDP socket otherwise.
+ * @param Payload.
+ * @param Payload size in bytes.
+ * @param Robot address, not needed for shared memory.
+ * @param Robot port, not needed for shared memory.
+ */
+void CommunicationHandler::writeDatagram(const char *data,
+                                         int size,
+                                         const QHostAddress &address,
+                                         quint16 port)
+{
+    if (sharedLink.isOpen()) {
+        if (!sharedLink.send(data, size)) {
+            linkStats.sendBlocked++;
         }
+        return;
+    }
+    commSocket->writeDatagram(data, size, address, port);
+}
 
-        //if (commSocket->bind(QHostAddress::LocalHost, lastConnectedPort)) {
-        if (commSocket->bind(QHostAddress("192.168.1.140"), lastConnectedPort)) {
-            logger->write(LoggerConstants::INFO,
-                          QString("Communication listening on: ") + recvaddress.toString()
-                              + QString(":") + QString::number(lastConnectedPort));
-        } else {
+/**
+ * @brief Points the batch and stop senders at the current socket and all robots. Needed after
+ * every bind and whenever the robot list is rebuilt.
+ */
+void CommunicationHandler::attachSocket()
+{
+    attachWriteNotifier();
+    batchSender.setSocket(commSocket->socketDescriptor());
+    stopSender.setSocket(commSocket->socketDescriptor());
+    stopSender.setCount(robots.size());
+    for (int i = 0; i < robots.size(); i++) {
+        setRobotDestination(i);
+    }
+}
+
+/**
+ * @brief Sets up the notifier that tells when a full socket send buffer drained. Only the
+ * batch path learns about full buffers, so there is none elsewhere.
+ */
+void CommunicationHandler::attachWriteNotifier()
+{
+    releaseWriteNotifier();
+#ifdef Q_OS_LINUX
+    if (commSocket->socketDescriptor() == -1) {
+        return;
+    }
+    // QUdpSocket keeps its own write notifier on the descriptor and two notifiers of the same
+    // type on one descriptor clash, so this one watches a duplicate
+    writeDescriptor = ::dup(int(commSocket->socketDescriptor()));
+    if (writeDescriptor < 0) {
+        return;
+    }
+    writeNotifier = new QSocketNotifier(writeDescriptor, QSocketNotifier::Write, this);
+    writeNotifier->setEnabled(false);
+    // activated is overloaded with private signal arguments, the string form picks one
+    connect(writeNotifier, SIGNAL(activated(int)), this, SLOT(retryMovementData()));
+#endif
+}
+
+/**
+ * @brief Removes the write notifier, has to happen before the socket is closed.
+ */
+void CommunicationHandler::releaseWriteNotifier()
+{
+    sendBlocked = false;
+    if (writeNotifier) {
+        delete writeNotifier;
+        writeNotifier = nullptr;
+    }
+#ifdef Q_OS_LINUX
+    if (writeDescriptor >= 0) {
+        ::close(writeDescriptor);
+    }
+#endif
+    writeDescriptor = -1;
+}
+
+/**
+ * @brief Updates a robot's destination in the batch and stop senders after its endpoint or
+ * packet format changed.
+ * @param Robot index.
+ */
+void CommunicationHandler::setRobotDestination(int robot)
+{
+    const RobotEndpoint &endpoint = robots[robot].endpoint;
+    batchSender.setDestination(robot, endpoint.address, endpoint.port);
+    stopSender.setDestination(robot, endpoint.address, endpoint.port, robots[robot].format);
+}
+
+/**
+ * @brief Points every robot named by a host at the address it resolved to. A new address may
+ * be a different robot, so its clock and capabilities are learned again.
+ * @param Host name.
+ * @param Resolved address.
+ */
+void CommunicationHandler::hostResolved(const QString &host, const QHostAddress &address)
+{
+    for (int i = 0; i < robots.size(); i++) {
+        Robot &entry = robots[i];
+        if (!(entry.endpoint.host == host)) {
+            continue;
+        }
+        entry.endpoint.address = address;
+        entry.resolveFailed = false;
+        entry.sync.reset();
+        entry.lastEchoReceiveTime = 0;
+        if (!fleetMode) {
+            sendAddress = address;
+        }
+        logger->write(LoggerConstants::INFO,
+                      QString("Resolved ") + host + " to " + address.toString());
+        startNegotiation(i);
+    }
+    countUnresolved();
+}
+
+/**
+ * @brief Reports a host that could not be resolved, once until it resolves again. Robots
+ * that never had an address are retried after ResolverConstants::FAILURE_TTL, robots that did
+ * keep their last address.
+ * @param Host name.
+ * @param Resolver error.
+ */
+void CommunicationHandler::hostFailed(const QString &host, const QString &error)
+{
+    bool retry = false;
+    for (Robot &entry : robots) {
+        if (!(entry.endpoint.host == host)) {
+            continue;
+        }
+        if (!entry.resolveFailed) {
+            entry.resolveFailed = true;
             logger->write(LoggerConstants::WARNING,
-                          QString("Communication failed to bind to: ") + recvaddress.toString()
-                              + QString(":") + QString::number(lastConnectedPort) + ": "
-                              + commSocket->errorString() + ".");
+                          QString("Could not resolve ") + host + ": " + error);
+        }
+        retry = retry || entry.endpoint.address.isNull();
+    }
+    if (retry) {
+        QTimer::singleShot(ResolverConstants::FAILURE_TTL, this, [this, host]() {
+            for (const Robot &entry : qAsConst(robots)) {
+                if (entry.endpoint.host == host && entry.endpoint.address.isNull()) {
+                    resolver->refresh(host);
+                    return;
+                }
+            }
+        });
+    }
+}
+
+/**
+ * @brief Counts the robots that cannot be sent to yet because their host is not resolved.
+ */
+void CommunicationHandler::countUnresolved()
+{
+    unresolvedRobots = 0;
+    for (const Robot &robot : qAsConst(robots)) {
+        if (robot.endpoint.address.isNull()) {
+            unresolvedRobots++;
+        }
+    }
+}
+
+/**
+ * @brief Starts announcing the server on every interface until a robot answers. Only the
+ * single client is discovered, fleet robots are always addressed explicitly.
+ */
+void CommunicationHandler::startDiscovery()
+{
+    if (!discovery || !enabled || fleetMode || discovering || sharedLink.isOpen()) {
+        return;
+    }
+    discovering = true;
+    discoveryNonce = QRandomGenerator::global()->generate();
+    discoveryStart = timestamp();
+
+    // A previous lock may hold an address this host no longer has
+    if (!(commSocket->localAddress() == bindAddress)) {
+        bindSocket(bindAddress);
+    }
+    logger->write(LoggerConstants::INFO,
+                  QString("Searching for robots on port ")
+                      + QString::number(ProtocolConstants::DISCOVERY_PORT));
+    sendAnnounce();
+    discoveryTimer->start(ProtocolConstants::DISCOVERY_INTERVAL);
+}
+
+/**
+ * @brief Broadcasts one announce on every IPv4 interface that is up. Interfaces are listed
+ * again every round so links that come up while searching are covered too.
+ */
+void CommunicationHandler::sendAnnounce()
+{
+    if (timestamp() - discoveryStart
+        >= quint64(ProtocolConstants::DISCOVERY_FAST_PERIOD) * 1000) {
+        discoveryTimer->setInterval(ProtocolConstants::DISCOVERY_SLOW_INTERVAL);
+    }
+
+    AnnouncePacket packet;
+    packet.nonce = discoveryNonce;
+    char buffer[ProtocolConstants::ANNOUNCE_SIZE];
+    int size = Protocol::encodeAnnounce(ProtocolConstants::ANNOUNCE, packet, buffer);
+
+    for (const QNetworkInterface &networkInterface : QNetworkInterface::allInterfaces()) {
+        QNetworkInterface::InterfaceFlags flags = networkInterface.flags();
+        if (!(flags & QNetworkInterface::IsUp) || !(flags & QNetworkInterface::IsRunning)) {
+            continue;
+        }
+        for (const QNetworkAddressEntry &entry : networkInterface.addressEntries()) {
+            if (!(entry.ip().protocol() == QAbstractSocket::IPv4Protocol)) {
+                continue;
+            }
+            // Loopback cannot broadcast, a robot on this host is reached directly
+            QHostAddress target = (flags & QNetworkInterface::IsLoopBack) ? entry.ip()
+                                                                          : entry.broadcast();
+            if (!target.isNull()) {
+                commSocket->writeDatagram(buffer, size, target, ProtocolConstants::DISCOVERY_PORT);
+            }
         }
+    }
+}
+
+/**
+ * @brief Locks onto the robot that answered the current announce. The robot is driven at the
+ * address and port it answered from and, unless a bind address is configured, the socket is
+ * rebound to the interface the robot is reachable on.
+ * @param Datagram holding the reply.
+ */
+void CommunicationHandler::processAnnounceReply(const DatagramView &datagram)
+{
+    AnnouncePacket reply;
+    if (!discovering || robots.isEmpty()
+        || !Protocol::decodeAnnounce(datagram.data, datagram.size, reply)
+        || !(reply.nonce == discoveryNonce)) {
+        return; // Stale or not searching
+    }
+    discoveryTimer->stop();
+    discovering = false;
+
+    sendAddress = datagram.senderAddress;
+    sendHost.clear();
+    lastConnectedPort = datagram.senderPort;
+    robots[0].endpoint.host.clear();
+    robots[0].endpoint.address = datagram.senderAddress;
+    robots[0].endpoint.port = datagram.senderPort;
+    robots[0].sync.reset();
+    robots[0].lastEchoReceiveTime = 0;
+    syncTimer->setInterval(ClockConstants::SYNC_FAST_INTERVAL);
+    countUnresolved();
+    startNegotiation(0);
+
+    QString interfaceName = "unknown interface";
+    QHostAddress localAddress;
+    for (const QNetworkInterface &networkInterface : QNetworkInterface::allInterfaces()) {
+        for (const QNetworkAddressEntry &entry : networkInterface.addressEntries()) {
+            if (entry.ip().protocol() == QAbstractSocket::IPv4Protocol
+                && datagram.senderAddress.isInSubnet(entry.ip(), entry.prefixLength())) {
+                localAddress = entry.ip();
+                interfaceName = networkInterface.humanReadableName();
+            }
+        }
+    }
+
+    logger->write(LoggerConstants::INFO,
+                  QString("Discovered robot at ") + robots[0].endpoint.toString() + " on "
+                      + interfaceName + " after "
+                      + QString::number((timestamp() - discoveryStart) / 1000) + " ms");
+    if (bindAddress == QHostAddress(QHostAddress::AnyIPv4) && !localAddress.isNull()) {
+        bindSocket(localAddress);
+    }
+    heartbeatReceived(0);
+}
+
+/**
+ * @brief Sends a time sync request to every robot that announced support for it in the
+ * handshake. Requests go out fast until the clock filter of every such robot is full, then at
+ * the slow interval.
+ */
+void CommunicationHandler::sendTimeSync()
+{
+    bool filled = true;
+    for (int i = 0; i < robots.size(); i++) {
+        if (!(robots[i].capabilities & ProtocolConstants::CAP_TIME_SYNC)) {
+            continue;
+        }
+        TimeSyncPacket packet;
+        packet.id = syncId++;
+        packet.originate = timestamp();
+        char buffer[ProtocolConstants::TIME_REQUEST_SIZE];
+        int size = Protocol::encodeTimeSync(ProtocolConstants::TIME_REQUEST, packet, buffer);
+        writeDatagram(buffer, size, robots[i].endpoint.address, robots[i].endpoint.port);
+        filled = filled && robots[i].sync.sampleCount() >= ClockConstants::SYNC_FAST_SAMPLES;
+    }
+    if (filled) {
+        syncTimer->setInterval(ClockConstants::SYNC_INTERVAL);
+    }
+}
+
+/**
+ * @brief Completes a time sync exchange with the robot's answer.
+ * @param Datagram holding the reply.
+ * @param Robot index.
+ */
+void CommunicationHandler::processTimeReply(const DatagramView &datagram, int robot)
+{
+    quint64 now = timestamp();
+    TimeSyncPacket reply;
+    if (!Protocol::decodeTimeSync(datagram.data, datagram.size, reply)) {
+        return;
+    }
+    ClockSync &sync = robots[robot].sync;
+    bool wasSynchronized = sync.isSynchronized();
+    sync.addSample(reply.originate, reply.receive, reply.transmit, now);
+    if (!wasSynchronized && sync.isSynchronized()) {
         logger->write(LoggerConstants::INFO,
-                      QString("Communication sending on: ") + sendAddress.toString() + QString(":")
-                          + QString::number(lastConnectedPort));
+                      QString("Clock of ") + robots[robot].endpoint.toString()
+                          + " synchronized, offset "
+                          + QString::number(sync.offset() / 1000.0, 'f', 2) + " ms +- "
+                          + QString::number(sync.delay() / 2000.0, 'f', 2) + " ms");
+    }
+    if (robot == 0) {
+        linkStats.clockSynchronized = sync.isSynchronized();
+        linkStats.clockOffset = sync.offset() / 1000.0;
+        linkStats.clockDrift = sync.drift();
+    }
+}
+
+/**
+ * @brief Measures the one way latency of the movement packet a heartbeat echoes, from the
+ * robot's receive time converted to the server clock.
+ * @param Decoded heartbeat.
+ * @param Robot index.
+ */
+void CommunicationHandler::processEchoTime(const HeartbeatPacket &heartbeat, int robot)
+{
+    Robot &entry = robots[robot];
+    if (heartbeat.echoReceiveTime == 0 || !entry.sync.isSynchronized()
+        || heartbeat.echoReceiveTime == entry.lastEchoReceiveTime) {
+        return;
+    }
+    entry.lastEchoReceiveTime = heartbeat.echoReceiveTime;
+
+    quint32 age = sequence - heartbeat.echoSequence;
+    if (age < 1 || age > quint32(ProtocolConstants::SEND_HISTORY)) {
+        return;
+    }
+    int slot = heartbeat.echoSequence & (ProtocolConstants::SEND_HISTORY - 1);
+    qint64 transit = entry.sync.toServer(heartbeat.echoReceiveTime) - qint64(sentTimestamps[slot]);
+    latency->record(LatencyConstants::SEND_TO_ROBOT, std::max(transit, qint64(0)) * 1000);
+}
+
+/**
+ * @brief Forgets what a robot supports and asks it again, done whenever a different robot may
+ * answer at the endpoint. The robot is driven with the configured format meanwhile, or with
+ * text if the format is negotiated.
+ * @param Robot index.
+ */
+void CommunicationHandler::startNegotiation(int robot)
+{
+    Robot &entry = robots[robot];
+    entry.negotiated = false;
+    entry.version = 0;
+    entry.capabilities = 0;
+    entry.helloAttempts = 0;
+    entry.format = selectFormat(robot);
+    setRobotDestination(robot);
+    closeControl(robot);
+    if (enabled && !helloTimer->isActive()) {
+        helloTimer->start(ProtocolConstants::HELLO_INTERVAL);
+    }
+}
+
+/**
+ * @brief Sends a hello to every robot that has not answered yet. A robot that stays silent for
+ * ProtocolConstants::HELLO_ATTEMPTS hellos is left as a legacy client and not asked again.
+ */
+void CommunicationHandler::sendHello()
+{
+    HelloPacket packet;
+    packet.version = ProtocolConstants::VERSION;
+    packet.capabilities = ProtocolConstants::SERVER_CAPABILITIES;
+    char buffer[ProtocolConstants::HELLO_SIZE];
+    int size = Protocol::encodeHello(ProtocolConstants::HELLO, packet, buffer);
+
+    bool pending = false;
+    for (int i = 0; i < robots.size(); i++) {
+        Robot &entry = robots[i];
+        if (entry.negotiated || entry.helloAttempts > ProtocolConstants::HELLO_ATTEMPTS) {
+            continue;
+        }
+        if (entry.endpoint.address.isNull()) {
+            continue; // Asked once the host resolves, see hostResolved
+        }
+        if (entry.helloAttempts == ProtocolConstants::HELLO_ATTEMPTS) {
+            entry.helloAttempts++;
+            logger->write(LoggerConstants::INFO,
+                          QString("No handshake from ") + entry.endpoint.toString()
+                              + ", sending " + ProtocolConstants::FORMAT_NAMES[entry.format]);
+            emit robotCapabilities(i, entry.endpoint.toString(), 0, 0, entry.format);
+            continue;
+        }
+        writeDatagram(buffer, size, entry.endpoint.address, entry.endpoint.port);
+        entry.helloAttempts++;
+        pending = true;
+    }
+    if (!pending) {
+        helloTimer->stop();
+    }
+}
+
+/**
+ * @brief Takes a robot's hello or ack. A hello is answered with an ack. The robot is then
+ * driven with the format selectFormat picks for its capabilities.
+ * @param Datagram holding the hello or ack.
+ * @param Robot index.
+ */
+void CommunicationHandler::processHello(const DatagramView &datagram, int robot)
+{
+    HelloPacket hello;
+    if (!Protocol::decodeHello(datagram.data, datagram.size, hello)) {
+        return;
+    }
+    if (Protocol::packetType(datagram.data) == ProtocolConstants::HELLO) {
+        HelloPacket ack;
+        ack.version = ProtocolConstants::VERSION;
+        ack.capabilities = ProtocolConstants::SERVER_CAPABILITIES;
+        char buffer[ProtocolConstants::HELLO_SIZE];
+        int size = Protocol::encodeHello(ProtocolConstants::HELLO_ACK, ack, buffer);
+        writeDatagram(buffer, size, datagram.senderAddress, datagram.senderPort);
+    }
+
+    Robot &entry = robots[robot];
+    int version = std::min(int(hello.version), int(ProtocolConstants::VERSION));
+    if (entry.negotiated && entry.version == version
+        && entry.capabilities == hello.capabilities) {
+        return; // Answer to a repeated hello
+    }
+    entry.negotiated = true;
+    entry.version = version;
+    entry.capabilities = hello.capabilities;
+    int previous = entry.format;
+    entry.format = selectFormat(robot);
+    if (!(entry.format == previous)) {
+        setRobotDestination(robot);
+        movementSent = false; // The next tick goes out in the new format even if suppressed
+    }
+
+    logger->write(LoggerConstants::INFO,
+                  QString("Handshake with ") + entry.endpoint.toString() + ", version "
+                      + QString::number(version) + ", capabilities 0x"
+                      + QString::number(hello.capabilities, 16) + ", sending "
+                      + ProtocolConstants::FORMAT_NAMES[entry.format]);
+    if (!(packetFormat == ProtocolConstants::AUTO_FORMAT) && !(entry.format == packetFormat)) {
+        logger->write(LoggerConstants::WARNING,
+                      entry.endpoint.toString() + " does not support the "
+                          + ProtocolConstants::FORMAT_NAMES[packetFormat] + " format");
+    }
+    emit robotCapabilities(robot,
+                           entry.endpoint.toString(),
+                           version,
+                           hello.capabilities,
+                           entry.format);
+    if (hello.capabilities & ProtocolConstants::CAP_CONTROL) {
+        openControl(robot);
+    } else {
+        closeControl(robot);
+    }
+}
+
+/**
+ * @brief Picks the packet format a robot is driven with. Automatic negotiation picks the
+ * fastest format both sides support. A configured format is used as is unless the handshake
+ * showed the robot lacks it, robots without a handshake get it unchanged so binary clients
+ * that predate the handshake keep working.
+ * @param Robot index.
+ * @return Format from ProtocolConstants, never AUTO_FORMAT.
+ */
+int CommunicationHandler::selectFormat(int robot) const
+{
+    const Robot &entry = robots[robot];
+    if (!entry.negotiated) {
+        return packetFormat == ProtocolConstants::AUTO_FORMAT ? ProtocolConstants::TEXT_FORMAT
+                                                               : packetFormat;
+    }
+    quint32 common = entry.capabilities & ProtocolConstants::SERVER_CAPABILITIES;
+    int fastest = (common & ProtocolConstants::CAP_BINARY) ? ProtocolConstants::BINARY_FORMAT
+                                                           : ProtocolConstants::TEXT_FORMAT;
+    switch (packetFormat) {
+    case ProtocolConstants::BINARY_FORMAT:
+    case ProtocolConstants::AUTO_FORMAT:
+        return fastest;
+    case ProtocolConstants::TRAJECTORY_FORMAT:
+        return (common & ProtocolConstants::CAP_TRAJECTORY) ? packetFormat : fastest;
+    case ProtocolConstants::QUANTIZED_FORMAT:
+        return (common & ProtocolConstants::CAP_QUANTIZED) ? packetFormat : fastest;
+    default:
+        return packetFormat;
+    }
+}
+
+/**
+ * @brief Connects a control channel to a robot that announced one, unless it has one already
+ * or control channels are switched off. The channel runs on the control thread, everything it
+ * reports is queued back to this one.
+ * @param Robot index.
+ */
+void CommunicationHandler::openControl(int robot)
+{
+    Robot &entry = robots[robot];
+    if (entry.control || controlPort < 0
+        || !(entry.capabilities & ProtocolConstants::CAP_CONTROL)) {
+        return;
+    }
+    ControlChannel *channel = new ControlChannel(logger, entry.endpoint.toString());
+    channel->moveToThread(controlThread);
+    entry.control = channel;
+    // The channel may be gone by the time a queued signal arrives, it is only looked up
+    connect(channel, &ControlChannel::connected, this, [this, channel]() {
+        int index = findControl(channel);
+        if (index >= 0) {
+            pushConfiguration(index);
+        }
+    });
+    connect(channel,
+            &ControlChannel::messageReceived,
+            this,
+            [this, channel](int type, const QByteArray &payload) {
+                int index = findControl(channel);
+                if (index >= 0) {
+                    processControlMessage(index, type, payload);
+                }
+            });
+
+    if (sharedLink.isOpen()) {
+        // The simulator serves the channel on a local socket named after the segment
+        QString name = ControlConstants::LOCAL_PREFIX + sharedName;
+        QMetaObject::invokeMethod(
+            channel, [channel, name]() { channel->openLocal(name); }, Qt::QueuedConnection);
+        return;
+    }
+    QHostAddress address = entry.endpoint.address;
+    quint16 port = controlPort > 0 ? quint16(controlPort) : entry.endpoint.port;
+    QMetaObject::invokeMethod(
+        channel,
+        [channel, address, port]() { channel->open(address, port); },
+        Qt::QueuedConnection);
+}
+
+/**
+ * @brief Drops a robot's control channel. Messages it still had queued are lost.
+ * @param Robot index.
+ */
+void CommunicationHandler::closeControl(int robot)
+{
+    Robot &entry = robots[robot];
+    if (!entry.control) {
+        return;
+    }
+    // Deleted on its own thread, after whatever was queued to it before
+    entry.control->deleteLater();
+    entry.control = nullptr;
+    entry.logDownload.clear();
+}
+
+/**
+ * @brief Finds the robot a control channel belongs to.
+ * @param Channel.
+ * @return Robot index, -1 if the channel was closed meanwhile.
+ */
+int CommunicationHandler::findControl(const ControlChannel *channel) const
+{
+    for (int i = 0; i < robots.size(); i++) {
+        if (robots[i].control == channel) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Sends a robot the settings it needs to know about as "key=value" lines. Done every
+ * time its control channel connects, so a restarted robot is configured again. The drive model
+ * and its wheel count tell the robot how many of the speed fields in each movement packet are
+ * used, the rest stay zero.
+ * @param Robot index.
+ */
+void CommunicationHandler::pushConfiguration(int robot)
+{
+    const Robot &entry = robots[robot];
+    QString text = QString("rate=%1\nkeepalive=%2\nformat=%3\nstop_state=%4\ngain=%5\n"
+                           "offset=%6\ndrive=%7\nwheels=%8\n")
+                       .arg(sendRate)
+                       .arg(keepaliveInterval)
+                       .arg(ProtocolConstants::FORMAT_NAMES[entry.format])
+                       .arg(stopPolicy)
+                       .arg(entry.endpoint.gain)
+                       .arg(entry.endpoint.offset)
+                       .arg(DriveConstants::MODEL_NAMES[driveModel])
+                       .arg(DriveModel::wheelCount(driveModel));
+    sendControlMessage(robot, ProtocolConstants::CONTROL_CONFIG, text.toUtf8());
+}
+
+/**
+ * @brief Queues a message on a robot's control channel. Never waits for the network, the
+ * channel sends on its own thread.
+ * @param Robot index.
+ * @param Message type, one of the ProtocolConstants::CONTROL_* constants.
+ * @param Payload.
+ */
+void CommunicationHandler::sendControlMessage(int robot, int type, const QByteArray &payload)
+{
+    if (robot < 0 || robot >= robots.size() || !robots[robot].control) {
+        logger->write(LoggerConstants::WARNING,
+                      QString("Robot ") + QString::number(robot + 1)
+                          + " has no control channel");
+        return;
+    }
+    ControlChannel *channel = robots[robot].control;
+    QMetaObject::invokeMethod(
+        channel,
+        [channel, type, payload]() { channel->send(type, payload); },
+        Qt::QueuedConnection);
+}
+
+/**
+ * @brief Asks every robot with a control channel for its log. Each log is reported with
+ * robotLogReceived once the robot finished sending it.
+ */
+void CommunicationHandler::requestRobotLogs()
+{
+    bool requested = false;
+    for (int i = 0; i < robots.size(); i++) {
+        if (robots[i].control) {
+            robots[i].logDownload.clear();
+            sendControlMessage(i, ProtocolConstants::CONTROL_LOG_REQUEST, QByteArray());
+            requested = true;
+        }
+    }
+    if (!requested) {
+        logger->write(LoggerConstants::WARNING, "No robot offers a control channel");
+    }
+}
+
+/**
+ * @brief Takes a message a robot sent on its control channel.
+ * @param Robot index.
+ * @param Message type.
+ * @param Payload.
+ */
+void CommunicationHandler::processControlMessage(int robot,
+                                                 int type,
+                                                 const QByteArray &payload)
+{
+    Robot &entry = robots[robot];
+    switch (type) {
+    case ProtocolConstants::CONTROL_PARAM_VALUE: {
+        const QStringList lines = QString::fromUtf8(payload).split('\n', Qt::SkipEmptyParts);
+        for (const QString &line : lines) {
+            logger->write(LoggerConstants::INFO,
+                          entry.endpoint.toString() + " parameter " + line);
+        }
+        break;
+    }
+    case ProtocolConstants::CONTROL_LOG_DATA:
+        if (payload.isEmpty()) {
+            emit robotLogReceived(robot, entry.endpoint.toString(), entry.logDownload);
+            entry.logDownload.clear();
+        } else if (entry.logDownload.size() < ControlConstants::MAX_LOG_SIZE) {
+            entry.logDownload += payload.left(ControlConstants::MAX_LOG_SIZE
+                                              - entry.logDownload.size());
+        }
+        break;
     }
 }
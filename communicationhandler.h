@@ -1,12 +1,33 @@
 #ifndef COMMUNICATIONHANDLER_H
 #define COMMUNICATIONHANDLER_H
 
+#include "batchreceiver.h"
+#include "batchsender.h"
+#include "clocksync.h"
+#include "controlchannel.h"
+#include "drivemodel.h"
+#include "hostresolver.h"
+#include "latencyhistogram.h"
+#include "linkestimator.h"
+#include "linkstatistics.h"
 #include "loggerhandler.h"
+#include "protocol.h"
+#include "robotendpoint.h"
+#include "setpointmailbox.h"
+#include "sharedmemorylink.h"
+#include "stopsender.h"
+#include "telemetryring.h"
+#include "trace.h"
+#include "trajectorypredictor.h"
 
+#include <QElapsedTimer>
 #include <QNetworkDatagram>
 #include <QNetworkInterface>
 #include <QObject>
+#include <QRandomGenerator>
 #include <QSettings>
+#include <QSocketNotifier>
+#include <QThread>
 #include <QTimer>
 #include <QUdpSocket>
 
@@ -14,30 +35,190 @@ class CommunicationHandler : public QObject
 {
     Q_OBJECT
 public:
-    CommunicationHandler(LoggerHandler *loggerRef, QSettings *settingsRef);
+    CommunicationHandler(LoggerHandler *loggerRef,
+                         QSettings *settingsRef,
+                         LatencyTracker *latencyRef,
+                         TelemetryRing *telemetryRef);
+    ~CommunicationHandler();
 
 public slots:
-    void sendMovementData(double FL, double BR, double FR, double BL);
+    void setMovementData(double FL, double BR, double FR, double BL);
+    void emergencyStop();
     void updateWithSettings();
     void refreshConnection();
+    void sendControlMessage(int robot, int type, const QByteArray &payload);
+    void requestRobotLogs();
 signals:
     void connectionStatus(bool);
+    void fleetStatus(int connected, int total);
+    void linkStatisticsChanged(LinkStatistics);
+    void robotCapabilities(int robot,
+                           const QString &endpoint,
+                           int version,
+                           quint32 capabilities,
+                           int format);
+    void robotLogReceived(int robot, const QString &endpoint, const QByteArray &log);
+
+private slots:
+    void retryMovementData();
 
 private:
     LoggerHandler *logger;
     QSettings *settings;
+    LatencyTracker *latency;
+    TelemetryRing *telemetry;
 
     QHostAddress sendAddress;
+    QString sendHost; // Configured client name, empty for a literal address
+
+    /**
+     * A robot driven by this handler, with its own link estimate, clock estimate and status.
+     * The timeout timer fires when the link would change to the next worse state without
+     * another heartbeat.
+     */
+    struct Robot
+    {
+        RobotEndpoint endpoint;
+        LinkEstimator link;
+        ClockSync sync;
+        quint64 lastEchoReceiveTime; // Robot clock, repeated echoes are only measured once
+        int format; // Packet format the robot is driven with
+        int version; // Negotiated protocol version, 0 without a handshake
+        quint32 capabilities;
+        int helloAttempts;
+        bool negotiated;
+        QTimer *timeoutTimer;
+        ControlChannel *control; // Lives on controlThread, nullptr unless the robot offers one
+        QByteArray logDownload;  // Log chunks received since the last log request
+        int linkState;
+        bool stopped; // Sent zero speeds by the stop policy
+        bool connected;
+        bool resolveFailed; // Failure to resolve the host was logged, cleared once it resolves
+    };
 
     void initSocket();
-    void initTimer();
+    void initSendTimer();
+    void initStatsTimer();
+    void initDiscoveryTimer();
+    void initSyncTimer();
+    void initHelloTimer();
+    void initResolver();
+    bool bindSocket(const QHostAddress &address);
+    bool openSharedMemory();
+    void readSharedMemory();
+    void writeDatagram(const char *data, int size, const QHostAddress &address, quint16 port);
+    void attachSocket();
+    void attachWriteNotifier();
+    void releaseWriteNotifier();
+    void setRobotDestination(int robot);
+    void hostResolved(const QString &host, const QHostAddress &address);
+    void hostFailed(const QString &host, const QString &error);
+    void countUnresolved();
+    void sendStop(quint32 robotMask);
+    void writeStop(quint32 robotMask, quint32 id);
+    void startDiscovery();
+    void sendAnnounce();
+    void processAnnounceReply(const DatagramView &datagram);
+    void sendTimeSync();
+    void processTimeReply(const DatagramView &datagram, int robot);
+    void processEchoTime(const HeartbeatPacket &heartbeat, int robot);
+    void startNegotiation(int robot);
+    void sendHello();
+    void processHello(const DatagramView &datagram, int robot);
+    int selectFormat(int robot) const;
+    void openControl(int robot);
+    void closeControl(int robot);
+    int findControl(const ControlChannel *channel) const;
+    void pushConfiguration(int robot);
+    void processControlMessage(int robot, int type, const QByteArray &payload);
+    void sendMovementData();
     void readPendingDatagrams();
-    void processDatagrams(QNetworkDatagram datagram);
+    void readBatchedDatagrams();
+    void readQtDatagrams();
+    void processDatagrams(const DatagramView &datagram);
+    int findRobot(const DatagramView &datagram);
+    void heartbeatReceived(int robot);
+    void checkLink(int robot);
+    void setLinkState(int robot, int state);
+    void setRobotConnected(int robot, bool connected);
+    void configureRobots(const QString &fleetText);
+    void processHeartbeat(const HeartbeatPacket &heartbeat);
+    void processTelemetry(const DatagramView &datagram, int robot);
+    void resetStatistics();
+    quint64 timestamp();
+    int serializeMovement(MovementPacket &packet, int format, const double *speeds, char *buffer);
+    int serializeTrajectory(const MovementPacket &packet,
+                            const RobotEndpoint &endpoint,
+                            bool held,
+                            char *buffer);
+    void writeMovementData(int first);
+    void movementWritten();
+    bool suppressMovement(const double *speeds);
 
     QUdpSocket *commSocket;
-    QTimer *timeoutTimer;
+    QTimer *sendTimer;
+    QTimer *statsTimer;
+    QTimer *discoveryTimer;
+    QTimer *syncTimer;
+    QTimer *helloTimer;
+    quint32 syncId;
     int lastConnectedPort;
+    quint16 listenPort; // Configured port, lastConnectedPort follows the client instead
     bool enabled;
+    int packetFormat; // Configured, robots may be driven with another one, see selectFormat
+    int sendRate;
+    SetpointMailbox mailbox;
+    bool producerMoving; // Only touched by the producer thread in setMovementData
+
+    double suppressEpsilon;
+    int keepaliveInterval;
+    int stopPolicy;
+    bool movementSent;
+    double lastSentSpeeds[4];
+    TrajectoryPredictor predictor;
+    int horizonPoints;
+    double trajectory[ProtocolConstants::MAX_TRAJECTORY_POINTS][4]; // Predicted, packet order
+    bool trajectorySteady; // Last chunk sent was flat
+    int quantizationBits;
+    double quantizationSquares; // Error of quantized speeds sent since the last statistics update
+    double quantizationPeak;
+    quint64 quantizationCount;
+    quint64 lastSendTime;
+    BatchReceiver batchReceiver;
+    bool batchReceive;
+    BatchSender batchSender;
+    QSocketNotifier *writeNotifier; // Watches writeDescriptor while sendBlocked
+    int writeDescriptor; // Duplicate of the socket descriptor, -1 without a notifier
+    bool sendBlocked;    // Socket send buffer was full, waiting for it to drain
+    int unsentRobot;     // First robot the newest setpoint did not reach, robot count if none
+    bool packetWritten;  // A datagram of the newest packet went out, its sequence is used up
+    bool latencyPending; // unsentSetpoint was not written yet, its latency is still to record
+    Setpoint unsentSetpoint;
+    StopSender stopSender;
+    std::atomic<bool> stopLatched;
+    QVector<Robot> robots;
+    bool fleetMode;
+    HostResolver *resolver;
+    SharedMemoryLink sharedLink;
+    QString sharedName; // Segment name when the client address selects shared memory
+    QThread *controlThread; // Runs every control channel, away from the send timer
+    int controlPort;        // 0 uses each robot's own port, negative disables control channels
+    int driveModel;         // DriveConstants model, tells robots which speed slots are used
+    int unresolvedRobots; // Robots whose host has no address yet, they are skipped when sending
+
+    QHostAddress bindAddress;
+    bool discovery;
+    bool discovering;
+    quint32 discoveryNonce;
+    quint64 discoveryStart;
+
+    QElapsedTimer clock;
+    quint32 sequence;
+    quint64 sentTimestamps[ProtocolConstants::SEND_HISTORY];
+    LinkStatistics linkStats;
+    bool echoReceived;
+    quint32 lastEchoSequence;
+    quint32 lastReceivedCount;
 };
 
 #endif // COMMUNICATIONHANDLER_H
@@ -5,6 +5,7 @@
 
 namespace MathConstants {
 inline constexpr double PI = 3.14159265;
+inline constexpr double HALF_SQRT2 = 0.70710678118654752440; // sin(pi / 4)
 }
 
 namespace IOConstants {
@@ -19,6 +20,214 @@ inline constexpr int FL_GRAPH = 2;
 inline constexpr int BR_GRAPH = 3;
 } // namespace IOConstants
 
+namespace KinematicsConstants {
+inline constexpr int TRIG_KERNEL = 0;        // Direction, magnitude and a sine per wheel
+inline constexpr int CLOSED_FORM_KERNEL = 1; // Multiply-adds only, see kinematics.h
+inline constexpr int KERNEL_COUNT = 2;
+inline constexpr const char *KERNEL_NAMES[] = {"trig", "closed form"};
+
+// Implementations of the closed form kernel for batches, the best one the CPU supports is used
+inline constexpr int SCALAR_BATCH = 0;
+inline constexpr int SSE2_BATCH = 1; // 2 samples per instruction
+inline constexpr int AVX2_BATCH = 2; // 4 samples per instruction
+inline constexpr int BATCH_PATH_COUNT = 3;
+inline constexpr const char *BATCH_PATH_NAMES[] = {"scalar", "SSE2", "AVX2"};
+} // namespace KinematicsConstants
+
+namespace DriveConstants {
+// Drive models, each one a policy in drivemodel.h
+inline constexpr int MECANUM = 0;
+inline constexpr int X_DRIVE = 1;
+inline constexpr int OMNI = 2;         // Four omni wheels in a + pattern
+inline constexpr int DIFFERENTIAL = 3; // Two driven wheels, one on each side
+inline constexpr int MODEL_COUNT = 4;
+inline constexpr const char *MODEL_NAMES[] = {"mecanum", "x-drive", "omni", "differential"};
+
+// Wheel speed slots shared by the sliders, chart, simulation and packets
+inline constexpr int MAX_WHEELS = 4;
+} // namespace DriveConstants
+
+namespace ProtocolConstants {
+inline constexpr int TEXT_FORMAT = 0;   // Legacy "m,FL,BR,FR,BL" datagram
+inline constexpr int BINARY_FORMAT = 1; // Fixed layout little-endian packet
+inline constexpr int TRAJECTORY_FORMAT = 2; // Binary packet with a horizon of future setpoints
+inline constexpr int AUTO_FORMAT = 3; // Fastest format the handshake found both sides support
+inline constexpr int QUANTIZED_FORMAT = 4; // Wheel speeds as int16 or int8, for slow radio links
+inline constexpr const char *FORMAT_NAMES[] = {"text", "binary", "trajectory", "auto", "quantized"};
+
+// Bits per wheel speed in quantized packets, indexed by the quantization setting
+inline constexpr int QUANTIZATION_BITS[] = {16, 8};
+inline constexpr int QUANTIZATION_BITS_COUNT = 2;
+
+// Selectable send scheduler rates in Hz, indexed by the send rate setting
+inline constexpr int SEND_RATES[] = {50, 100, 250};
+inline constexpr int SEND_RATES_COUNT = 3;
+
+// Change suppression thresholds on the largest wheel speed change, indexed by the suppression
+// setting. 0 sends every tick.
+inline constexpr double SUPPRESS_EPSILONS[] = {0.0, 0.002, 0.01, 0.05};
+inline constexpr int SUPPRESS_EPSILONS_COUNT = 4;
+
+inline constexpr unsigned char MAGIC = 0xA7;
+inline constexpr unsigned char VERSION = 1;
+
+// Packet types, stored in the third byte of every binary header
+inline constexpr unsigned char MOVEMENT = 0x01;
+inline constexpr unsigned char HEARTBEAT = 0x02;
+inline constexpr unsigned char ANNOUNCE = 0x03;
+inline constexpr unsigned char ANNOUNCE_REPLY = 0x04;
+inline constexpr unsigned char STOP = 0x05;
+inline constexpr unsigned char TRAJECTORY = 0x06;
+inline constexpr unsigned char TIME_REQUEST = 0x07;
+inline constexpr unsigned char TIME_REPLY = 0x08;
+inline constexpr unsigned char HELLO = 0x09;
+inline constexpr unsigned char HELLO_ACK = 0x0A;
+inline constexpr unsigned char QUANTIZED16 = 0x0B;
+inline constexpr unsigned char QUANTIZED8 = 0x0C;
+inline constexpr unsigned char IMU = 0x10;
+inline constexpr unsigned char ENCODER = 0x11;
+inline constexpr unsigned char BATTERY = 0x12;
+// Control channel messages, only sent framed on the reliable stream, never as datagrams
+inline constexpr unsigned char CONTROL_CONFIG = 0x20;      // "key=value" lines for the robot
+inline constexpr unsigned char CONTROL_PARAM_GET = 0x21;   // Parameter names, one per line
+inline constexpr unsigned char CONTROL_PARAM_SET = 0x22;   // "key=value" lines
+inline constexpr unsigned char CONTROL_PARAM_VALUE = 0x23; // "key=value" lines, get or set answer
+inline constexpr unsigned char CONTROL_LOG_REQUEST = 0x24; // Empty, asks for the robot's log
+inline constexpr unsigned char CONTROL_LOG_DATA = 0x25;    // Log text, an empty chunk ends it
+
+inline constexpr int HEADER_SIZE = 4;
+inline constexpr int MOVEMENT_SIZE = 32;
+inline constexpr int HEARTBEAT_SIZE = 28;
+inline constexpr int HEARTBEAT_BASE_SIZE = 12;    // Without the receive time, older clients
+inline constexpr int HEARTBEAT_RECEIVE_SIZE = 20; // Without the transmit time, older clients
+inline constexpr int ANNOUNCE_SIZE = 8;
+inline constexpr int STOP_SIZE = 8;
+inline constexpr int TRAJECTORY_HEADER_SIZE = 20;
+inline constexpr int TRAJECTORY_POINT_SIZE = 20;
+inline constexpr int TIME_REQUEST_SIZE = 16;
+inline constexpr int TIME_REPLY_SIZE = 32;
+inline constexpr int HELLO_SIZE = 12;
+inline constexpr int QUANTIZED16_SIZE = 12;
+inline constexpr int QUANTIZED8_SIZE = 8;
+inline constexpr int IMU_SIZE = 36;
+inline constexpr int ENCODER_SIZE = 44;
+inline constexpr int BATTERY_SIZE = 24;
+inline constexpr int CONTROL_HEADER_SIZE = 8;
+
+// Number of sent packet timestamps remembered for round trip time lookups, power of 2
+inline constexpr int SEND_HISTORY = 256;
+inline constexpr int MAX_PACKET_SIZE = 512;
+// Upper bound for datagrams drained per batched receive call
+inline constexpr int MAX_RECEIVE_BATCH = 64;
+// Upper bound for robots driven at once in fleet mode, one send slot each
+inline constexpr int MAX_FLEET_SIZE = 16;
+
+// Every emergency stop is sent this many times, the copies spaced by STOP_SPACING milliseconds
+inline constexpr int STOP_COPIES = 3;
+inline constexpr int STOP_SPACING = 5;
+
+// Trajectory points per packet, indexed by the horizon setting. Points are spaced by the send
+// interval, so a robot can ride out one less lost packet than there are points.
+inline constexpr int TRAJECTORY_HORIZONS[] = {3, 5, 8};
+inline constexpr int TRAJECTORY_HORIZONS_COUNT = 3;
+inline constexpr int MAX_TRAJECTORY_POINTS = 8;
+// Setpoints the wheel speed trend is fitted over, in microseconds
+inline constexpr int TRAJECTORY_WINDOW = 100000;
+// Time constant the predicted trend fades with, in microseconds. Bounds how far a prediction
+// can run away from the last real setpoint.
+inline constexpr int TRAJECTORY_DAMPING = 50000;
+
+// Capability bits exchanged in the handshake
+inline constexpr quint32 CAP_BINARY = 1u << 0;
+inline constexpr quint32 CAP_TRAJECTORY = 1u << 1;
+inline constexpr quint32 CAP_TIME_SYNC = 1u << 2;
+inline constexpr quint32 CAP_STOP = 1u << 3;
+inline constexpr quint32 CAP_QUANTIZED = 1u << 4;
+inline constexpr quint32 CAP_CONTROL = 1u << 5; // Accepts a control channel connection
+inline constexpr quint32 CAP_IMU = 1u << 8;
+inline constexpr quint32 CAP_ENCODER = 1u << 9;
+inline constexpr quint32 CAP_BATTERY = 1u << 10;
+inline constexpr quint32 SERVER_CAPABILITIES = CAP_BINARY | CAP_TRAJECTORY | CAP_TIME_SYNC
+                                               | CAP_STOP | CAP_QUANTIZED | CAP_CONTROL | CAP_IMU
+                                               | CAP_ENCODER | CAP_BATTERY;
+// Hellos are repeated at this interval until answered, a robot that never answers is treated
+// as a legacy text client
+inline constexpr int HELLO_INTERVAL = 200;
+inline constexpr int HELLO_ATTEMPTS = 5;
+
+// Robots listen for discovery announces on this port on every interface
+inline constexpr quint16 DISCOVERY_PORT = 12399;
+// Announce interval while searching, slowed down once nobody answered for a while
+inline constexpr int DISCOVERY_INTERVAL = 100;
+inline constexpr int DISCOVERY_SLOW_INTERVAL = 1000;
+inline constexpr int DISCOVERY_FAST_PERIOD = 5000;
+} // namespace ProtocolConstants
+
+namespace LinkConstants {
+// Link states, ordered by severity. The stop policy setting uses the same values as the state
+// it stops the robot at, 0 never stops.
+inline constexpr int GOOD = 0;
+inline constexpr int DEGRADED = 1;
+inline constexpr int LOST = 2;
+
+// Timeouts in milliseconds. The initial timeout applies until heartbeat intervals were measured.
+// The lost timeout stays after the degraded one and can pass MAX_TIMEOUT when that one is at it.
+inline constexpr int INITIAL_TIMEOUT = 500;
+inline constexpr int MIN_TIMEOUT = 150;
+inline constexpr int MAX_TIMEOUT = 3000;
+} // namespace LinkConstants
+
+namespace ResolverConstants {
+// Milliseconds a resolved name is trusted. The system resolver does not report record TTLs, so
+// names are looked up again in the background once this passed.
+inline constexpr int CACHE_TTL = 60000;
+// Milliseconds until a name that failed to resolve is tried again
+inline constexpr int FAILURE_TTL = 5000;
+} // namespace ResolverConstants
+
+namespace SharedMemoryConstants {
+// Client addresses starting with this select the shared memory transport, the rest is the name
+inline constexpr auto SCHEME = "shm://";
+inline constexpr auto NAME_PREFIX = "/remotecontrol-"; // POSIX shared memory object name prefix
+inline constexpr quint32 MAGIC = 0x52435348;          // "RCSH", set once the segment is set up
+inline constexpr quint32 LAYOUT = 1;                  // Bumped whenever the segment layout changes
+inline constexpr int SLOT_COUNT = 64; // Datagrams queued per direction, power of 2
+// Milliseconds a waiting reader sleeps before it checks if it should quit
+inline constexpr int WAIT_TIMEOUT = 100;
+// Milliseconds between attempts to attach to a segment that does not exist yet
+inline constexpr int ATTACH_INTERVAL = 1000;
+} // namespace SharedMemoryConstants
+
+namespace ControlConstants {
+// Milliseconds before a lost control connection is tried again, doubled up to the maximum
+inline constexpr int RECONNECT_MIN = 500;
+inline constexpr int RECONNECT_MAX = 10000;
+// Bytes queued on a control connection before further messages are refused, so a stalled
+// robot can not grow the queue without bound
+inline constexpr qint64 MAX_BACKLOG = 256 * 1024;
+// Kernel send buffer of a control connection. Kept small so bulk transfers do not fill the
+// interface queue the setpoint datagrams go through.
+inline constexpr int SEND_BUFFER = 64 * 1024;
+inline constexpr int TYPE_OF_SERVICE = 0x08; // IPTOS_THROUGHPUT, bulk traffic
+// Frames announcing a larger payload mean the stream is out of step
+inline constexpr int MAX_PAYLOAD = 1024 * 1024;
+// Bytes of a downloaded robot log kept, the rest of a longer log is dropped
+inline constexpr int MAX_LOG_SIZE = 16 * 1024 * 1024;
+// Local stream server name used with the shared memory transport, followed by the segment name
+inline constexpr auto LOCAL_PREFIX = "remotecontrol-";
+} // namespace ControlConstants
+
+namespace ClockConstants {
+// Time sync requests go out fast until the clock filter is full, then at the slow interval
+inline constexpr int SYNC_FAST_INTERVAL = 100;
+inline constexpr int SYNC_INTERVAL = 1000;
+inline constexpr int SYNC_FAST_SAMPLES = 8;
+// Exchanges needed before robot timestamps are converted to the server clock
+inline constexpr int MIN_SAMPLES = 4;
+// Largest drift believed, in ppm
+inline constexpr double MAX_DRIFT = 500.0;
+} // namespace ClockConstants
+
 namespace SettingsConstants {
 inline constexpr int DISABLED_INFO = 0; // Generates a straight line
 inline constexpr int BASIC_INFO = 1;    // Mag and scale - 2 speed lines
@@ -32,6 +241,22 @@ inline constexpr auto CONN_CAM_EN = "connection/camera/en";
 inline constexpr auto CONN_COMM_ADDRESS = "connection/communication/address";
 inline constexpr auto CONN_COMM_PORT = "connection/communication/port";
 inline constexpr auto CONN_COMM_EN = "connection/communication/en";
+inline constexpr auto CONN_COMM_FORMAT = "connection/communication/format";
+inline constexpr auto CONN_COMM_RATE = "connection/communication/rate";
+inline constexpr auto CONN_COMM_BATCH = "connection/communication/batch";
+inline constexpr auto CONN_COMM_FLEET = "connection/communication/fleet";
+inline constexpr auto CONN_COMM_SUPPRESS = "connection/communication/suppress";
+inline constexpr auto CONN_COMM_KEEPALIVE = "connection/communication/keepalive";
+inline constexpr auto CONN_COMM_BIND = "connection/communication/bind";
+inline constexpr auto CONN_COMM_DISCOVERY = "connection/communication/discovery";
+inline constexpr auto CONN_COMM_STOP = "connection/communication/stop";
+inline constexpr auto CONN_COMM_STOP_BUTTON = "connection/communication/stop_button";
+inline constexpr auto CONN_COMM_HORIZON = "connection/communication/horizon";
+inline constexpr auto CONN_COMM_QUANTIZATION = "connection/communication/quantization";
+inline constexpr auto CONN_COMM_CONTROL_PORT = "connection/communication/control_port";
+inline constexpr auto CONN_COMM_DRIVE = "connection/communication/drive";
+
+inline constexpr auto KINEMATICS_KERNEL = "kinematics/kernel";
 
 inline constexpr auto GRAPH_PERF_EN = "graph/performance/en";
 inline constexpr auto GRAPH_PERF_QUAL = "graph/performance/qual";
@@ -50,6 +275,8 @@ inline constexpr auto APPEAR_THEME_DARK_EN = "appear/theme/dark_en";
 inline constexpr auto APPEAR_THEME_CLOGS_EN = "appear/theme/colored_logs_en";
 inline constexpr auto APPEAR_THEME_TLOGS_EN = "appear/theme/timed_logs_en";
 
+inline constexpr auto DEBUG_TRACE = "debug/trace"; // Not exposed in the UI
+
 inline constexpr auto WINDOW_SIZE_X = "window/x";
 inline constexpr auto WINDOW_SIZE_Y = "window/y";
 
@@ -60,6 +287,23 @@ inline constexpr bool D_CONN_CAM_EN = false;
 inline constexpr auto D_CONN_COMM_ADDRESS = "123.123.123.123";
 inline constexpr auto D_CONN_COMM_PORT = "12345";
 inline constexpr bool D_CONN_COMM_EN = false;
+inline constexpr int D_CONN_COMM_FORMAT = ProtocolConstants::AUTO_FORMAT;
+inline constexpr int D_CONN_COMM_RATE = 1; // 100 Hz
+inline constexpr int D_CONN_COMM_BATCH = 32; // 0 uses the portable Qt receive path
+inline constexpr auto D_CONN_COMM_FLEET = ""; // Empty drives only the single client
+inline constexpr int D_CONN_COMM_SUPPRESS = 2;    // Normal
+inline constexpr int D_CONN_COMM_KEEPALIVE = 200; // Milliseconds between suppressed refreshes
+inline constexpr auto D_CONN_COMM_BIND = ""; // Empty binds to every IPv4 interface
+inline constexpr int D_CONN_COMM_DISCOVERY = 0; // Manual address
+inline constexpr int D_CONN_COMM_STOP = LinkConstants::DEGRADED;
+inline constexpr int D_CONN_COMM_STOP_BUTTON = 2; // B
+inline constexpr int D_CONN_COMM_HORIZON = 1; // 5 points
+inline constexpr int D_CONN_COMM_QUANTIZATION = 0; // 16 bit
+// 0 connects to the robot's own port number over TCP, -1 disables the control channel
+inline constexpr int D_CONN_COMM_CONTROL_PORT = 0;
+inline constexpr int D_CONN_COMM_DRIVE = DriveConstants::MECANUM;
+
+inline constexpr int D_KINEMATICS_KERNEL = KinematicsConstants::CLOSED_FORM_KERNEL;
 
 inline constexpr bool D_GRAPH_PERF_EN = true;
 inline constexpr int D_GRAPH_PERF_QUAL = 2;
@@ -76,10 +320,62 @@ inline constexpr bool D_APPEAR_THEME_DARK_EN = true;
 inline constexpr bool D_APPEAR_THEME_CLOGS_EN = true;
 inline constexpr bool D_APPEAR_THEME_TLOGS_EN = true;
 
+inline constexpr auto D_DEBUG_TRACE = ""; // Comma separated categories, empty traces nothing
+
 inline constexpr int D_WINDOW_SIZE_X = 1920;
 inline constexpr int D_WINDOW_SIZE_Y = 1080;
 } // namespace SettingsConstants
 
+namespace LatencyConstants {
+// Points along the control path that latency is recorded between
+inline constexpr int INPUT_TO_KINEMATICS = 0;
+inline constexpr int KINEMATICS_TO_SEND = 1;
+inline constexpr int INPUT_TO_SEND = 2;
+inline constexpr int SEND_TO_ACK = 3;       // Round trip less client hold time, once per echo
+inline constexpr int SEND_TO_ROBOT = 4;    // One way, needs a synchronized robot clock
+inline constexpr int ROBOT_TO_RECEIVE = 5; // One way, needs a synchronized robot clock
+inline constexpr int STAGE_COUNT = 6;
+
+// Log-linear buckets: 16 linear sub-buckets per power of two of microseconds, which keeps
+// every bucket within ~6% of its value from 1 us up to ~35 minutes.
+inline constexpr int SUB_BUCKET_BITS = 4;
+inline constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+inline constexpr int BUCKET_COUNT = SUB_BUCKETS * 28;
+} // namespace LatencyConstants
+
+namespace TelemetryConstants {
+// Samples kept in the telemetry ring, power of 2. About 3 seconds of 100 Hz IMU, encoder and
+// battery streams.
+inline constexpr int CAPACITY = 1024;
+inline constexpr int TYPE_COUNT = 3; // IMU, encoder and battery, in packet type order
+// Encoder samples older than this no longer drive the simulation, in nanoseconds
+inline constexpr qint64 FRESH_AGE = 200000000;
+inline constexpr int RECORD_INTERVAL = 100; // Recorder poll interval in milliseconds
+} // namespace TelemetryConstants
+
+namespace TraceConstants {
+// Categories, one bit each so they can be switched on and off at runtime with a mask
+inline constexpr quint32 SEND = 1u << 0;
+inline constexpr quint32 RECEIVE = 1u << 1;
+inline constexpr quint32 INPUT = 1u << 2;
+inline constexpr quint32 CAMERA = 1u << 3;
+inline constexpr int CATEGORY_COUNT = 4;
+
+// Events, the comment lists what the three record arguments hold
+inline constexpr quint16 MOVEMENT_SENT = 0;   // Sequence, robot count, 1 if a fresh setpoint
+inline constexpr quint16 SEND_FAILED = 1;     // Robot, error code, bytes written or -1
+inline constexpr quint16 SEND_REPLACED = 2;   // Sequence, first robot still waiting, 0
+inline constexpr quint16 DATAGRAM = 3;        // Sender IPv4 address, sender port, size
+inline constexpr quint16 TEXT_DATAGRAM = 4;   // Robot, size, first 8 bytes little-endian
+inline constexpr quint16 KEY_PRESSED = 5;     // Qt key, 0, 0
+inline constexpr quint16 KEY_RELEASED = 6;    // Qt key, 0, 0
+inline constexpr quint16 CAMERA_CONNECT = 7;  // IPv4 address, port, 0
+inline constexpr int EVENT_COUNT = 8;
+
+// Records kept in the trace ring, power of 2
+inline constexpr int CAPACITY = 4096;
+} // namespace TraceConstants
+
 namespace LoggerConstants {
 inline constexpr int DEBUG = 0;
 inline constexpr int INFO = 1;
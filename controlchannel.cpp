@@ -0,0 +1,229 @@
+#include "controlchannel.h"
+
+#include <algorithm>
+
+ControlChannel::ControlChannel(LoggerHandler *loggerRef, const QString &labelRef)
+{
+    logger = loggerRef;
+    label = labelRef;
+    tcpSocket = nullptr;
+    localSocket = nullptr;
+    device = nullptr;
+    reconnectTimer = nullptr;
+    reconnectDelay = ControlConstants::RECONNECT_MIN;
+    remotePort = 0;
+    active = false;
+}
+
+ControlChannel::~ControlChannel()
+{
+    // Sockets report the abort as a disconnect, which must not reach a half destroyed channel
+    close();
+}
+
+/**
+ * @brief Connects to a robot's control port over TCP, closing any previous connection.
+ * @param Robot address.
+ * @param Robot control port.
+ */
+void ControlChannel::open(const QHostAddress &address, quint16 port)
+{
+    close();
+    remoteAddress = address;
+    remotePort = port;
+    localName.clear();
+    active = true;
+    connectToRobot();
+}
+
+/**
+ * @brief Connects to a simulator's local control server, closing any previous connection.
+ * @param Local server name.
+ */
+void ControlChannel::openLocal(const QString &name)
+{
+    close();
+    localName = name;
+    active = true;
+    connectToRobot();
+}
+
+/**
+ * @brief Drops the connection and stops trying to reconnect. Queued messages are discarded.
+ */
+void ControlChannel::close()
+{
+    active = false;
+    device = nullptr;
+    readBuffer.clear();
+    reconnectDelay = ControlConstants::RECONNECT_MIN;
+    if (reconnectTimer) {
+        reconnectTimer->stop();
+        tcpSocket->abort();
+        localSocket->abort();
+    }
+}
+
+/**
+ * @brief Queues one message on the stream. Messages are not kept while disconnected, the
+ * sender has to repeat whatever the robot needs once connected is emitted again.
+ * @param Message type, one of the ProtocolConstants::CONTROL_* constants.
+ * @param Payload.
+ * @return True if the message was queued, false if not connected or the backlog is full.
+ */
+bool ControlChannel::send(int type, const QByteArray &payload)
+{
+    if (!device) {
+        return false;
+    }
+    qint64 size = ProtocolConstants::CONTROL_HEADER_SIZE + payload.size();
+    if (payload.size() > ControlConstants::MAX_PAYLOAD
+        || device->bytesToWrite() + size > ControlConstants::MAX_BACKLOG) {
+        logger->write(LoggerConstants::WARNING,
+                      QString("Control channel to ") + label
+                          + " is backed up, dropping a message");
+        return false;
+    }
+    ControlHeader header;
+    header.type = (unsigned char) type;
+    header.length = quint32(payload.size());
+    char buffer[ProtocolConstants::CONTROL_HEADER_SIZE];
+    Protocol::encodeControlHeader(header, buffer);
+    device->write(buffer, ProtocolConstants::CONTROL_HEADER_SIZE);
+    device->write(payload);
+    return true;
+}
+
+/**
+ * @brief Creates the sockets on first use, so they belong to the channel's thread.
+ */
+void ControlChannel::initSockets()
+{
+    if (reconnectTimer) {
+        return;
+    }
+    reconnectTimer = new QTimer(this);
+    reconnectTimer->setSingleShot(true);
+    connect(reconnectTimer, &QTimer::timeout, this, &ControlChannel::connectToRobot);
+
+    tcpSocket = new QTcpSocket(this);
+    connect(tcpSocket, &QTcpSocket::connected, this, &ControlChannel::socketConnected);
+    connect(tcpSocket, &QTcpSocket::readyRead, this, &ControlChannel::readFrames);
+    connect(tcpSocket, &QTcpSocket::disconnected, this, [this]() {
+        connectionLost(tcpSocket->errorString());
+    });
+    connect(tcpSocket, &QTcpSocket::errorOccurred, this, [this]() {
+        connectionLost(tcpSocket->errorString());
+    });
+
+    localSocket = new QLocalSocket(this);
+    connect(localSocket, &QLocalSocket::connected, this, &ControlChannel::socketConnected);
+    connect(localSocket, &QLocalSocket::readyRead, this, &ControlChannel::readFrames);
+    connect(localSocket, &QLocalSocket::disconnected, this, [this]() {
+        connectionLost(localSocket->errorString());
+    });
+    connect(localSocket, &QLocalSocket::errorOccurred, this, [this]() {
+        connectionLost(localSocket->errorString());
+    });
+}
+
+/**
+ * @brief Starts a connection attempt to the configured robot.
+ */
+void ControlChannel::connectToRobot()
+{
+    initSockets();
+    if (!active) {
+        return;
+    }
+    readBuffer.clear();
+    if (localName.isEmpty()) {
+        tcpSocket->connectToHost(remoteAddress, remotePort);
+    } else {
+        localSocket->connectToServer(localName);
+    }
+}
+
+/**
+ * @brief Starts using the socket that just connected. A TCP socket gets a small send buffer
+ * and is marked as bulk traffic, so a large transfer queues here instead of in front of the
+ * setpoint datagrams.
+ */
+void ControlChannel::socketConnected()
+{
+    if (localName.isEmpty()) {
+        tcpSocket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption,
+                                   ControlConstants::SEND_BUFFER);
+        tcpSocket->setSocketOption(QAbstractSocket::TypeOfServiceOption,
+                                   ControlConstants::TYPE_OF_SERVICE);
+        device = tcpSocket;
+    } else {
+        device = localSocket;
+    }
+    reconnectDelay = ControlConstants::RECONNECT_MIN;
+    logger->write(LoggerConstants::INFO, QString("Control channel to ") + label + " connected");
+    emit connected();
+}
+
+/**
+ * @brief Handles a failed attempt or a dropped connection by trying again later, each failure
+ * in a row doubling the delay. Sockets report a drop both as an error and as a disconnect, the
+ * running reconnect timer tells the second report apart.
+ * @param Socket error text.
+ */
+void ControlChannel::connectionLost(const QString &error)
+{
+    if (!active || reconnectTimer->isActive()) {
+        return;
+    }
+    // Started before aborting, aborting reports the loss again
+    reconnectTimer->start(reconnectDelay);
+    bool wasConnected = device;
+    device = nullptr;
+    readBuffer.clear();
+    tcpSocket->abort();
+    localSocket->abort();
+
+    if (wasConnected) {
+        logger->write(LoggerConstants::WARNING,
+                      QString("Control channel to ") + label + " lost: " + error);
+        emit disconnected();
+    } else if (reconnectDelay == ControlConstants::RECONNECT_MIN) {
+        logger->write(LoggerConstants::WARNING,
+                      QString("Control channel to ") + label + " failed: " + error
+                          + ", retrying");
+    }
+    reconnectDelay = std::min(reconnectDelay * 2, ControlConstants::RECONNECT_MAX);
+}
+
+/**
+ * @brief Reads whatever arrived and emits every complete frame. A header with a wrong magic
+ * or an impossible length means the stream is out of step, the connection is dropped then.
+ */
+void ControlChannel::readFrames()
+{
+    if (!device) {
+        return;
+    }
+    readBuffer += device->readAll();
+    int offset = 0;
+    ControlHeader header;
+    while (readBuffer.size() - offset >= ProtocolConstants::CONTROL_HEADER_SIZE) {
+        if (!Protocol::decodeControlHeader(readBuffer.constData() + offset,
+                                           readBuffer.size() - offset,
+                                           header)
+            || header.length > quint32(ControlConstants::MAX_PAYLOAD)) {
+            connectionLost("invalid frame");
+            return;
+        }
+        int frameSize = ProtocolConstants::CONTROL_HEADER_SIZE + int(header.length);
+        if (readBuffer.size() - offset < frameSize) {
+            break;
+        }
+        emit messageReceived(header.type,
+                             readBuffer.mid(offset + ProtocolConstants::CONTROL_HEADER_SIZE,
+                                            int(header.length)));
+        offset += frameSize;
+    }
+    readBuffer.remove(0, offset);
+}
@@ -0,0 +1,64 @@
+#ifndef CONTROLCHANNEL_H
+#define CONTROLCHANNEL_H
+
+#include "loggerhandler.h"
+#include "protocol.h"
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QLocalSocket>
+#include <QObject>
+#include <QTcpSocket>
+#include <QTimer>
+
+/**
+ * Reliable stream to one robot for traffic that must arrive but is not time critical, such as
+ * configuration, parameters and log downloads. Messages are framed with a ControlHeader and
+ * travel over TCP, or over a local socket when the robot is a simulator on the shared memory
+ * transport.
+ *
+ * Lives on its own low priority thread, not the communication thread, so a slow or stalled
+ * stream never delays a setpoint datagram. Every method must be called on that thread, the
+ * communication handler queues its calls there. A lost connection is retried with a growing
+ * delay until close is called.
+ */
+class ControlChannel : public QObject
+{
+    Q_OBJECT
+public:
+    ControlChannel(LoggerHandler *loggerRef, const QString &labelRef);
+    ~ControlChannel();
+
+    void open(const QHostAddress &address, quint16 port);
+    void openLocal(const QString &name);
+    void close();
+    bool send(int type, const QByteArray &payload);
+
+signals:
+    void connected();
+    void disconnected();
+    void messageReceived(int type, const QByteArray &payload);
+
+private:
+    LoggerHandler *logger;
+    QString label; // Robot endpoint for log messages
+
+    QTcpSocket *tcpSocket;
+    QLocalSocket *localSocket;
+    QIODevice *device; // Connected socket, nullptr while not connected
+    QTimer *reconnectTimer;
+    int reconnectDelay;
+    QHostAddress remoteAddress;
+    quint16 remotePort;
+    QString localName; // Local server name, empty for TCP
+    bool active;       // Opened and not closed, connection losses are retried
+    QByteArray readBuffer;
+
+    void initSockets();
+    void connectToRobot();
+    void socketConnected();
+    void connectionLost(const QString &error);
+    void readFrames();
+};
+
+#endif // CONTROLCHANNEL_H
@@ -13,7 +13,7 @@ Custom3DWindow::~Custom3DWindow() {}
 void Custom3DWindow::keyPressEvent(QKeyEvent *event)
 {
     if (event->isAutoRepeat() == false) {
-        qDebug() << "test1";
+        TRACE(TraceConstants::INPUT, TraceConstants::KEY_PRESSED, event->key(), 0, 0);
         switch (event->key()) {
         case Qt::Key_W:
             emit passKeyboard_WChanged(true);
@@ -33,6 +33,9 @@ void Custom3DWindow::keyPressEvent(QKeyEvent *event)
         case Qt::Key_E:
             emit passKeyboard_EChanged(true);
             break;
+        case Qt::Key_Space:
+            emit passKeyboard_SpacePressed();
+            break;
         }
     }
 }
@@ -45,6 +48,7 @@ void Custom3DWindow::keyPressEvent(QKeyEvent *event)
 void Custom3DWindow::keyReleaseEvent(QKeyEvent *event)
 {
     if (event->isAutoRepeat() == false) {
+        TRACE(TraceConstants::INPUT, TraceConstants::KEY_RELEASED, event->key(), 0, 0);
         switch (event->key()) {
         case Qt::Key_W:
             emit passKeyboard_WChanged(false);
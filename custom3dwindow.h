@@ -1,7 +1,8 @@
 #ifndef CUSTOM3DWINDOW_H
 #define CUSTOM3DWINDOW_H
 
-#include <QDebug>
+#include "trace.h"
+
 #include <QKeyEvent>
 #include <Qt3DExtras/Qt3DWindow>
 
@@ -18,6 +19,7 @@ signals:
     void passKeyboard_DChanged(bool);
     void passKeyboard_QChanged(bool);
     void passKeyboard_EChanged(bool);
+    void passKeyboard_SpacePressed();
 
 protected:
     void keyPressEvent(QKeyEvent *event);
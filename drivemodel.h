@@ -0,0 +1,167 @@
+#ifndef DRIVEMODEL_H
+#define DRIVEMODEL_H
+
+#include "constants.h"
+
+/**
+ * Drive models as compile-time policies. Each one has a wheel count, short wheel names for the
+ * sliders, a layout for the simulation and a mixing matrix with one row per wheel, which turns
+ * the clamped input into a raw wheel speed:
+ *
+ *     speed = MIX[w][0] x + MIX[w][1] y + MIX[w][2] z
+ *
+ * Speeds follow the handler's conventions. Positive runs a wheel forward, or to the right for a
+ * wheel that rolls across the robot, with mirrored motors already accounted for, and z > 0 turns
+ * clockwise. Wheel w lands in speed slot w, which the sliders, chart series, simulation wheels
+ * and packet fields all show. The slots are FR, BL, FL, BR for mecanum, and a model with fewer
+ * wheels leaves its last slots at zero.
+ *
+ * Layout rows are the side (+1 right), the end (+1 front) and the yaw of the axle in degrees,
+ * 0 for an axle across the robot.
+ */
+struct MecanumDrive
+{
+    static constexpr int WHEEL_COUNT = 4;
+    static constexpr const char *WHEEL_NAMES[WHEEL_COUNT] = {"FR", "BL", "FL", "BR"};
+    // The closed form in kinematics.h, the rollers push each wheel along a diagonal
+    static constexpr double MIX[WHEEL_COUNT][3] = {
+        {-MathConstants::HALF_SQRT2, MathConstants::HALF_SQRT2, -1.0},
+        {-MathConstants::HALF_SQRT2, MathConstants::HALF_SQRT2, 1.0},
+        {MathConstants::HALF_SQRT2, MathConstants::HALF_SQRT2, 1.0},
+        {MathConstants::HALF_SQRT2, MathConstants::HALF_SQRT2, -1.0}};
+    static constexpr double LAYOUT[WHEEL_COUNT][3] = {{1.0, 1.0, 0.0},
+                                                      {-1.0, -1.0, 0.0},
+                                                      {-1.0, 1.0, 0.0},
+                                                      {1.0, -1.0, 0.0}};
+};
+
+/**
+ * Omni wheels on the corners with their axles pointing at the center. Each wheel drives along
+ * the same diagonal a mecanum wheel's rollers push it, so the mixing is the same.
+ */
+struct XDrive
+{
+    static constexpr int WHEEL_COUNT = 4;
+    static constexpr const char *WHEEL_NAMES[WHEEL_COUNT] = {"FR", "BL", "FL", "BR"};
+    static constexpr double MIX[WHEEL_COUNT][3] = {
+        {-MathConstants::HALF_SQRT2, MathConstants::HALF_SQRT2, -1.0},
+        {-MathConstants::HALF_SQRT2, MathConstants::HALF_SQRT2, 1.0},
+        {MathConstants::HALF_SQRT2, MathConstants::HALF_SQRT2, 1.0},
+        {MathConstants::HALF_SQRT2, MathConstants::HALF_SQRT2, -1.0}};
+    static constexpr double LAYOUT[WHEEL_COUNT][3] = {{1.0, 1.0, 45.0},
+                                                      {-1.0, -1.0, 45.0},
+                                                      {-1.0, 1.0, -45.0},
+                                                      {1.0, -1.0, -45.0}};
+};
+
+/**
+ * Omni wheels in a + pattern. The side wheels drive forward, the front and back wheels drive
+ * sideways, and all four turn the robot.
+ */
+struct OmniDrive
+{
+    static constexpr int WHEEL_COUNT = 4;
+    static constexpr const char *WHEEL_NAMES[WHEEL_COUNT] = {"R", "L", "F", "B"};
+    static constexpr double MIX[WHEEL_COUNT][3] = {{0.0, 1.0, -1.0},
+                                                   {0.0, 1.0, 1.0},
+                                                   {1.0, 0.0, 1.0},
+                                                   {1.0, 0.0, -1.0}};
+    static constexpr double LAYOUT[WHEEL_COUNT][3] = {{1.0, 0.0, 0.0},
+                                                      {-1.0, 0.0, 0.0},
+                                                      {0.0, 1.0, 90.0},
+                                                      {0.0, -1.0, 90.0}};
+};
+
+/**
+ * One driven wheel on each side, steered by running them at different speeds. Sideways input
+ * is ignored. The wheels use the slots of the omni side wheels.
+ */
+struct DifferentialDrive
+{
+    static constexpr int WHEEL_COUNT = 2;
+    static constexpr const char *WHEEL_NAMES[WHEEL_COUNT] = {"R", "L"};
+    static constexpr double MIX[WHEEL_COUNT][3] = {{0.0, 1.0, -1.0}, {0.0, 1.0, 1.0}};
+    static constexpr double LAYOUT[WHEEL_COUNT][3] = {{1.0, 0.0, 0.0}, {-1.0, 0.0, 0.0}};
+};
+
+namespace DriveModel {
+/**
+ * @brief Calls a function with the policy of a drive model, so code written once as a generic
+ * lambda is instantiated and inlined for every model. The model is looked up with a switch once
+ * per call, there is no virtual call per wheel or per sample.
+ * @param Model as a constant from DriveConstants, anything else is treated as mecanum.
+ * @param Function taking the policy by value, for example [&](auto drive) { ... }.
+ */
+template<typename Function>
+inline void dispatch(int model, Function &&function)
+{
+    switch (model) {
+    case DriveConstants::X_DRIVE:
+        function(XDrive());
+        break;
+    case DriveConstants::OMNI:
+        function(OmniDrive());
+        break;
+    case DriveConstants::DIFFERENTIAL:
+        function(DifferentialDrive());
+        break;
+    default:
+        function(MecanumDrive());
+        break;
+    }
+}
+
+/**
+ * @brief Gets the number of wheels a drive model has.
+ * @param Model as a constant from DriveConstants.
+ * @return Wheel count, at most DriveConstants::MAX_WHEELS.
+ */
+inline int wheelCount(int model)
+{
+    int count = 0;
+    dispatch(model, [&](auto drive) { count = decltype(drive)::WHEEL_COUNT; });
+    return count;
+}
+
+/**
+ * @brief Gets the name of a wheel of a drive model, as shown on its slider.
+ * @param Model as a constant from DriveConstants.
+ * @param Wheel index, below the model's wheel count.
+ * @return Short wheel name.
+ */
+inline const char *wheelName(int model, int wheel)
+{
+    const char *name = "";
+    dispatch(model, [&](auto drive) { name = decltype(drive)::WHEEL_NAMES[wheel]; });
+    return name;
+}
+
+/**
+ * @brief Gets the mixing row of a wheel of a drive model, for code off the hot path such as
+ * the chart.
+ * @param Model as a constant from DriveConstants.
+ * @param Wheel index, below the model's wheel count.
+ * @return Coefficients of x, y and z.
+ */
+inline const double *mixingRow(int model, int wheel)
+{
+    const double *row = nullptr;
+    dispatch(model, [&](auto drive) { row = decltype(drive)::MIX[wheel]; });
+    return row;
+}
+
+/**
+ * @brief Gets the layout row of a wheel of a drive model.
+ * @param Model as a constant from DriveConstants.
+ * @param Wheel index, below the model's wheel count.
+ * @return Side, end and axle yaw in degrees.
+ */
+inline const double *layoutRow(int model, int wheel)
+{
+    const double *row = nullptr;
+    dispatch(model, [&](auto drive) { row = decltype(drive)::LAYOUT[wheel]; });
+    return row;
+}
+} // namespace DriveModel
+
+#endif // DRIVEMODEL_H
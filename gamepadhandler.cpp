@@ -1,9 +1,26 @@
 #include "gamepadhandler.h"
 
+#include <algorithm>
+#include <iterator>
+
+// Buttons selectable as the emergency stop, indexed by the stop button setting
+static const QGamepadManager::GamepadButton STOP_BUTTONS[] = {QGamepadManager::ButtonInvalid,
+                                                              QGamepadManager::ButtonA,
+                                                              QGamepadManager::ButtonB,
+                                                              QGamepadManager::ButtonX,
+                                                              QGamepadManager::ButtonY,
+                                                              QGamepadManager::ButtonL1,
+                                                              QGamepadManager::ButtonR1,
+                                                              QGamepadManager::ButtonSelect,
+                                                              QGamepadManager::ButtonStart,
+                                                              QGamepadManager::ButtonGuide};
+
 // Constructor
-GamepadHandler::GamepadHandler(LoggerHandler *loggerRef)
+GamepadHandler::GamepadHandler(LoggerHandler *loggerRef, QSettings *settingsRef)
 {
     logger = loggerRef;
+    settings = settingsRef;
+    stopButton = STOP_BUTTONS[SettingsConstants::D_CONN_COMM_STOP_BUTTON];
     gamepadManager = QGamepadManager::instance();
     gamepadList = new QList<int>;
     // Set gamepad as first gamepad in the list at startup (if it exists)
@@ -14,6 +31,31 @@ GamepadHandler::GamepadHandler(LoggerHandler *loggerRef)
         currentGamepadIDPos = NULL;
     }
     connect(gamepadManager, SIGNAL(connectedGamepadsChanged()), this, SLOT(refreshGamepad()));
+
+    // The stop button works on every connected gamepad, not only the current one
+    connect(gamepadManager,
+            &QGamepadManager::gamepadButtonPressEvent,
+            this,
+            [this](int, QGamepadManager::GamepadButton button, double) {
+                if (button == stopButton && !(stopButton == QGamepadManager::ButtonInvalid)) {
+                    emit stopButtonPressed();
+                }
+            });
+    updateWithSettings();
+}
+
+/**
+ * @brief Reads the emergency stop button from the settings.
+ */
+void GamepadHandler::updateWithSettings()
+{
+    int index = std::clamp(settings
+                               ->value(SettingsConstants::CONN_COMM_STOP_BUTTON,
+                                       SettingsConstants::D_CONN_COMM_STOP_BUTTON)
+                               .toInt(),
+                           0,
+                           int(std::size(STOP_BUTTONS)) - 1);
+    stopButton = STOP_BUTTONS[index];
 }
 
 // Methods
@@ -1,24 +1,27 @@
 #ifndef GAMEPADHANDLER_H
 #define GAMEPADHANDLER_H
 
+#include "constants.h"
 #include "loggerhandler.h"
 
 #include <QGamepad>
 #include <QGamepadManager>
 #include <QObject>
+#include <QSettings>
 #include <QtDebug>
 
 class GamepadHandler : public QObject
 {
     Q_OBJECT
 public:
-    GamepadHandler(LoggerHandler *loggerRef);
+    GamepadHandler(LoggerHandler *loggerRef, QSettings *settingsRef);
     bool setCurrentGamepad(int deviceIDPos);
     QGamepad *getCurrentGamepad();
     int getTotalConnected();
 
 public slots:
     bool refreshGamepad();
+    void updateWithSettings();
 
 signals:
     void gamepad_axisLeftXChanged(double);
@@ -43,11 +46,14 @@ signals:
     void gamepad_buttonDownChanged(bool);
     void gamepad_buttonLeftChanged(bool);
     void gamepad_buttonRightChanged(bool);
+    void stopButtonPressed();
 
 private:
     QGamepad *currentGamepad;
     QGamepadManager *gamepadManager;
     LoggerHandler *logger;
+    QSettings *settings;
+    QGamepadManager::GamepadButton stopButton;
     QList<int> *gamepadList;
     int currentGamepadIDPos;
 
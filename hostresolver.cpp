@@ -0,0 +1,109 @@
+#include "hostresolver.h"
+
+#include "constants.h"
+
+HostResolver::HostResolver(QObject *parent)
+    : QObject(parent)
+{
+    clock.start();
+}
+
+/**
+ * @brief Gets the address of a host without waiting for the resolver. A name that is not
+ * cached yet or whose entry expired is looked up in the background, resolved is emitted once
+ * the address is known or changed.
+ * @param Literal address or host name.
+ * @param Set to the address if one is known, left untouched otherwise.
+ * @return True if the address was set, otherwise false.
+ */
+bool HostResolver::lookup(const QString &host, QHostAddress &address)
+{
+    QHostAddress literal;
+    if (literal.setAddress(host)) {
+        address = literal;
+        return true;
+    }
+
+    Entry &entry = cache[host];
+    if (clock.elapsed() >= entry.expires) {
+        start(host);
+    }
+    if (entry.address.isNull()) {
+        return false;
+    }
+    address = entry.address;
+    return true;
+}
+
+/**
+ * @brief Looks a host up again in the background even if its entry did not expire yet, done
+ * when the link to it was lost since the name may point somewhere else by now.
+ * @param Host name, literal addresses are ignored.
+ */
+void HostResolver::refresh(const QString &host)
+{
+    if (!isLiteral(host)) {
+        start(host);
+    }
+}
+
+/**
+ * @brief Checks if a host is written as an address and needs no lookup.
+ * @param Host text.
+ * @return True for IPv4 and IPv6 addresses, false for names.
+ */
+bool HostResolver::isLiteral(const QString &host)
+{
+    QHostAddress address;
+    return address.setAddress(host);
+}
+
+/**
+ * @brief Starts a lookup for a host unless one is in flight, keeping whatever address is
+ * cached for it meanwhile.
+ * @param Host name.
+ */
+void HostResolver::start(const QString &host)
+{
+    Entry &entry = cache[host];
+    if (entry.lookupId >= 0) {
+        return;
+    }
+    entry.lookupId = QHostInfo::lookupHost(host, this, [this, host](const QHostInfo &info) {
+        finished(host, info);
+    });
+}
+
+/**
+ * @brief Takes a lookup result. IPv4 addresses are preferred since the communication socket
+ * binds to IPv4. A failed lookup keeps the previous address, a name that resolved once is
+ * assumed to still be reachable there until a lookup says otherwise.
+ * @param Host name.
+ * @param Lookup result.
+ */
+void HostResolver::finished(const QString &host, const QHostInfo &info)
+{
+    Entry &entry = cache[host];
+    entry.lookupId = -1;
+    QHostAddress address;
+    for (const QHostAddress &candidate : info.addresses()) {
+        if (candidate.protocol() == QAbstractSocket::IPv4Protocol) {
+            address = candidate;
+            break;
+        }
+        if (address.isNull()) {
+            address = candidate;
+        }
+    }
+
+    if (!(info.error() == QHostInfo::NoError) || address.isNull()) {
+        entry.expires = clock.elapsed() + ResolverConstants::FAILURE_TTL;
+        emit failed(host, info.error() == QHostInfo::NoError ? "No address" : info.errorString());
+        return;
+    }
+    entry.expires = clock.elapsed() + ResolverConstants::CACHE_TTL;
+    if (!(entry.address == address)) {
+        entry.address = address;
+        emit resolved(host, address);
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef HOSTRESOLVER_H
+#define HOSTRESOLVER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QHostInfo>
+#include <QObject>
+#include <QString>
+
+/**
+ * Resolves host names without blocking the calling thread. Lookups run on Qt's resolver
+ * threads and the results are cached, so a name is only looked up again once its entry
+ * expired. An expired address keeps being used while the new lookup is in flight. Literal
+ * addresses never reach the resolver. Names ending in .local are resolved through mDNS where
+ * the system resolver supports it.
+ */
+class HostResolver : public QObject
+{
+    Q_OBJECT
+public:
+    HostResolver(QObject *parent = nullptr);
+    bool lookup(const QString &host, QHostAddress &address);
+    void refresh(const QString &host);
+    static bool isLiteral(const QString &host);
+
+signals:
+    void resolved(const QString &host, const QHostAddress &address);
+    void failed(const QString &host, const QString &error);
+
+private:
+    struct Entry
+    {
+        QHostAddress address; // Null until the first lookup succeeded
+        qint64 expires = 0;   // clock time in milliseconds
+        int lookupId = -1;    // -1 while no lookup is in flight
+    };
+
+    QHash<QString, Entry> cache;
+    QElapsedTimer clock;
+
+    void start(const QString &host);
+    void finished(const QString &host, const QHostInfo &info);
+};
+
+#endif // HOSTRESOLVER_H
@@ -1,9 +1,10 @@
 #include "inputhandler.h"
 
 // Constructor
-InputHandler::InputHandler(LoggerHandler *loggerRef)
+InputHandler::InputHandler(LoggerHandler *loggerRef, LatencyTracker *latencyRef)
 {
     logger = loggerRef;
+    latency = latencyRef;
     x = 0.0;
     y = 0.0;
     z = 0.0;
@@ -24,6 +25,7 @@ InputHandler::InputHandler(LoggerHandler *loggerRef)
  */
 void InputHandler::updateSliders()
 {
+    latency->markInput();
     emit inputsChanged(x, y, z);
     setXSlider(x);
     setYSlider(y);
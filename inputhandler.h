@@ -2,6 +2,7 @@
 #define INPUTHANDLER_H
 
 #include "constants.h"
+#include "latencyhistogram.h"
 #include "loggerhandler.h"
 
 #include <QDebug>
@@ -12,7 +13,7 @@ class InputHandler : public QObject
 {
     Q_OBJECT
 public:
-    InputHandler(LoggerHandler *loggerRef);
+    InputHandler(LoggerHandler *loggerRef, LatencyTracker *latencyRef);
 
     double getX();
     double getY();
@@ -41,6 +42,7 @@ signals:
 
 private:
     LoggerHandler *logger;
+    LatencyTracker *latency;
 
     void setX(double value);
     void setY(double value);
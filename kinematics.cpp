@@ -0,0 +1,164 @@
+#include "kinematics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Below are the core equations of the kinematics, understanding the math
+// behind them can greatly help anyone understand how speeds values are
+// calculated in a mechanum based system. Implementing z is a little confusing
+// and might be hard to understand when first being looked at.
+
+/**
+ * @brief Calculates the moving speed of the Front Right.
+ * @param Direction of force.
+ * @param Magnitude of force (how fast).
+ * @param Z coordinate of input (rotation around the center).
+ * @return Speed of Front Right
+ */
+double calculateFRSpeed(double direction, double magnitude, double z)
+{
+    return ((((double) sin(direction - (1.0 / 4.0 * MathConstants::PI))) * magnitude) + z);
+}
+
+/**
+ * @brief Calculates the moving speed of the Back Left.
+ * @param Direction of force.
+ * @param Magnitude of force (how fast).
+ * @param Z coordinate of input.
+ * @return Speed of Back Left.
+ */
+double calculateBLSpeed(double direction, double magnitude, double z)
+{
+    return ((((double) -sin(direction - (1.0 / 4.0 * MathConstants::PI))) * magnitude) + z);
+}
+
+/**
+ * @brief Calculates the moving speed of the Front Left.
+ * @param Direction of force.
+ * @param Magnitude of force (how fast).
+ * @param Z coordinate of input.
+ * @return Speed of Front Left
+ */
+double calculateFLSpeed(double direction, double magnitude, double z)
+{
+    return ((((double) -sin(direction + (1.0 / 4.0 * MathConstants::PI))) * magnitude) + z);
+}
+
+/**
+ * @brief Calculates the moving speed of the Back Right.
+ * @param Direction of force.
+ * @param Magnitude of force (how fast).
+ * @param Z coordinate of input.
+ * @return Speed of Back Right.
+ */
+double calculateBRSpeed(double direction, double magnitude, double z)
+{
+    return ((((double) sin(direction + (1.0 / 4.0 * MathConstants::PI))) * magnitude) + z);
+}
+} // namespace
+
+/**
+ * @brief Computes the raw wheel speeds from direction and magnitude with one sine per wheel,
+ * the reference the closed form kernel is checked against.
+ * @param X coordinate of input.
+ * @param Y coordinate of input.
+ * @param Z coordinate of input.
+ * @param Array of 4 speeds to fill, FR, BL, FL, BR.
+ */
+void Kinematics::trigSpeeds(double x, double y, double z, double *speeds)
+{
+    z = -z;
+    double dir = calculateDirection(x, y);
+    double mag = calculateMagnitude(x, y);
+    speeds[0] = calculateFRSpeed(dir, mag, z);
+    speeds[1] = -calculateBLSpeed(dir, mag, z);
+    speeds[2] = -calculateFLSpeed(dir, mag, z);
+    speeds[3] = calculateBRSpeed(dir, mag, z);
+}
+
+/**
+ * @brief Computes the raw wheel speeds as linear combinations of the input, see kinematics.h
+ * for the derivation and drivemodel.h for the matrix.
+ * @param X coordinate of input.
+ * @param Y coordinate of input.
+ * @param Z coordinate of input.
+ * @param Array of 4 speeds to fill, FR, BL, FL, BR.
+ */
+void Kinematics::closedFormSpeeds(double x, double y, double z, double *speeds)
+{
+    mixSpeeds<MecanumDrive>(x, y, z, speeds);
+}
+
+/**
+ * @brief Computes the raw wheel speeds with the selected kernel.
+ * @param Kernel as a constant from KinematicsConstants.
+ * @param X coordinate of input.
+ * @param Y coordinate of input.
+ * @param Z coordinate of input.
+ * @param Array of 4 speeds to fill, FR, BL, FL, BR.
+ */
+void Kinematics::calculateSpeeds(int kernel, double x, double y, double z, double *speeds)
+{
+    if (kernel == KinematicsConstants::CLOSED_FORM_KERNEL) {
+        closedFormSpeeds(x, y, z, speeds);
+    } else {
+        trigSpeeds(x, y, z, speeds);
+    }
+}
+
+/**
+ * @brief Truncates raw speeds and scales them so the fastest wheel runs at full speed.
+ * @param Array of 4 speeds, changed in place.
+ * @return Scale factor, the largest truncated speed before scaling.
+ */
+double Kinematics::normalize(double *speeds)
+{
+    // Truncate floating points to get rid of unessary points of uncertainty
+    // This is done because they are compared later in the program, and helps
+    // avoid floating point rounding errors by dropping them.
+    for (int i = 0; i < 4; i++) {
+        speeds[i] = (double) ((int) (speeds[i] * 100000) / 100000.0);
+    }
+
+    double scaleFactor = 0.0;
+
+    // Find highest
+    for (int i = 0; i < 4; i++) {
+        if (scaleFactor < std::abs(speeds[i])) {
+            scaleFactor = std::abs(speeds[i]);
+        }
+    }
+
+    // Scale all non-zero numbers
+    for (int i = 0; i < 4; i++) {
+        if (speeds[i] != 0) {
+            speeds[i] = speeds[i] / scaleFactor;
+        }
+    }
+    return scaleFactor;
+}
+
+/**
+ * @brief Calculates the magnituide or speed of the force in the applied
+ * direction.
+ * @param X coordinate of input.
+ * @param Y coordinate of input.
+ * @return Magnitude of force.
+ */
+double Kinematics::calculateMagnitude(double x, double y)
+{
+    return (std::clamp(((double) sqrt(pow(y, 2) + pow(x, 2))), IOConstants::MIN, IOConstants::MAX));
+}
+
+/**
+ * @brief Calculates the direction of force the speeds need to end up pointing
+ * to.
+ * @param X coordinate of input.
+ * @param Y coordinate of input.
+ * @return Direction of force.
+ */
+double Kinematics::calculateDirection(double x, double y)
+{
+    return atan2(y, x);
+}
@@ -0,0 +1,93 @@
+#ifndef KINEMATICS_H
+#define KINEMATICS_H
+
+#include "constants.h"
+#include "drivemodel.h"
+
+#include <QtGlobal>
+
+#include <cmath>
+
+/**
+ * Inputs and outputs of a batch evaluation as structure of arrays, count entries each. The
+ * output arrays receive the normalized speeds updateSpeeds would emit for each input and must
+ * not overlap the inputs. Only the drive model's wheels are written, the arrays of the slots
+ * after them may be nullptr.
+ */
+struct KinematicsBatch
+{
+    const double *x;
+    const double *y;
+    const double *z;
+    double *speeds[DriveConstants::MAX_WHEELS]; // Speed slots, FR, BL, FL, BR for mecanum
+    qint64 count;
+};
+
+/**
+ * Drive kinematics without any Qt objects, shared by KinematicsHandler and the tools. Mecanum
+ * wheel speeds are written in the order FR, BL, FL, BR, with the back left and front left wheels
+ * already mirrored as the handler emits them.
+ *
+ * Two kernels compute the same raw speeds. The trig kernel turns the input into a direction
+ * and magnitude and takes the sine of the direction for each wheel. The closed form kernel
+ * uses sin(a -+ pi/4) = (sin a -+ cos a) / sqrt(2), which with sin a = y / r and cos a = x / r
+ * leaves
+ *
+ *     FR = s (y - x) - z    BL = s (y - x) + z    FL = s (y + x) + z    BR = s (y + x) - z
+ *
+ * where s is 1 / sqrt(2), scaled down by the magnitude clamp when the input lies outside the
+ * unit circle. A square root is only taken in that case. tools/kinematicsbench checks that the
+ * kernels agree and measures both.
+ *
+ * The closed form kernel is mixSpeeds instantiated for MecanumDrive. The other drive models in
+ * drivemodel.h go through the same template with their own mixing matrix, the trig kernel only
+ * exists for mecanum.
+ *
+ * Batches of inputs are evaluated with calculateBatch. The mixing kernels then run on SSE2 or
+ * AVX2, whichever is the best the CPU supports, and fall back to the scalar code elsewhere.
+ * Every path gives the same results as the scalar one.
+ */
+namespace Kinematics {
+void trigSpeeds(double x, double y, double z, double *speeds);
+void closedFormSpeeds(double x, double y, double z, double *speeds);
+void calculateSpeeds(int kernel, double x, double y, double z, double *speeds);
+double normalize(double *speeds);
+double calculateMagnitude(double x, double y);
+double calculateDirection(double x, double y);
+
+void calculateBatch(int model, int kernel, const KinematicsBatch &batch);
+void calculateBatchWith(int model, int path, const KinematicsBatch &batch);
+bool isBatchPathSupported(int path);
+int batchPath();
+
+/**
+ * @brief Computes the raw wheel speeds of a drive model from its mixing matrix. Inputs outside
+ * the unit circle are clamped to it first, a square root is only taken then. The wheel loops
+ * have constant bounds and coefficients, so each instantiation compiles to straight line
+ * multiply-adds.
+ * @param X coordinate of input.
+ * @param Y coordinate of input.
+ * @param Z coordinate of input.
+ * @param Array of DriveConstants::MAX_WHEELS speeds to fill, unused slots are set to zero.
+ */
+template<typename Model>
+inline void mixSpeeds(double x, double y, double z, double *speeds)
+{
+    static_assert(Model::WHEEL_COUNT <= DriveConstants::MAX_WHEELS, "Too many wheels");
+    double squared = x * x + y * y;
+    if (squared > IOConstants::MAX * IOConstants::MAX) {
+        // Magnitude clamp, the input is cut back to the unit circle
+        double clamp = IOConstants::MAX / std::sqrt(squared);
+        x *= clamp;
+        y *= clamp;
+    }
+    for (int w = 0; w < Model::WHEEL_COUNT; w++) {
+        speeds[w] = Model::MIX[w][0] * x + Model::MIX[w][1] * y + Model::MIX[w][2] * z;
+    }
+    for (int w = Model::WHEEL_COUNT; w < DriveConstants::MAX_WHEELS; w++) {
+        speeds[w] = 0.0;
+    }
+}
+} // namespace Kinematics
+
+#endif // KINEMATICS_H
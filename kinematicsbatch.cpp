@@ -0,0 +1,218 @@
+#include "kinematics.h"
+
+// The vector paths are compiled for their instruction set on their own, so the rest of the
+// program keeps running on CPUs without it. The CPU is checked before they are called.
+#if defined(Q_PROCESSOR_X86) && (defined(Q_CC_GNU) || defined(Q_CC_CLANG))
+#define KINEMATICS_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+/**
+ * @brief Evaluates a range of a batch one input at a time. Also finishes the inputs left over
+ * by the vector paths.
+ * @param Speeds function, a mixing kernel or the mecanum trig kernel.
+ * @param Number of wheels the function fills.
+ * @param Batch to evaluate.
+ * @param First input to evaluate, the rest up to the end of the batch follow.
+ */
+template<typename Speeds>
+void scalarBatch(Speeds calculate, int wheels, const KinematicsBatch &batch, qint64 begin)
+{
+    for (qint64 i = begin; i < batch.count; i++) {
+        double speeds[DriveConstants::MAX_WHEELS];
+        calculate(batch.x[i], batch.y[i], batch.z[i], speeds);
+        Kinematics::normalize(speeds);
+        for (int w = 0; w < wheels; w++) {
+            batch.speeds[w][i] = speeds[w];
+        }
+    }
+}
+
+#ifdef KINEMATICS_SIMD
+/**
+ * @brief Evaluates a batch with a drive model's mixing kernel, 2 inputs per instruction. Every
+ * lane goes through the same operations as Kinematics::mixSpeeds and normalize, the clamp and
+ * the zero check are done with masks instead of branches. Slots without a wheel are zero in
+ * the scalar code and change neither the largest speed nor the scaling, so they are skipped.
+ * @param Batch to evaluate.
+ * @return Number of inputs evaluated, a multiple of 2.
+ */
+template<typename Model>
+__attribute__((target("sse2"))) qint64 sse2Batch(const KinematicsBatch &batch)
+{
+    const __m128d limit = _mm_set1_pd(IOConstants::MAX);
+    const __m128d steps = _mm_set1_pd(100000.0);
+    const __m128d signBit = _mm_set1_pd(-0.0);
+    const __m128d zero = _mm_setzero_pd();
+
+    qint64 i = 0;
+    for (; i + 2 <= batch.count; i += 2) {
+        __m128d x = _mm_loadu_pd(batch.x + i);
+        __m128d y = _mm_loadu_pd(batch.y + i);
+        __m128d z = _mm_loadu_pd(batch.z + i);
+
+        // min(1, 1 / r) is the magnitude clamp, at r = 0 it is min(1, inf)
+        __m128d squared = _mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y));
+        __m128d clamp = _mm_min_pd(limit, _mm_div_pd(limit, _mm_sqrt_pd(squared)));
+        x = _mm_mul_pd(x, clamp);
+        y = _mm_mul_pd(y, clamp);
+        __m128d speeds[Model::WHEEL_COUNT];
+        for (int w = 0; w < Model::WHEEL_COUNT; w++) {
+            speeds[w] = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(Model::MIX[w][0]), x),
+                                              _mm_mul_pd(_mm_set1_pd(Model::MIX[w][1]), y)),
+                                   _mm_mul_pd(_mm_set1_pd(Model::MIX[w][2]), z));
+        }
+
+        // Truncated through a 32 bit integer, exactly like the scalar cast
+        __m128d largest = zero;
+        for (int w = 0; w < Model::WHEEL_COUNT; w++) {
+            __m128i truncated = _mm_cvttpd_epi32(_mm_mul_pd(speeds[w], steps));
+            speeds[w] = _mm_div_pd(_mm_cvtepi32_pd(truncated), steps);
+            largest = _mm_max_pd(largest, _mm_andnot_pd(signBit, speeds[w]));
+        }
+        for (int w = 0; w < Model::WHEEL_COUNT; w++) {
+            __m128d nonZero = _mm_cmpneq_pd(speeds[w], zero);
+            __m128d scaled = _mm_div_pd(speeds[w], largest);
+            speeds[w] = _mm_or_pd(_mm_and_pd(nonZero, scaled), _mm_andnot_pd(nonZero, speeds[w]));
+            _mm_storeu_pd(batch.speeds[w] + i, speeds[w]);
+        }
+    }
+    return i;
+}
+
+/**
+ * @brief Evaluates a batch with a drive model's mixing kernel, 4 inputs per instruction. Same
+ * steps as sse2Batch.
+ * @param Batch to evaluate.
+ * @return Number of inputs evaluated, a multiple of 4.
+ */
+template<typename Model>
+__attribute__((target("avx2"))) qint64 avx2Batch(const KinematicsBatch &batch)
+{
+    const __m256d limit = _mm256_set1_pd(IOConstants::MAX);
+    const __m256d steps = _mm256_set1_pd(100000.0);
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    const __m256d zero = _mm256_setzero_pd();
+
+    qint64 i = 0;
+    for (; i + 4 <= batch.count; i += 4) {
+        __m256d x = _mm256_loadu_pd(batch.x + i);
+        __m256d y = _mm256_loadu_pd(batch.y + i);
+        __m256d z = _mm256_loadu_pd(batch.z + i);
+
+        __m256d squared = _mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y));
+        __m256d clamp = _mm256_min_pd(limit, _mm256_div_pd(limit, _mm256_sqrt_pd(squared)));
+        x = _mm256_mul_pd(x, clamp);
+        y = _mm256_mul_pd(y, clamp);
+        __m256d speeds[Model::WHEEL_COUNT];
+        for (int w = 0; w < Model::WHEEL_COUNT; w++) {
+            speeds[w] = _mm256_add_pd(
+                _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(Model::MIX[w][0]), x),
+                              _mm256_mul_pd(_mm256_set1_pd(Model::MIX[w][1]), y)),
+                _mm256_mul_pd(_mm256_set1_pd(Model::MIX[w][2]), z));
+        }
+
+        __m256d largest = zero;
+        for (int w = 0; w < Model::WHEEL_COUNT; w++) {
+            __m128i truncated = _mm256_cvttpd_epi32(_mm256_mul_pd(speeds[w], steps));
+            speeds[w] = _mm256_div_pd(_mm256_cvtepi32_pd(truncated), steps);
+            largest = _mm256_max_pd(largest, _mm256_andnot_pd(signBit, speeds[w]));
+        }
+        for (int w = 0; w < Model::WHEEL_COUNT; w++) {
+            __m256d nonZero = _mm256_cmp_pd(speeds[w], zero, _CMP_NEQ_UQ);
+            __m256d scaled = _mm256_div_pd(speeds[w], largest);
+            speeds[w] = _mm256_blendv_pd(speeds[w], scaled, nonZero);
+            _mm256_storeu_pd(batch.speeds[w] + i, speeds[w]);
+        }
+    }
+    return i;
+}
+#endif
+} // namespace
+
+/**
+ * @brief Evaluates every input of a batch without emitting anything, for replaying logs,
+ * planning and sweeps. Mixing kernels run on the best vector path the CPU has, the mecanum
+ * trig kernel stays scalar.
+ * @param Model as a constant from DriveConstants.
+ * @param Kernel as a constant from KinematicsConstants, only used for mecanum.
+ * @param Batch to evaluate.
+ */
+void Kinematics::calculateBatch(int model, int kernel, const KinematicsBatch &batch)
+{
+    if (model == DriveConstants::MECANUM && !(kernel == KinematicsConstants::CLOSED_FORM_KERNEL)) {
+        scalarBatch(trigSpeeds, MecanumDrive::WHEEL_COUNT, batch, 0);
+    } else {
+        calculateBatchWith(model, batchPath(), batch);
+    }
+}
+
+/**
+ * @brief Evaluates a batch with a drive model's mixing kernel on a given path, so paths can be
+ * compared. Falls back to the scalar path if the CPU does not support the one asked for.
+ * @param Model as a constant from DriveConstants.
+ * @param Path as a constant from KinematicsConstants.
+ * @param Batch to evaluate.
+ */
+void Kinematics::calculateBatchWith(int model, int path, const KinematicsBatch &batch)
+{
+    DriveModel::dispatch(model, [&](auto drive) {
+        using Model = decltype(drive);
+        qint64 done = 0;
+#ifdef KINEMATICS_SIMD
+        if (path == KinematicsConstants::AVX2_BATCH && isBatchPathSupported(path)) {
+            done = avx2Batch<Model>(batch);
+        } else if (path == KinematicsConstants::SSE2_BATCH && isBatchPathSupported(path)) {
+            done = sse2Batch<Model>(batch);
+        }
+#else
+        Q_UNUSED(path)
+#endif
+        // A lambda rather than a function pointer, so the kernel inlines into the loop
+        scalarBatch(
+            [](double x, double y, double z, double *speeds) {
+                mixSpeeds<Model>(x, y, z, speeds);
+            },
+            Model::WHEEL_COUNT,
+            batch,
+            done);
+    });
+}
+
+/**
+ * @brief Checks if a batch path was compiled in and the CPU can run it.
+ * @param Path as a constant from KinematicsConstants.
+ * @return True if calculateBatchWith runs the path as asked, otherwise false.
+ */
+bool Kinematics::isBatchPathSupported(int path)
+{
+    switch (path) {
+    case KinematicsConstants::SCALAR_BATCH:
+        return true;
+#ifdef KINEMATICS_SIMD
+    case KinematicsConstants::SSE2_BATCH:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+    case KinematicsConstants::AVX2_BATCH:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Gets the fastest batch path this CPU supports, looked up once.
+ * @return Path as a constant from KinematicsConstants.
+ */
+int Kinematics::batchPath()
+{
+    static const int path = isBatchPathSupported(KinematicsConstants::AVX2_BATCH)
+                                ? KinematicsConstants::AVX2_BATCH
+                            : isBatchPathSupported(KinematicsConstants::SSE2_BATCH)
+                                ? KinematicsConstants::SSE2_BATCH
+                                : KinematicsConstants::SCALAR_BATCH;
+    return path;
+}
@@ -1,128 +1,90 @@
 #include "kinematicshandler.h"
 
+#include <algorithm>
+
 // Constructor
-KinematicsHandler::KinematicsHandler(LoggerHandler *loggerRef)
+KinematicsHandler::KinematicsHandler(LoggerHandler *loggerRef,
+                                     QSettings *settingsRef,
+                                     LatencyTracker *latencyRef)
 {
     logger = loggerRef;
-    for (int i = 0; i < 4; i++) {
+    settings = settingsRef;
+    latency = latencyRef;
+    kernel = SettingsConstants::D_KINEMATICS_KERNEL;
+    driveModel = SettingsConstants::D_CONN_COMM_DRIVE;
+    for (int i = 0; i < DriveConstants::MAX_WHEELS; i++) {
         speeds[i] = 0.0;
     }
 }
 
 /**
- * @brief Calls methods needed to update speeds FRBL and FLBR. Also emits
- * signals to help notify liseners of the respective changes.
+ * @brief Calls methods needed to update the wheel speeds of the selected drive model. Also emits
+ * signals to help notify liseners of the respective changes. Slots past the model's wheel count
+ * are emitted as zero.
  * @param X coordinate of input.
  * @param Y coordinate of input.
  * @param Z coordinate of input.
  */
 void KinematicsHandler::updateSpeeds(double x, double y, double z)
 {
-    z = -z;
-    double dir = calculateDirection(x, y);
-    double mag = calculateMagnitude(x, y);
-
-    // Truncate floating points to get rid of unessary points of uncertainty
-    // This is done because they are compared later in the program, and helps
-    // avoid floating point rounding errors by dropping them.
-    speeds[0] = (double) ((int) (calculateFRSpeed(dir, mag, z) * 100000) / 100000.0);  //FR
-    speeds[1] = (double) ((int) (-calculateBLSpeed(dir, mag, z) * 100000) / 100000.0); //BL
-    speeds[2] = (double) ((int) (-calculateFLSpeed(dir, mag, z) * 100000) / 100000.0); //FL
-    speeds[3] = (double) ((int) (calculateBRSpeed(dir, mag, z) * 100000) / 100000.0);  //BR
-
-    double scaleFactor = 0.0;
-
-    // Find highest
-    for (int i = 0; i < 4; i++) {
-        if (scaleFactor < abs(speeds[i])) {
-            scaleFactor = abs(speeds[i]);
-        }
+    if (driveModel == DriveConstants::MECANUM) {
+        Kinematics::calculateSpeeds(kernel, x, y, z, speeds);
+    } else {
+        DriveModel::dispatch(driveModel, [&](auto drive) {
+            Kinematics::mixSpeeds<decltype(drive)>(x, y, z, speeds);
+        });
     }
+    double scaleFactor = Kinematics::normalize(speeds);
 
-    // Scale all non-zero numbers
-    for (int i = 0; i < 4; i++) {
-        if (speeds[i] != 0) {
-            speeds[i] = speeds[i] / scaleFactor;
-        }
-    }
+    qint64 computed = LatencyTracker::now();
+    latency->record(LatencyConstants::INPUT_TO_KINEMATICS, computed - latency->lastInput());
+    latency->markKinematics(computed);
 
     emit speedsChanged(speeds[0], speeds[1], speeds[2], speeds[3]);
-    emit functionChanged(dir, mag, z, scaleFactor);
-}
-
-/**
- * @brief Calculates the magnituide or speed of the force in the applied
- * direction.
- * @param X coordinate of input.
- * @param Y coordinate of input.
- * @return Magnitude of force.
- */
-double KinematicsHandler::calculateMagnitude(double x, double y)
-{
-    return (std::clamp(((double) sqrt(pow(y, 2) + pow(x, 2))), IOConstants::MIN, IOConstants::MAX));
+    // Direction and magnitude only feed the chart and the simulation arrow, so they are worked
+    // out after the speeds went out
+    emit functionChanged(Kinematics::calculateDirection(x, y),
+                         Kinematics::calculateMagnitude(x, y),
+                         -z,
+                         scaleFactor);
 }
 
 /**
- * @brief Calculates the direction of force the speeds need to end up pointing
- * to.
- * @param X coordinate of input.
- * @param Y coordinate of input.
- * @return Direction of force.
+ * @brief Evaluates many inputs at once with the selected drive model and kernel. Nothing is
+ * emitted and no latency is recorded, the live speeds are left alone.
+ * @param Batch to evaluate.
  */
-double KinematicsHandler::calculateDirection(double x, double y)
+void KinematicsHandler::calculateBatch(const KinematicsBatch &batch) const
 {
-    return atan2(y, x);
+    Kinematics::calculateBatch(driveModel, kernel, batch);
 }
 
-// Below are the core equations of the kinematics, understanding the math
-// behind them can greatly help anyone understand how speeds values are
-// calculated in a mechanum based system. Implementing z is a little confusing
-// and might be hard to understand when first being looked at.
-
 /**
- * @brief Calculates the moving speed of the Front Right.
- * @param Direction of force.
- * @param Magnitude of force (how fast).
- * @param Z coordinate of input (rotation around the center).
- * @return Speed of Front Right
+ * @brief Picks the drive model and the kinematics kernel. The kernel is not exposed in the UI,
+ * both kernels give the same speeds and the trig one is kept as a reference.
  */
-double KinematicsHandler::calculateFRSpeed(double direction, double magnitude, double z)
+void KinematicsHandler::updateWithSettings()
 {
-    return ((((double) sin(direction - (1.0 / 4.0 * MathConstants::PI))) * magnitude) + z);
-}
-
-/**
- * @brief Calculates the moving speed of the Back Left.
- * @param Direction of force.
- * @param Magnitude of force (how fast).
- * @param Z coordinate of input.
- * @return Speed of Back Left.
- */
-double KinematicsHandler::calculateBLSpeed(double direction, double magnitude, double z)
-{
-    return ((((double) -sin(direction - (1.0 / 4.0 * MathConstants::PI))) * magnitude) + z);
-}
-
-/**
- * @brief Calculates the moving speed of the Front Left.
- * @param Direction of force.
- * @param Magnitude of force (how fast).
- * @param Z coordinate of input.
- * @return Speed of Front Left
- */
-double KinematicsHandler::calculateFLSpeed(double direction, double magnitude, double z)
-{
-    return ((((double) -sin(direction + (1.0 / 4.0 * MathConstants::PI))) * magnitude) + z);
-}
-
-/**
- * @brief Calculates the moving speed of the Back Right.
- * @param Direction of force.
- * @param Magnitude of force (how fast).
- * @param Z coordinate of input.
- * @return Speed of Back Right.
- */
-double KinematicsHandler::calculateBRSpeed(double direction, double magnitude, double z)
-{
-    return ((((double) sin(direction + (1.0 / 4.0 * MathConstants::PI))) * magnitude) + z);
+    int selected = std::clamp(settings
+                                  ->value(SettingsConstants::KINEMATICS_KERNEL,
+                                          SettingsConstants::D_KINEMATICS_KERNEL)
+                                  .toInt(),
+                              0,
+                              KinematicsConstants::KERNEL_COUNT - 1);
+    if (!(selected == kernel)) {
+        kernel = selected;
+        logger->write(LoggerConstants::INFO,
+                      QString("Kinematics kernel: ") + KinematicsConstants::KERNEL_NAMES[kernel]);
+    }
+    int model = std::clamp(settings
+                               ->value(SettingsConstants::CONN_COMM_DRIVE,
+                                       SettingsConstants::D_CONN_COMM_DRIVE)
+                               .toInt(),
+                           0,
+                           DriveConstants::MODEL_COUNT - 1);
+    if (!(model == driveModel)) {
+        driveModel = model;
+        logger->write(LoggerConstants::INFO,
+                      QString("Drive model: ") + DriveConstants::MODEL_NAMES[driveModel]);
+    }
 }
@@ -2,20 +2,23 @@
 #define KINEMATICSHANDLER_H
 
 #include "constants.h"
+#include "kinematics.h"
+#include "latencyhistogram.h"
 #include "loggerhandler.h"
 
-#include <math.h>
-#include <QDebug>
 #include <QObject>
+#include <QSettings>
 
 class KinematicsHandler : public QObject
 {
     Q_OBJECT
 public:
-    KinematicsHandler(LoggerHandler *loggerRef);
+    KinematicsHandler(LoggerHandler *loggerRef, QSettings *settingsRef, LatencyTracker *latencyRef);
+    void calculateBatch(const KinematicsBatch &batch) const;
 
 public slots:
     void updateSpeeds(double, double, double);
+    void updateWithSettings();
 
 signals:
     void speedsChanged(double, double, double, double);
@@ -23,13 +26,11 @@ signals:
 
 private:
     LoggerHandler *logger;
-    double speeds[4];
-    double calculateMagnitude(double x, double y);
-    double calculateDirection(double x, double y);
-    double calculateFRSpeed(double direction, double magnitude, double z);
-    double calculateBLSpeed(double direction, double magnitude, double z);
-    double calculateFLSpeed(double direction, double magnitude, double z);
-    double calculateBRSpeed(double direction, double magnitude, double z);
+    QSettings *settings;
+    LatencyTracker *latency;
+    int kernel;     // KinematicsConstants kernel the mecanum speeds are computed with
+    int driveModel; // DriveConstants model the speeds are mixed for
+    double speeds[DriveConstants::MAX_WHEELS];
 };
 
 #endif // KINEMATICSHANDLER_H
@@ -0,0 +1,292 @@
+#include "latencyhistogram.h"
+
+#include <chrono>
+#include <QFile>
+#include <QTextStream>
+#include <QtAlgorithms>
+
+// Constructor
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+/**
+ * @brief Records a single latency sample. Safe to call from any thread.
+ * @param Latency in nanoseconds, negative samples are ignored.
+ */
+void LatencyHistogram::record(qint64 nanoseconds)
+{
+    if (nanoseconds < 0) {
+        return;
+    }
+    qint64 microseconds = nanoseconds / 1000;
+    buckets[bucketIndex(microseconds)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+
+    qint64 previous = maximum.load(std::memory_order_relaxed);
+    while (microseconds > previous
+           && !maximum.compare_exchange_weak(previous, microseconds, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Clears all recorded samples.
+ */
+void LatencyHistogram::reset()
+{
+    for (int i = 0; i < LatencyConstants::BUCKET_COUNT; i++) {
+        buckets[i].store(0, std::memory_order_relaxed);
+    }
+    total.store(0, std::memory_order_relaxed);
+    maximum.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the number of recorded samples.
+ * @return Sample count.
+ */
+quint64 LatencyHistogram::count() const
+{
+    return total.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the latency below which the given percent of samples fall.
+ * @param Percent between 0 and 100.
+ * @return Upper bound of the matching bucket in microseconds, 0 if nothing was recorded.
+ */
+qint64 LatencyHistogram::percentile(double percent) const
+{
+    quint64 samples = count();
+    if (samples == 0) {
+        return 0;
+    }
+    quint64 target = quint64(samples * percent / 100.0 + 0.5);
+    target = qBound(quint64(1), target, samples);
+
+    quint64 seen = 0;
+    for (int i = 0; i < LatencyConstants::BUCKET_COUNT; i++) {
+        seen += bucketCount(i);
+        if (seen >= target) {
+            return qMin(bucketUpperBound(i), max());
+        }
+    }
+    return max();
+}
+
+/**
+ * @brief Gets the largest recorded latency.
+ * @return Latency in microseconds.
+ */
+qint64 LatencyHistogram::max() const
+{
+    return maximum.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the number of samples in a single bucket.
+ * @param Bucket index.
+ * @return Sample count.
+ */
+quint64 LatencyHistogram::bucketCount(int index) const
+{
+    return buckets[index].load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Finds the bucket a latency falls into. The first SUB_BUCKETS buckets are 1 us wide,
+ * after that every power of two is split into SUB_BUCKETS equal buckets.
+ * @param Latency in microseconds.
+ * @return Bucket index.
+ */
+int LatencyHistogram::bucketIndex(qint64 microseconds)
+{
+    if (microseconds < LatencyConstants::SUB_BUCKETS) {
+        return int(microseconds);
+    }
+    int exponent = 63 - int(qCountLeadingZeroBits(quint64(microseconds)));
+    int group = exponent - LatencyConstants::SUB_BUCKET_BITS + 1;
+    int sub = int(microseconds >> (group - 1)) - LatencyConstants::SUB_BUCKETS;
+    int index = group * LatencyConstants::SUB_BUCKETS + sub;
+    return qMin(index, LatencyConstants::BUCKET_COUNT - 1);
+}
+
+/**
+ * @brief Gets the smallest latency that falls into a bucket.
+ * @param Bucket index.
+ * @return Latency in microseconds.
+ */
+qint64 LatencyHistogram::bucketLowerBound(int index)
+{
+    int group = index / LatencyConstants::SUB_BUCKETS;
+    int sub = index % LatencyConstants::SUB_BUCKETS;
+    if (group == 0) {
+        return sub;
+    }
+    return qint64(LatencyConstants::SUB_BUCKETS + sub) << (group - 1);
+}
+
+/**
+ * @brief Gets the largest latency that falls into a bucket.
+ * @param Bucket index.
+ * @return Latency in microseconds.
+ */
+qint64 LatencyHistogram::bucketUpperBound(int index)
+{
+    int group = index / LatencyConstants::SUB_BUCKETS;
+    if (group == 0) {
+        return index;
+    }
+    return bucketLowerBound(index) + (qint64(1) << (group - 1)) - 1;
+}
+
+// Constructor
+LatencyTracker::LatencyTracker()
+    : inputTime(0)
+    , kinematicsTime(0)
+{}
+
+/**
+ * @brief Gets the monotonic time shared by every recording point.
+ * @return Time in nanoseconds.
+ */
+qint64 LatencyTracker::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * @brief Marks the time of the latest input event.
+ */
+void LatencyTracker::markInput()
+{
+    inputTime.store(now(), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Marks the time the latest kinematics update was computed.
+ * @param Time in nanoseconds.
+ */
+void LatencyTracker::markKinematics(qint64 time)
+{
+    kinematicsTime.store(time, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the time of the latest input event.
+ * @return Time in nanoseconds.
+ */
+qint64 LatencyTracker::lastInput() const
+{
+    return inputTime.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the time of the latest kinematics update.
+ * @return Time in nanoseconds.
+ */
+qint64 LatencyTracker::lastKinematics() const
+{
+    return kinematicsTime.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Records a latency sample for a stage of the control path.
+ * @param Stage as a constant from LatencyConstants.
+ * @param Latency in nanoseconds.
+ */
+void LatencyTracker::record(int stage, qint64 nanoseconds)
+{
+    histograms[stage].record(nanoseconds);
+}
+
+/**
+ * @brief Gets the histogram of a stage.
+ * @param Stage as a constant from LatencyConstants.
+ * @return Histogram.
+ */
+LatencyHistogram &LatencyTracker::histogram(int stage)
+{
+    return histograms[stage];
+}
+
+/**
+ * @brief Gets a readable name for a stage.
+ * @param Stage as a constant from LatencyConstants.
+ * @return Name.
+ */
+QString LatencyTracker::stageName(int stage) const
+{
+    switch (stage) {
+    case LatencyConstants::INPUT_TO_KINEMATICS:
+        return "Input to kinematics";
+    case LatencyConstants::KINEMATICS_TO_SEND:
+        return "Kinematics to send";
+    case LatencyConstants::INPUT_TO_SEND:
+        return "Input to send";
+    case LatencyConstants::SEND_TO_ACK:
+        return "Send to ack";
+    case LatencyConstants::SEND_TO_ROBOT:
+        return "Send to robot";
+    case LatencyConstants::ROBOT_TO_RECEIVE:
+        return "Robot to receive";
+    }
+    return "Unknown";
+}
+
+/**
+ * @brief Formats the percentiles of a stage into a single line.
+ * @param Stage as a constant from LatencyConstants.
+ * @return Summary, all values in microseconds.
+ */
+QString LatencyTracker::summary(int stage) const
+{
+    const LatencyHistogram &h = histograms[stage];
+    return QString("p50 %1  p99 %2  p99.9 %3  max %4 us")
+        .arg(h.percentile(50.0))
+        .arg(h.percentile(99.0))
+        .arg(h.percentile(99.9))
+        .arg(h.max());
+}
+
+/**
+ * @brief Writes percentiles and the raw non-empty buckets of every stage to a text file.
+ * @param File path.
+ * @return True if the file was written, otherwise false.
+ */
+bool LatencyTracker::dump(const QString &path) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream out(&file);
+    for (int stage = 0; stage < LatencyConstants::STAGE_COUNT; stage++) {
+        const LatencyHistogram &h = histograms[stage];
+        out << "# " << stageName(stage) << ", " << h.count() << " samples\n";
+        out << "# " << summary(stage) << "\n";
+        out << "# lower_us upper_us count\n";
+        for (int i = 0; i < LatencyConstants::BUCKET_COUNT; i++) {
+            quint64 samples = h.bucketCount(i);
+            if (samples > 0) {
+                out << LatencyHistogram::bucketLowerBound(i) << " "
+                    << LatencyHistogram::bucketUpperBound(i) << " " << samples << "\n";
+            }
+        }
+        out << "\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Clears every stage.
+ */
+void LatencyTracker::reset()
+{
+    for (int stage = 0; stage < LatencyConstants::STAGE_COUNT; stage++) {
+        histograms[stage].reset();
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include "constants.h"
+
+#include <atomic>
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * Fixed bucket latency histogram in the spirit of HdrHistogram. Recording is lock-free and
+ * may happen from any thread, reading gives an approximate but consistent enough view.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+    void record(qint64 nanoseconds);
+    void reset();
+
+    quint64 count() const;
+    qint64 percentile(double percent) const; // us
+    qint64 max() const;                      // us
+    quint64 bucketCount(int index) const;
+
+    static int bucketIndex(qint64 microseconds);
+    static qint64 bucketLowerBound(int index);
+    static qint64 bucketUpperBound(int index);
+
+private:
+    std::atomic<quint64> buckets[LatencyConstants::BUCKET_COUNT];
+    std::atomic<quint64> total;
+    std::atomic<qint64> maximum;
+};
+
+/**
+ * Owns one histogram per stage of the control path and the timestamps needed to correlate
+ * an input event with the kinematics update and datagram it produces.
+ */
+class LatencyTracker
+{
+public:
+    LatencyTracker();
+    static qint64 now();
+
+    void markInput();
+    void markKinematics(qint64 time);
+    qint64 lastInput() const;
+    qint64 lastKinematics() const;
+
+    void record(int stage, qint64 nanoseconds);
+    LatencyHistogram &histogram(int stage);
+    QString stageName(int stage) const;
+    QString summary(int stage) const;
+    bool dump(const QString &path) const;
+    void reset();
+
+private:
+    LatencyHistogram histograms[LatencyConstants::STAGE_COUNT];
+    std::atomic<qint64> inputTime;
+    std::atomic<qint64> kinematicsTime;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,155 @@
+#include "linkestimator.h"
+
+#include "constants.h"
+
+#include <algorithm>
+#include <cmath>
+
+LinkEstimator::LinkEstimator()
+{
+    reset();
+}
+
+/**
+ * @brief Forgets all measurements, done when the robot list is rebuilt.
+ */
+void LinkEstimator::reset()
+{
+    lastHeartbeat = 0;
+    meanInterval = 0.0;
+    deviation = 0.0;
+}
+
+/**
+ * @brief Adds a heartbeat arrival to the estimate. A heartbeat ending an outage the link
+ * counted as lost starts the measurement over instead.
+ * @param Arrival time in microseconds.
+ */
+void LinkEstimator::heartbeat(quint64 now)
+{
+    if (lastHeartbeat == 0) {
+        lastHeartbeat = now;
+        return;
+    }
+    double interval = (now - lastHeartbeat) / 1000.0;
+    lastHeartbeat = now;
+
+    if (isMeasured() && interval >= lostTimeout()) {
+        // The gap of an outage is no interval of the link (Karn's algorithm). Measuring again
+        // from the next one also follows a robot that now sends heartbeats at a lower rate.
+        meanInterval = 0.0;
+        deviation = 0.0;
+        return;
+    }
+    if (meanInterval == 0.0) {
+        meanInterval = interval;
+        deviation = interval / 2.0;
+        return;
+    }
+    // Deviation first so it is measured against the previous mean, as in RFC 6298
+    deviation += (std::abs(interval - meanInterval) - deviation) / 4.0;
+    meanInterval += (interval - meanInterval) / 8.0;
+}
+
+/**
+ * @brief Checks if enough heartbeats arrived to derive timeouts from them.
+ * @return True once the inter-arrival time was measured, otherwise false.
+ */
+bool LinkEstimator::isMeasured() const
+{
+    return meanInterval > 0.0;
+}
+
+/**
+ * @brief Gets the smoothed heartbeat inter-arrival time.
+ * @return Milliseconds, 0 until measured.
+ */
+double LinkEstimator::mean() const
+{
+    return meanInterval;
+}
+
+/**
+ * @brief Gets the smoothed mean deviation of the heartbeat inter-arrival time.
+ * @return Milliseconds, 0 until measured.
+ */
+double LinkEstimator::jitter() const
+{
+    return deviation;
+}
+
+/**
+ * @brief Gets the silence after which the link counts as degraded.
+ * @return Milliseconds.
+ */
+int LinkEstimator::degradedTimeout() const
+{
+    return timeout(2);
+}
+
+/**
+ * @brief Gets the silence after which the link counts as lost. Kept at least two deviations
+ * and one heartbeat interval after the degraded timeout, so a clamp to the same bound does not
+ * skip the degraded state.
+ * @return Milliseconds, past LinkConstants::MAX_TIMEOUT when the degraded timeout is at it.
+ */
+int LinkEstimator::lostTimeout() const
+{
+    if (!isMeasured()) {
+        return timeout(4);
+    }
+    int gap = int(std::ceil(std::max(2.0 * spread(), meanInterval)));
+    return std::max(timeout(4), degradedTimeout() + gap);
+}
+
+/**
+ * @brief Gets the time since the last heartbeat.
+ * @param Current time in microseconds.
+ * @return Milliseconds.
+ */
+int LinkEstimator::silence(quint64 now) const
+{
+    return lastHeartbeat == 0 ? 0 : int((now - lastHeartbeat) / 1000);
+}
+
+/**
+ * @brief Classifies the link by the time since the last heartbeat.
+ * @param Current time in microseconds.
+ * @return State from LinkConstants, LOST before the first heartbeat.
+ */
+int LinkEstimator::state(quint64 now) const
+{
+    if (lastHeartbeat == 0) {
+        return LinkConstants::LOST;
+    }
+    int quiet = silence(now);
+    if (quiet >= lostTimeout()) {
+        return LinkConstants::LOST;
+    }
+    return quiet >= degradedTimeout() ? LinkConstants::DEGRADED : LinkConstants::GOOD;
+}
+
+/**
+ * @brief Gets the deviation the timeouts are derived from. Floored at a quarter of the mean,
+ * a perfectly regular link would otherwise turn degraded on the smallest delay.
+ * @return Milliseconds.
+ */
+double LinkEstimator::spread() const
+{
+    return std::max(deviation, meanInterval / 4.0);
+}
+
+/**
+ * @brief Derives a timeout from the estimate.
+ * @param Number of deviations allowed past the mean.
+ * @return Milliseconds, clamped to the LinkConstants bounds.
+ */
+int LinkEstimator::timeout(int deviations) const
+{
+    if (!isMeasured()) {
+        return deviations * LinkConstants::INITIAL_TIMEOUT / 4;
+    }
+    return std::clamp(int(std::ceil(meanInterval + deviations * spread())),
+                      LinkConstants::MIN_TIMEOUT,
+                      LinkConstants::MAX_TIMEOUT);
+}
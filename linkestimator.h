@@ -0,0 +1,38 @@
+#ifndef LINKESTIMATOR_H
+#define LINKESTIMATOR_H
+
+#include <QtGlobal>
+
+/**
+ * Estimates link health from heartbeat arrival times. Mean and jitter of the inter-arrival
+ * time are smoothed the way TCP smooths round trip times (RFC 6298), and the link counts as
+ * degraded after mean + 2 deviations of silence and as lost after mean + 4 deviations. Both
+ * are clamped to the LinkConstants bounds, with the lost timeout kept at least a heartbeat
+ * interval after the degraded one so a fast link still passes through the degraded state. The
+ * gap of an outage is not taken as an interval, the estimate starts over after it.
+ */
+class LinkEstimator
+{
+public:
+    LinkEstimator();
+    void reset();
+    void heartbeat(quint64 now);
+
+    bool isMeasured() const;
+    double mean() const;   // ms
+    double jitter() const; // ms
+    int degradedTimeout() const;
+    int lostTimeout() const;
+    int silence(quint64 now) const;
+    int state(quint64 now) const;
+
+private:
+    quint64 lastHeartbeat; // us, 0 before the first heartbeat
+    double meanInterval;   // ms, 0 until two heartbeats arrived
+    double deviation;      // ms
+
+    double spread() const;
+    int timeout(int deviations) const;
+};
+
+#endif // LINKESTIMATOR_H
@@ -0,0 +1,45 @@
+#ifndef LINKSTATISTICS_H
+#define LINKSTATISTICS_H
+
+#include "constants.h"
+
+#include <QMetaType>
+#include <QtGlobal>
+
+/**
+ * Snapshot of the control link health, computed from client heartbeats that echo the
+ * sequence number of the last movement packet they received.
+ */
+struct LinkStatistics
+{
+    quint64 packetsSent = 0;
+    quint64 packetsSuppressed = 0; // Skipped by change suppression
+    quint64 packetsReplaced = 0;   // Newer setpoint took the place of one the socket refused
+    quint64 sendBlocked = 0;       // Datagrams refused because the socket send buffer was full
+    quint64 sendUnreachable = 0;   // Datagrams to an unreachable network or host
+    quint64 sendPartial = 0;       // Batches the kernel only took part of
+    quint64 sendErrors = 0;        // Datagrams that failed for any other reason
+    quint64 sendRetries = 0;       // Setpoints resent once the socket was writable again
+    quint64 heartbeatsReceived = 0;
+    double rttLast = 0.0;     // ms
+    double rttSmoothed = 0.0; // ms
+    double rttMin = 0.0;      // ms
+    double rttMax = 0.0;      // ms
+    double lossPercent = 0.0;
+    quint64 reordered = 0;
+    int linkState = LinkConstants::LOST;
+    double heartbeatInterval = 0.0; // ms, smoothed
+    double heartbeatJitter = 0.0;   // ms, smoothed
+    double linkTimeout = 0.0;       // ms, silence until the link counts as lost
+    quint64 linkStops = 0;          // Times the stop policy stopped the robot
+    bool clockSynchronized = false;
+    double clockOffset = 0.0; // ms, robot clock minus server clock
+    double clockDrift = 0.0;  // ppm
+    int quantizationBits = 0;      // Bits per wheel speed, 0 if no robot gets quantized packets
+    double quantizationRms = 0.0;  // Wheel speed error over the last update interval
+    double quantizationMax = 0.0;
+};
+
+Q_DECLARE_METATYPE(LinkStatistics)
+
+#endif // LINKSTATISTICS_H
@@ -15,6 +15,18 @@ LoggerHandler::LoggerHandler(QSettings *settingsRef)
  * @param Text to be sent.
  */
 void LoggerHandler::write(QString text)
+{
+    write(getLevel(), text);
+}
+
+/**
+ * @brief Will write the the specified message text to the logger output, with
+ * the desired level of information. Does not touch the current level so it is
+ * safe to call from handlers running on other threads.
+ * @param Level as a constant from LoggerConstants choices.
+ * @param Text to be sent.
+ */
+void LoggerHandler::write(int level, QString text)
 {
     QString time = "";
     if (isShowTime()) {
@@ -23,7 +35,7 @@ void LoggerHandler::write(QString text)
 
     if (isColorify()) {
         // TODO: move colors so they can be swapped between dark and light mode
-        switch (getLevel()) {
+        switch (level) {
         case LoggerConstants::DEBUG:
             text = "<font color=\"#9F9F9F\">" + time + " [D]: " + text + "</font>";
             emit appendingText(text);
@@ -46,7 +58,7 @@ void LoggerHandler::write(QString text)
             break;
         }
     } else {
-        switch (getLevel()) {
+        switch (level) {
         case LoggerConstants::DEBUG:
             text = "<font color=\"#FFFFFF\">" + time + " [D]: " + text + "</font>";
             emit appendingText(text);
@@ -71,20 +83,6 @@ void LoggerHandler::write(QString text)
     }
 }
 
-/**
- * @brief Will write the the specified message text to the logger output, with
- * the desired level of information.
- * @param Level as a constant from LoggerConstants choices.
- * @param Text to be sent.
- */
-void LoggerHandler::write(int level, QString text)
-{
-    int prevLevel = getLevel();
-    setLevel(level);
-    write(text);
-    setLevel(prevLevel);
-}
-
 /**
  * @brief Clears the logger output.
  */
@@ -94,7 +92,7 @@ void LoggerHandler::clear()
 }
 
 /**
- * @brief Updates logger with current settings.
+ * @brief Updates logger and trace categories with current settings.
  */
 void LoggerHandler::updateWithSettings()
 {
@@ -106,6 +104,9 @@ void LoggerHandler::updateWithSettings()
                        ->value(SettingsConstants::APPEAR_THEME_TLOGS_EN,
                                SettingsConstants::D_APPEAR_THEME_TLOGS_EN)
                        .toBool());
+    Trace::setCategories(Trace::parseCategories(
+        settings->value(SettingsConstants::DEBUG_TRACE, SettingsConstants::D_DEBUG_TRACE)
+            .toString()));
 };
 
 // Setters
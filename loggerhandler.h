@@ -2,6 +2,7 @@
 #define LOGGERHANDLER_H
 
 #include "constants.h"
+#include "trace.h"
 
 #include <QDateTime>
 #include <QSettings>
@@ -1,6 +1,11 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
 #include <QtCharts/QChartView>
 #include <QtCharts/QSplineSeries>
 
@@ -9,10 +14,14 @@
 #include "gamepadhandler.h"
 #include "inputhandler.h"
 #include "kinematicshandler.h"
+#include "latencyhistogram.h"
 #include "loggerhandler.h"
 #include "outputhandler.h"
 #include "settingshandler.h"
 #include "simulationhandler.h"
+#include "telemetryrecorder.h"
+#include "telemetryring.h"
+#include "trace.h"
 
 GamepadHandler *gamepadHandler;
 InputHandler *inputHandler;
@@ -23,6 +32,10 @@ SimulationHandler *simulationHandler;
 SettingsHandler *settingsHandler;
 CommunicationHandler *communicationHandler;
 CameraHandler *cameraHandler;
+QThread *communicationThread;
+LatencyTracker *latencyTracker;
+TelemetryRing *telemetryRing;
+TelemetryRecorder *telemetryRecorder;
 
 // Constructor
 MainWindow::MainWindow(QWidget *parent)
@@ -35,17 +48,33 @@ MainWindow::MainWindow(QWidget *parent)
     settingsHandler = new SettingsHandler();
     loggerHandler = new LoggerHandler(settingsHandler->getSettings());
     settingsHandler->setLogger(loggerHandler); // Need to pass in logger for later use
-    communicationHandler = new CommunicationHandler(loggerHandler, settingsHandler->getSettings());
-    gamepadHandler = new GamepadHandler(loggerHandler);
-    inputHandler = new InputHandler(loggerHandler);
-    kinematicsHandler = new KinematicsHandler(loggerHandler);
+    latencyTracker = new LatencyTracker();
+    telemetryRing = new TelemetryRing();
+    telemetryRecorder = new TelemetryRecorder(loggerHandler, telemetryRing);
+    communicationHandler = new CommunicationHandler(loggerHandler,
+                                                    settingsHandler->getSettings(),
+                                                    latencyTracker,
+                                                    telemetryRing);
+    gamepadHandler = new GamepadHandler(loggerHandler, settingsHandler->getSettings());
+    inputHandler = new InputHandler(loggerHandler, latencyTracker);
+    kinematicsHandler = new KinematicsHandler(loggerHandler,
+                                              settingsHandler->getSettings(),
+                                              latencyTracker);
     outputHandler = new OutputHandler(loggerHandler, settingsHandler->getSettings());
     outputHandler->configureChartView(ui->kinematicsGraphView);
-    simulationHandler = new SimulationHandler(loggerHandler, settingsHandler->getSettings());
+    simulationHandler = new SimulationHandler(loggerHandler,
+                                              settingsHandler->getSettings(),
+                                              telemetryRing);
     cameraHandler = new CameraHandler(loggerHandler, settingsHandler->getSettings());
 
     configureConnections();
 
+    // Network I/O runs on its own event loop so rendering can not delay it
+    communicationThread = new QThread(this);
+    communicationThread->setObjectName("Communication");
+    communicationHandler->moveToThread(communicationThread);
+    communicationThread->start(QThread::TimeCriticalPriority);
+
     // Start to setup UI for user
     loggerHandler->clear();
     ui->loggerPlainTextEdit->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
@@ -157,6 +186,9 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
         case Qt::Key_E:
             emit keyboard_EChanged(true);
             break;
+        case Qt::Key_Space:
+            emit keyboard_SpacePressed();
+            break;
         }
     }
 }
@@ -296,6 +328,28 @@ void MainWindow::configureConnections()
             &OutputHandler::setChartVisibility,
             ui->kinematicsGraphView,
             &QChartView::setVisible);
+    connect(outputHandler, &OutputHandler::wheelsChanged, this, [this](const QStringList &names) {
+        // Speed slots in the order the kinematics emit them, a drive model with fewer wheels
+        // leaves the last ones unused
+        QLabel *labels[] = {ui->FR_label, ui->BL_label, ui->FL_label, ui->BR_label};
+        QSlider *topSliders[] = {ui->FR_topVSlider,
+                                 ui->BL_topVSlider,
+                                 ui->FL_topVSlider,
+                                 ui->BR_topVSlider};
+        QSlider *botSliders[] = {ui->FR_botVSlider,
+                                 ui->BL_botVSlider,
+                                 ui->FL_botVSlider,
+                                 ui->BR_botVSlider};
+        for (int slot = 0; slot < DriveConstants::MAX_WHEELS; slot++) {
+            bool used = slot < names.size();
+            if (used) {
+                labels[slot]->setText(names[slot]);
+            }
+            labels[slot]->setVisible(used);
+            topSliders[slot]->setVisible(used);
+            botSliders[slot]->setVisible(used);
+        }
+    });
     connect(kinematicsHandler,
             SIGNAL(speedsChanged(double, double, double, double)),
             outputHandler,
@@ -316,7 +370,8 @@ void MainWindow::configureConnections()
     connect(kinematicsHandler,
             SIGNAL(speedsChanged(double, double, double, double)),
             communicationHandler,
-            SLOT(sendMovementData(double, double, double, double)));
+            SLOT(setMovementData(double, double, double, double)),
+            Qt::DirectConnection);
 
     connect(ui->settings_ResetButton, SIGNAL(clicked()), settingsHandler, SLOT(resetSettings()));
     connect(ui->settings_ApplyButton, &QRadioButton::clicked, this, [this]() {
@@ -325,6 +380,16 @@ void MainWindow::configureConnections()
                                        ui->conn_CommAddressText->text(),
                                        ui->conn_CommPortText->text(),
                                        ui->conn_CommEnButton->isChecked(),
+                                       ui->conn_CommFormatCombo->currentIndex(),
+                                       ui->conn_CommRateCombo->currentIndex(),
+                                       ui->conn_CommFleetText->text(),
+                                       ui->conn_CommSuppressCombo->currentIndex(),
+                                       ui->conn_CommDiscoveryCombo->currentIndex(),
+                                       ui->conn_CommStopCombo->currentIndex(),
+                                       ui->conn_CommStopButtonCombo->currentIndex(),
+                                       ui->conn_CommHorizonCombo->currentIndex(),
+                                       ui->conn_CommQuantizationCombo->currentIndex(),
+                                       ui->conn_CommDriveCombo->currentIndex(),
                                        ui->graph_PerformEnButton->isChecked(),
                                        ui->graph_PerformQualCombo->currentIndex(),
                                        ui->graph_PerformPointsSlider->value(),
@@ -362,6 +427,46 @@ void MainWindow::configureConnections()
             &SettingsHandler::signalConn_CommEnButton,
             ui->conn_CommEnButton,
             &QRadioButton::setChecked);
+    connect(settingsHandler,
+            &SettingsHandler::signalConn_CommFormatCombo,
+            ui->conn_CommFormatCombo,
+            &QComboBox::setCurrentIndex);
+    connect(settingsHandler,
+            &SettingsHandler::signalConn_CommRateCombo,
+            ui->conn_CommRateCombo,
+            &QComboBox::setCurrentIndex);
+    connect(settingsHandler,
+            &SettingsHandler::signalConn_CommFleetText,
+            ui->conn_CommFleetText,
+            &QLineEdit::setText);
+    connect(settingsHandler,
+            &SettingsHandler::signalConn_CommSuppressCombo,
+            ui->conn_CommSuppressCombo,
+            &QComboBox::setCurrentIndex);
+    connect(settingsHandler,
+            &SettingsHandler::signalConn_CommDiscoveryCombo,
+            ui->conn_CommDiscoveryCombo,
+            &QComboBox::setCurrentIndex);
+    connect(settingsHandler,
+            &SettingsHandler::signalConn_CommStopCombo,
+            ui->conn_CommStopCombo,
+            &QComboBox::setCurrentIndex);
+    connect(settingsHandler,
+            &SettingsHandler::signalConn_CommStopButtonCombo,
+            ui->conn_CommStopButtonCombo,
+            &QComboBox::setCurrentIndex);
+    connect(settingsHandler,
+            &SettingsHandler::signalConn_CommHorizonCombo,
+            ui->conn_CommHorizonCombo,
+            &QComboBox::setCurrentIndex);
+    connect(settingsHandler,
+            &SettingsHandler::signalConn_CommQuantizationCombo,
+            ui->conn_CommQuantizationCombo,
+            &QComboBox::setCurrentIndex);
+    connect(settingsHandler,
+            &SettingsHandler::signalConn_CommDriveCombo,
+            ui->conn_CommDriveCombo,
+            &QComboBox::setCurrentIndex);
 
     connect(settingsHandler,
             &SettingsHandler::signalGraph_PerformEnButton,
@@ -409,12 +514,17 @@ void MainWindow::configureConnections()
             simulationHandler,
             SLOT(updateWithSettings()));
     connect(settingsHandler, SIGNAL(settingsUpdated()), outputHandler, SLOT(updateWithSettings()));
+    connect(settingsHandler,
+            SIGNAL(settingsUpdated()),
+            kinematicsHandler,
+            SLOT(updateWithSettings()));
     connect(settingsHandler, SIGNAL(settingsUpdated()), loggerHandler, SLOT(updateWithSettings()));
     connect(settingsHandler,
             SIGNAL(settingsUpdated()),
             communicationHandler,
             SLOT(updateWithSettings()));
     connect(settingsHandler, SIGNAL(settingsUpdated()), cameraHandler, SLOT(updateWithSettings()));
+    connect(settingsHandler, SIGNAL(settingsUpdated()), gamepadHandler, SLOT(updateWithSettings()));
 
     connect(settingsHandler, &SettingsHandler::settingsUpdated, this, [this]() {
         swapControl(settingsHandler->getSettings()
@@ -465,6 +575,23 @@ void MainWindow::configureConnections()
             inputHandler,
             &InputHandler::keyboard_ESetter);
 
+    // Emergency stops are sent on the thread that raised them, no event loop in between
+    connect(this,
+            &MainWindow::keyboard_SpacePressed,
+            communicationHandler,
+            &CommunicationHandler::emergencyStop,
+            Qt::DirectConnection);
+    connect(simulationHandler,
+            &SimulationHandler::passKeyboard_SpacePressed,
+            communicationHandler,
+            &CommunicationHandler::emergencyStop,
+            Qt::DirectConnection);
+    connect(gamepadHandler,
+            &GamepadHandler::stopButtonPressed,
+            communicationHandler,
+            &CommunicationHandler::emergencyStop,
+            Qt::DirectConnection);
+
     connect(simulationHandler, &SimulationHandler::meshesLoaded, this, [] {
         loggerHandler->write(LoggerConstants::INFO, "Loaded all 3D meshes");
     });
@@ -478,11 +605,280 @@ void MainWindow::configureConnections()
             ui->communicationStatus->setText("Disconnected");
         }
     });
+    connect(communicationHandler,
+            &CommunicationHandler::fleetStatus,
+            this,
+            [this](int connected, int total) {
+                // Single client keeps the plain status text
+                if (total > 1 && connected > 0) {
+                    ui->communicationStatus->setText(QString("Connected %1/%2")
+                                                         .arg(connected)
+                                                         .arg(total));
+                }
+                if (robotLines.size() > total) {
+                    robotLines.erase(robotLines.begin() + total, robotLines.end());
+                    updateRobotInfo();
+                }
+            });
+    connect(communicationHandler,
+            &CommunicationHandler::robotCapabilities,
+            this,
+            [this](int robot,
+                   const QString &endpoint,
+                   int version,
+                   quint32 capabilities,
+                   int format) {
+                static const struct
+                {
+                    quint32 bit;
+                    const char *name;
+                } names[] = {{ProtocolConstants::CAP_BINARY, "binary"},
+                             {ProtocolConstants::CAP_TRAJECTORY, "trajectory"},
+                             {ProtocolConstants::CAP_QUANTIZED, "quantized"},
+                             {ProtocolConstants::CAP_TIME_SYNC, "time sync"},
+                             {ProtocolConstants::CAP_STOP, "stop"},
+                             {ProtocolConstants::CAP_CONTROL, "control"},
+                             {ProtocolConstants::CAP_IMU, "IMU"},
+                             {ProtocolConstants::CAP_ENCODER, "encoder"},
+                             {ProtocolConstants::CAP_BATTERY, "battery"}};
+                QString line = endpoint + "  ";
+                if (version == 0) {
+                    line += "no handshake";
+                } else {
+                    QStringList supported;
+                    for (const auto &name : names) {
+                        if (capabilities & name.bit) {
+                            supported.append(name.name);
+                        }
+                    }
+                    line += QString("v%1").arg(version) + "\n    "
+                            + (supported.isEmpty() ? "text only" : supported.join(", "));
+                }
+                line += QString("\n    Sending ") + ProtocolConstants::FORMAT_NAMES[format];
+                while (robotLines.size() <= robot) {
+                    robotLines.append(QString());
+                }
+                robotLines[robot] = line;
+                updateRobotInfo();
+            });
+
+    connect(communicationHandler,
+            &CommunicationHandler::linkStatisticsChanged,
+            this,
+            [this](LinkStatistics stats) {
+                static const char *linkStates[] = {"Good", "Degraded", "Lost"};
+                QString link = QString("Link %1").arg(linkStates[stats.linkState]);
+                if (stats.heartbeatInterval > 0.0) {
+                    link += QString(" (heartbeat %1 +- %2 ms, timeout %3 ms)")
+                                .arg(stats.heartbeatInterval, 0, 'f', 0)
+                                .arg(stats.heartbeatJitter, 0, 'f', 0)
+                                .arg(stats.linkTimeout, 0, 'f', 0);
+                }
+                if (stats.linkStops > 0) {
+                    link += QString("  |  Stopped %1x").arg(stats.linkStops);
+                }
+                if (stats.clockSynchronized) {
+                    link += QString("  |  Clock %1 ms, %2 ppm")
+                                .arg(stats.clockOffset, 0, 'f', 2)
+                                .arg(stats.clockDrift, 0, 'f', 1);
+                }
+                if (stats.quantizationBits > 0) {
+                    link += QString("  |  %1 bit, error %2 rms / %3 max")
+                                .arg(stats.quantizationBits)
+                                .arg(stats.quantizationRms, 0, 'g', 2)
+                                .arg(stats.quantizationMax, 0, 'g', 2);
+                }
+                QString suppressed = QString("  |  Suppressed %1").arg(stats.packetsSuppressed);
+                link += QString("\nSend failures: %1 blocked, %2 unreachable, %3 partial, %4 "
+                                "other  |  Retried %5, replaced %6")
+                            .arg(stats.sendBlocked)
+                            .arg(stats.sendUnreachable)
+                            .arg(stats.sendPartial)
+                            .arg(stats.sendErrors)
+                            .arg(stats.sendRetries)
+                            .arg(stats.packetsReplaced);
+                if (stats.heartbeatsReceived == 0) {
+                    ui->communicationStats->setText("RTT -- ms  |  Loss -- %  |  Reordered --"
+                                                    + suppressed + '\n' + link);
+                    return;
+                }
+                ui->communicationStats->setText(
+                    QString("RTT %1 ms (%2-%3)  |  Loss %4 %  |  Reordered %5")
+                        .arg(stats.rttSmoothed, 0, 'f', 1)
+                        .arg(stats.rttMin, 0, 'f', 1)
+                        .arg(stats.rttMax, 0, 'f', 1)
+                        .arg(stats.lossPercent, 0, 'f', 1)
+                        .arg(stats.reordered)
+                    + suppressed + '\n' + link);
+            });
 
     connect(ui->refreshConnections,
             &QToolButton::pressed,
             communicationHandler,
             &CommunicationHandler::refreshConnection);
+
+    // Latency histograms and telemetry are only read while the Info page is shown
+    QTimer *infoTimer = new QTimer(this);
+    connect(infoTimer, &QTimer::timeout, this, [this]() {
+        if (ui->Application_Stack->currentIndex() == 2) {
+            updateLatencyInfo();
+            updateTelemetryInfo();
+        }
+    });
+    infoTimer->start(500);
+
+    connect(ui->latencyDumpButton, &QPushButton::clicked, this, [this]() {
+        QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dir);
+        QString path = dir + "/latency-"
+                       + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".txt";
+        if (latencyTracker->dump(path)) {
+            loggerHandler->write(LoggerConstants::INFO, "Latency histograms written to " + path);
+        } else {
+            loggerHandler->write(LoggerConstants::ERR, "Could not write latency histograms");
+        }
+    });
+    connect(ui->latencyResetButton, &QPushButton::clicked, this, [this]() {
+        latencyTracker->reset();
+        updateLatencyInfo();
+    });
+
+    // Trace points only exist in builds with REMOTECONTROL_TRACE
+    ui->traceDumpButton->setVisible(Trace::isCompiledIn());
+    connect(ui->traceDumpButton, &QPushButton::clicked, this, [this]() {
+        QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dir);
+        QString path = dir + "/trace-"
+                       + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".txt";
+        if (Trace::dump(path)) {
+            loggerHandler->write(LoggerConstants::INFO, "Trace records written to " + path);
+        } else {
+            loggerHandler->write(LoggerConstants::ERR, "Could not write trace records");
+        }
+    });
+
+    connect(ui->robotLogButton,
+            &QPushButton::clicked,
+            communicationHandler,
+            &CommunicationHandler::requestRobotLogs);
+    connect(communicationHandler,
+            &CommunicationHandler::robotLogReceived,
+            this,
+            [this](int robot, const QString &endpoint, const QByteArray &log) {
+                QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+                QDir().mkpath(dir);
+                QString path = dir + "/robot" + QString::number(robot + 1) + "-"
+                               + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")
+                               + ".log";
+                QFile file(path);
+                if (file.open(QIODevice::WriteOnly) && file.write(log) == log.size()) {
+                    loggerHandler->write(LoggerConstants::INFO,
+                                         "Log of " + endpoint + " written to " + path);
+                } else {
+                    loggerHandler->write(LoggerConstants::ERR,
+                                         "Could not write the log of " + endpoint);
+                }
+            });
+
+    connect(ui->telemetryRecordButton, &QPushButton::toggled, this, [this](bool checked) {
+        if (!checked) {
+            telemetryRecorder->stop();
+            return;
+        }
+        QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dir);
+        QString path = dir + "/telemetry-"
+                       + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".csv";
+        if (!telemetryRecorder->start(path)) {
+            ui->telemetryRecordButton->setChecked(false);
+        }
+    });
+}
+
+/**
+ * @brief Shows the current percentiles of every latency stage on the Info page.
+ */
+void MainWindow::updateLatencyInfo()
+{
+    QString text;
+    for (int stage = 0; stage < LatencyConstants::STAGE_COUNT; stage++) {
+        if (stage > 0) {
+            text += "\n";
+        }
+        text += latencyTracker->stageName(stage) + "\n    " + latencyTracker->summary(stage);
+    }
+    ui->latencyLabel->setText(text);
+}
+
+/**
+ * @brief Shows the handshake result of every robot on the Info page.
+ */
+void MainWindow::updateRobotInfo()
+{
+    QStringList lines;
+    for (const QString &line : qAsConst(robotLines)) {
+        if (!line.isEmpty()) {
+            lines.append(line);
+        }
+    }
+    ui->robotsLabel->setText(lines.isEmpty() ? "No robot answered yet" : lines.join('\n'));
+}
+
+/**
+ * @brief Shows the newest sample of every telemetry type on the Info page. Samples are read in
+ * place from the telemetry ring.
+ */
+void MainWindow::updateTelemetryInfo()
+{
+    QString lines[TelemetryConstants::TYPE_COUNT];
+    for (int type = 0; type < TelemetryConstants::TYPE_COUNT; type++) {
+        quint64 index;
+        if (!telemetryRing->latest(ProtocolConstants::IMU + type, index)) {
+            continue;
+        }
+        quint64 stamp = telemetryRing->beginRead(index);
+        if (!stamp) {
+            continue;
+        }
+
+        const TelemetrySample &sample = telemetryRing->at(index);
+        QString line;
+        switch (sample.type) {
+        case ProtocolConstants::IMU:
+            line = QString("IMU\n    accel %1 %2 %3 m/s2\n    gyro %4 %5 %6 rad/s")
+                       .arg(sample.imu.accel[0], 0, 'f', 2)
+                       .arg(sample.imu.accel[1], 0, 'f', 2)
+                       .arg(sample.imu.accel[2], 0, 'f', 2)
+                       .arg(sample.imu.gyro[0], 0, 'f', 2)
+                       .arg(sample.imu.gyro[1], 0, 'f', 2)
+                       .arg(sample.imu.gyro[2], 0, 'f', 2);
+            break;
+        case ProtocolConstants::ENCODER:
+            line = QString("Wheels\n    %1 %2 %3 %4")
+                       .arg(sample.encoder.velocity[0], 0, 'f', 2)
+                       .arg(sample.encoder.velocity[1], 0, 'f', 2)
+                       .arg(sample.encoder.velocity[2], 0, 'f', 2)
+                       .arg(sample.encoder.velocity[3], 0, 'f', 2);
+            break;
+        case ProtocolConstants::BATTERY:
+            line = QString("Battery\n    %1 V  %2 A  %3 %")
+                       .arg(sample.battery.voltage, 0, 'f', 2)
+                       .arg(sample.battery.current, 0, 'f', 2)
+                       .arg(sample.battery.charge * 100.0, 0, 'f', 0);
+            break;
+        }
+        if (telemetryRing->endRead(index, stamp)) {
+            lines[type] = line;
+        }
+    }
+
+    QString text;
+    for (const QString &line : lines) {
+        if (!line.isEmpty()) {
+            text += (text.isEmpty() ? "" : "\n") + line;
+        }
+    }
+    ui->telemetryLabel->setText(text.isEmpty() ? "No samples yet" : text);
 }
 
 void MainWindow::swapControl(bool sim, bool cam)
@@ -552,5 +948,12 @@ void MainWindow::on_swapViewsButton_clicked()
 // Deconstructor
 MainWindow::~MainWindow()
 {
+    communicationThread->quit();
+    communicationThread->wait();
+    delete communicationHandler;
+    telemetryRecorder->stop();
+    delete telemetryRecorder;
+    delete latencyTracker;
+    delete telemetryRing;
     delete ui;
 }
@@ -6,6 +6,7 @@
 #include <QKeyEvent>
 #include <QLabel>
 #include <QMainWindow>
+#include <QStringList>
 #include <QVBoxLayout>
 
 QT_BEGIN_NAMESPACE
@@ -29,10 +30,15 @@ signals:
     void keyboard_DChanged(bool);
     void keyboard_QChanged(bool);
     void keyboard_EChanged(bool);
+    void keyboard_SpacePressed();
 
 private:
     Ui::MainWindow *ui;
     void configureConnections();
+    void updateLatencyInfo();
+    void updateTelemetryInfo();
+    void updateRobotInfo();
+    QStringList robotLines; // Handshake result per robot, by fleet index
 
 private slots:
     void on_home_toolButton_clicked();
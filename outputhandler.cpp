@@ -7,6 +7,7 @@ OutputHandler::OutputHandler(LoggerHandler *loggerRef, QSettings *settingsRef)
     settings = settingsRef;
 
     detailLevel = SettingsConstants::ADVANCED_INFO;
+    driveModel = SettingsConstants::D_CONN_COMM_DRIVE;
 
     axisX = new QtCharts::QCategoryAxis();
     axisY = new QtCharts::QCategoryAxis();
@@ -149,37 +150,33 @@ void OutputHandler::configureChartView(QtCharts::QChartView *chartView)
 // TODO revamp algorithm to grab critical points instead of set points. Will
 // give a better looking graph with less points (maybe give better performance?)
 /**
- * @brief Generates a set number of data points of a modified sine function. The
- * modified sine function is the basis of the kinematics for a mechanum drive
- * system.
+ * @brief Generates a set number of data points of one wheel's speed over a full turn of the
+ * input direction, from the wheel's row of the drive model's mixing matrix. For mecanum these
+ * are the shifted sine functions the kinematics are built on.
  * @param Number of data points in array generated.
- * @param Cycles from start to finsh.
- * @param Amplitude of sine.
- * @param Up and down offset.
- * @param Left and right offset.
+ * @param Wheel, below the drive model's wheel count.
  * @param Magnitude of force (how fast).
- * @param Z coordinate of input.
+ * @param Z coordinate of input, negated as the kinematics handler emits it.
  * @param Value that is used for normalization.
  * @return Array of pointers pointing to data points.
  */
-double **OutputHandler::generateSinePointsKinematics(int numberOfPoints,
-                                                     double cycles,
-                                                     double amp,
-                                                     double yOffset,
-                                                     double xOffset,
-                                                     double mag,
-                                                     double z,
-                                                     double scale)
+double **OutputHandler::generateWheelPoints(int numberOfPoints,
+                                            int wheel,
+                                            double mag,
+                                            double z,
+                                            double scale)
 {
+    const double *row = DriveModel::mixingRow(driveModel, wheel);
     double y = 0.0;
-    double f = cycles / double(numberOfPoints - 1);
+    double f = 1.0 / double(numberOfPoints - 1);
     double **arr = new double *[numberOfPoints];
     for (int i = 0; i < numberOfPoints; i++) {
         arr[i] = new double[2];
     }
 
     for (int t = 0; t < (numberOfPoints); t++) {
-        y = std::clamp((roundf(((((amp * sin(2 * 3.14159 * f * t + xOffset) + yOffset) * mag) + z)
+        double dir = 2 * MathConstants::PI * f * t;
+        y = std::clamp((roundf(((((row[0] * cos(dir) + row[1] * sin(dir)) * mag) - row[2] * z)
                                 / scale)
                                * 100000)
                         / 100000.0),
@@ -192,8 +189,8 @@ double **OutputHandler::generateSinePointsKinematics(int numberOfPoints,
 }
 
 /**
- * @brief Updates sliders on GUI to repersent FR/BL and FL/BR values. Function
- * is called any time a kinematics value is updated or changed.
+ * @brief Updates sliders on GUI to repersent the wheel speed slots, FR, BL, FL and BR for
+ * mecanum. Function is called any time a kinematics value is updated or changed.
  */
 void OutputHandler::updateSliders(double FRSpeed, double BLSpeed, double FLSpeed, double BRSpeed)
 {
@@ -240,159 +237,32 @@ void OutputHandler::updateChart(double dir, double mag, double z, double scaleFa
         // TODO Potentially switch over to using vectors? Statically allocated
         // arrays seems fine in this case as the array size does not change after
         // compile timer.
-        // Show line at dir
-        switch (getCurrentDetailLevel()) {
-        case SettingsConstants::BASIC_INFO:
-            // Generate mag and scale - 2 speed lines
-            FRSeries->setVisible(true);
-            BLSeries->setVisible(false);
-            FLSeries->setVisible(true);
-            BRSeries->setVisible(false);
-
-            FRarrPtr = generateSinePointsKinematics(getMaxDataPoints(),
-                                                    1.0,
-                                                    1.0,
-                                                    0.0,
-                                                    (-(MathConstants::PI / 4)),
-                                                    mag,
-                                                    0.0,
-                                                    scaleFactor);
-
-            FLarrPtr = generateSinePointsKinematics(getMaxDataPoints(),
-                                                    1.0,
-                                                    1.0,
-                                                    0.0,
-                                                    ((MathConstants::PI / 4)),
-                                                    mag,
-                                                    0.0,
-                                                    scaleFactor);
-
-            FRSeries->clear();
-            FLSeries->clear();
-
-            plotArray(FRarrPtr, IOConstants::FR_GRAPH);
-            plotArray(FLarrPtr, IOConstants::FL_GRAPH);
-
-            // Clean up memory used by array
-            for (int i = 0; i < getMaxDataPoints(); i++) {
-                delete[] FRarrPtr[i];
-                delete[] FLarrPtr[i];
-            }
-            delete[] FRarrPtr;
-            delete[] FLarrPtr;
-
-            break;
-
-        case SettingsConstants::DETAILED_INFO:
-            //Generate Mag scale and z - 2 speed lines
-            FRSeries->setVisible(true);
-            BLSeries->setVisible(false);
-            FLSeries->setVisible(true);
-            BRSeries->setVisible(false);
-
-            FRarrPtr = generateSinePointsKinematics(getMaxDataPoints(),
-                                                    1.0,
-                                                    1.0,
-                                                    0.0,
-                                                    (-(MathConstants::PI / 4)),
-                                                    mag,
-                                                    z,
-                                                    scaleFactor);
-
-            FLarrPtr = generateSinePointsKinematics(getMaxDataPoints(),
-                                                    1.0,
-                                                    1.0,
-                                                    0.0,
-                                                    ((MathConstants::PI / 4)),
-                                                    mag,
-                                                    z,
-                                                    scaleFactor);
-            FRSeries->clear();
-            FLSeries->clear();
-
-            plotArray(FRarrPtr, IOConstants::FR_GRAPH);
-            plotArray(FLarrPtr, IOConstants::FL_GRAPH);
-
-            // Clean up memory used by array
-            for (int i = 0; i < getMaxDataPoints(); i++) {
-                delete[] FRarrPtr[i];
-                delete[] FLarrPtr[i];
-            }
-            delete[] FRarrPtr;
-            delete[] FLarrPtr;
-
-            break;
-
-        case SettingsConstants::ADVANCED_INFO:
-            // Generate Mag scale and z - 4 speed lines
-            FRSeries->setVisible(true);
-            BLSeries->setVisible(true);
-            FLSeries->setVisible(true);
-            BRSeries->setVisible(true);
-
-            FRarrPtr = generateSinePointsKinematics(getMaxDataPoints(),
-                                                    1.0,
-                                                    1.0,
-                                                    0.0,
-                                                    (-(MathConstants::PI / 4)),
-                                                    mag,
-                                                    z,
-                                                    scaleFactor);
-
-            BLarrPtr = generateSinePointsKinematics(getMaxDataPoints(),
-                                                    1.0,
-                                                    -1.0,
-                                                    0.0,
-                                                    (-(MathConstants::PI / 4)),
-                                                    mag,
-                                                    z,
-                                                    scaleFactor);
-
-            FLarrPtr = generateSinePointsKinematics(getMaxDataPoints(),
-                                                    1.0,
-                                                    -1.0,
-                                                    0.0,
-                                                    (MathConstants::PI / 4),
-                                                    mag,
-                                                    z,
-                                                    scaleFactor);
-
-            BRarrPtr = generateSinePointsKinematics(getMaxDataPoints(),
-                                                    1.0,
-                                                    1.0,
-                                                    0.0,
-                                                    (MathConstants::PI / 4),
-                                                    mag,
-                                                    z,
-                                                    scaleFactor);
-            FRSeries->clear();
-            BLSeries->clear();
-            FLSeries->clear();
-            BRSeries->clear();
-
-            for (int i = 0; i < getMaxDataPoints(); i++) {
-                BLarrPtr[i][1] = -BLarrPtr[i][1];
-                FLarrPtr[i][1] = -FLarrPtr[i][1];
+        // Basic and detailed show one of each pair of wheels sharing a translation row, the
+        // first and the third, basic without z. Advanced shows every wheel of the drive model.
+        QtCharts::QLineSeries *series[] = {FRSeries, BLSeries, FLSeries, BRSeries};
+        int wheels = DriveModel::wheelCount(driveModel);
+        double wheelZ = getCurrentDetailLevel() == SettingsConstants::BASIC_INFO ? 0.0 : z;
+        for (int wheel = 0; wheel < DriveConstants::MAX_WHEELS; wheel++) {
+            bool shown = wheel < wheels
+                         && (getCurrentDetailLevel() == SettingsConstants::ADVANCED_INFO
+                             || wheel % 2 == 0);
+            series[wheel]->setVisible(shown);
+            if (!shown) {
+                continue;
             }
-
-            plotArray(FRarrPtr, IOConstants::FR_GRAPH);
-            plotArray(BLarrPtr, IOConstants::BL_GRAPH);
-            plotArray(FLarrPtr, IOConstants::FL_GRAPH);
-            plotArray(BRarrPtr, IOConstants::BR_GRAPH);
+            double **arrPtr = generateWheelPoints(getMaxDataPoints(),
+                                                  wheel,
+                                                  mag,
+                                                  wheelZ,
+                                                  scaleFactor);
+            series[wheel]->clear();
+            plotArray(arrPtr, wheel);
 
             // Clean up memory used by array
             for (int i = 0; i < getMaxDataPoints(); i++) {
-                delete[] FRarrPtr[i];
-                delete[] BLarrPtr[i];
-                delete[] FLarrPtr[i];
-                delete[] BRarrPtr[i];
+                delete[] arrPtr[i];
             }
-            delete[] FRarrPtr;
-            delete[] BLarrPtr;
-            delete[] FLarrPtr;
-            delete[] BRarrPtr;
-
-            break;
+            delete[] arrPtr;
         }
     }
 }
@@ -480,6 +350,12 @@ void OutputHandler::updateWithSettings()
             settings
                 ->value(SettingsConstants::GRAPH_PERF_ACCEL, SettingsConstants::D_GRAPH_PERF_ACCEL)
                 .toBool());
+    }
+    setDriveModel(settings
+                      ->value(SettingsConstants::CONN_COMM_DRIVE,
+                              SettingsConstants::D_CONN_COMM_DRIVE)
+                      .toInt());
+    if (chart) {
         updateChart(0, 0, 0, 0);
     }
 }
@@ -513,6 +389,20 @@ void OutputHandler::setDetailLevel(int level)
     detailLevel = level;
 }
 
+/**
+ * @brief Sets the drive model the sliders and the chart are laid out for, and names its wheels.
+ * @param Model as a constant from DriveConstants.
+ */
+void OutputHandler::setDriveModel(int model)
+{
+    driveModel = std::clamp(model, 0, DriveConstants::MODEL_COUNT - 1);
+    QStringList names;
+    for (int wheel = 0; wheel < DriveModel::wheelCount(driveModel); wheel++) {
+        names.append(DriveModel::wheelName(driveModel, wheel));
+    }
+    emit wheelsChanged(names);
+}
+
 /**
  * @brief Sets the current max ammount of data points for graphing points of the kinematics.
  * @param Number of max data points.
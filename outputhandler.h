@@ -2,6 +2,7 @@
 #define OUTPUTHANDLER_H
 
 #include "constants.h"
+#include "drivemodel.h"
 #include "helper.h"
 #include "loggerhandler.h"
 
@@ -9,6 +10,7 @@
 #include <QObject>
 #include <QSettings>
 #include <QSlider>
+#include <QStringList>
 #include <QtCharts/QCategoryAxis>
 #include <QtCharts/QChartView>
 #include <QtCharts/QSplineSeries>
@@ -42,6 +44,7 @@ signals:
     void BR_botSlider_ValChanged(double);
 
     void setChartVisibility(bool);
+    void wheelsChanged(QStringList); // Names of the drive model's wheels, one per used slot
 
 private:
     LoggerHandler *logger;
@@ -54,11 +57,6 @@ private:
     QtCharts::QLineSeries *FLSeries;
     QtCharts::QLineSeries *BRSeries;
 
-    double **FRarrPtr;
-    double **BLarrPtr;
-    double **FLarrPtr;
-    double **BRarrPtr;
-
     QtCharts::QLineSeries *dirSeries;
     QtCharts::QChart *chart;
 
@@ -73,23 +71,22 @@ private:
 
     int detailLevel;
     int maxDataPoints;
+    int driveModel; // DriveConstants model the sliders and chart are laid out for
 
     void setFRSlider(double value);
     void setBLSlider(double value);
     void setFLSlider(double value);
     void setBRSlider(double value);
     void setMaxDataPoints(int value);
+    void setDriveModel(int model);
 
     int getMaxDataPoints();
 
-    double **generateSinePointsKinematics(int numberOfPoints,
-                                          double cycles,
-                                          double amp,
-                                          double yOffset,
-                                          double xOffset,
-                                          double mag,
-                                          double z,
-                                          double scale);
+    double **generateWheelPoints(int numberOfPoints,
+                                 int wheel,
+                                 double mag,
+                                 double z,
+                                 double scale);
     void plotArray(double **arr, int graphNum);
 
     void configurePenBrushFont();
@@ -0,0 +1,547 @@
+#include "protocol.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/**
+ * @brief Reads a little-endian float without alignment requirements.
+ * @param Pointer into the receive buffer.
+ * @return Decoded value.
+ */
+static float readFloat(const char *data)
+{
+    quint32 bits = qFromLittleEndian<quint32>(data);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Writes a little-endian float without alignment requirements.
+ * @param Value to write.
+ * @param Pointer into the send buffer.
+ */
+static void writeFloat(float value, char *data)
+{
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    qToLittleEndian<quint32>(bits, data);
+}
+
+/**
+ * @brief Writes the common 4 byte binary header into the buffer.
+ * @param Packet type as a constant from ProtocolConstants.
+ * @param Buffer of at least ProtocolConstants::HEADER_SIZE bytes.
+ * @return Number of bytes written.
+ */
+int Protocol::encodeHeader(unsigned char type, char *buffer)
+{
+    buffer[0] = char(ProtocolConstants::MAGIC);
+    buffer[1] = char(ProtocolConstants::VERSION);
+    buffer[2] = char(type);
+    buffer[3] = 0;
+    return ProtocolConstants::HEADER_SIZE;
+}
+
+/**
+ * @brief Serializes a movement packet into the buffer without any allocation.
+ * @param Packet to serialize.
+ * @param Buffer of at least ProtocolConstants::MOVEMENT_SIZE bytes.
+ * @return Number of bytes written.
+ */
+int Protocol::encodeMovement(const MovementPacket &packet, char *buffer)
+{
+    int offset = encodeHeader(ProtocolConstants::MOVEMENT, buffer);
+    qToLittleEndian<quint32>(packet.sequence, buffer + offset);
+    offset += 4;
+    qToLittleEndian<quint64>(packet.timestamp, buffer + offset);
+    offset += 8;
+    for (int i = 0; i < 4; i++) {
+        writeFloat(packet.speeds[i], buffer + offset);
+        offset += 4;
+    }
+    return offset;
+}
+
+/**
+ * @brief Serializes a heartbeat packet into the buffer. Used by clients and test tools.
+ * @param Packet to serialize.
+ * @param Buffer of at least ProtocolConstants::HEARTBEAT_SIZE bytes.
+ * @return Number of bytes written.
+ */
+int Protocol::encodeHeartbeat(const HeartbeatPacket &packet, char *buffer)
+{
+    int offset = encodeHeader(ProtocolConstants::HEARTBEAT, buffer);
+    qToLittleEndian<quint32>(packet.echoSequence, buffer + offset);
+    qToLittleEndian<quint32>(packet.receivedCount, buffer + offset + 4);
+    qToLittleEndian<quint64>(packet.echoReceiveTime, buffer + offset + 8);
+    qToLittleEndian<quint64>(packet.transmitTime, buffer + offset + 16);
+    return ProtocolConstants::HEARTBEAT_SIZE;
+}
+
+/**
+ * @brief Serializes a discovery announce or its reply into the buffer.
+ * @param ProtocolConstants::ANNOUNCE or ProtocolConstants::ANNOUNCE_REPLY.
+ * @param Packet to serialize.
+ * @param Buffer of at least ProtocolConstants::ANNOUNCE_SIZE bytes.
+ * @return Number of bytes written.
+ */
+int Protocol::encodeAnnounce(unsigned char type, const AnnouncePacket &packet, char *buffer)
+{
+    int offset = encodeHeader(type, buffer);
+    qToLittleEndian<quint32>(packet.nonce, buffer + offset);
+    return ProtocolConstants::ANNOUNCE_SIZE;
+}
+
+/**
+ * @brief Serializes an emergency stop into the buffer.
+ * @param Packet to serialize.
+ * @param Buffer of at least ProtocolConstants::STOP_SIZE bytes.
+ * @return Number of bytes written.
+ */
+int Protocol::encodeStop(const StopPacket &packet, char *buffer)
+{
+    int offset = encodeHeader(ProtocolConstants::STOP, buffer);
+    qToLittleEndian<quint32>(packet.id, buffer + offset);
+    return ProtocolConstants::STOP_SIZE;
+}
+
+/**
+ * @brief Serializes a trajectory chunk into the buffer without any allocation.
+ * @param Packet to serialize, count has to be within 1 and MAX_TRAJECTORY_POINTS.
+ * @param Buffer of ProtocolConstants::MAX_PACKET_SIZE bytes.
+ * @return Number of bytes written.
+ */
+int Protocol::encodeTrajectory(const TrajectoryPacket &packet, char *buffer)
+{
+    int offset = encodeHeader(ProtocolConstants::TRAJECTORY, buffer);
+    qToLittleEndian<quint32>(packet.sequence, buffer + offset);
+    qToLittleEndian<quint64>(packet.timestamp, buffer + offset + 4);
+    buffer[16] = char(packet.count);
+    buffer[17] = 0;
+    buffer[18] = 0;
+    buffer[19] = 0;
+    offset = ProtocolConstants::TRAJECTORY_HEADER_SIZE;
+    for (int i = 0; i < packet.count; i++) {
+        qToLittleEndian<quint32>(packet.points[i].offset, buffer + offset);
+        for (int j = 0; j < 4; j++) {
+            writeFloat(packet.points[i].speeds[j], buffer + offset + 4 + j * 4);
+        }
+        offset += ProtocolConstants::TRAJECTORY_POINT_SIZE;
+    }
+    return offset;
+}
+
+/**
+ * @brief Serializes a time sync request or reply into the buffer. Requests leave out the robot
+ * times.
+ * @param ProtocolConstants::TIME_REQUEST or ProtocolConstants::TIME_REPLY.
+ * @param Packet to serialize.
+ * @param Buffer of at least ProtocolConstants::TIME_REPLY_SIZE bytes.
+ * @return Number of bytes written.
+ */
+int Protocol::encodeTimeSync(unsigned char type, const TimeSyncPacket &packet, char *buffer)
+{
+    int offset = encodeHeader(type, buffer);
+    qToLittleEndian<quint32>(packet.id, buffer + offset);
+    qToLittleEndian<quint64>(packet.originate, buffer + offset + 4);
+    if (type == ProtocolConstants::TIME_REQUEST) {
+        return ProtocolConstants::TIME_REQUEST_SIZE;
+    }
+    qToLittleEndian<quint64>(packet.receive, buffer + offset + 12);
+    qToLittleEndian<quint64>(packet.transmit, buffer + offset + 20);
+    return ProtocolConstants::TIME_REPLY_SIZE;
+}
+
+/**
+ * @brief Serializes a handshake hello or ack into the buffer.
+ * @param ProtocolConstants::HELLO or ProtocolConstants::HELLO_ACK.
+ * @param Packet to serialize.
+ * @param Buffer of at least ProtocolConstants::HELLO_SIZE bytes.
+ * @return Number of bytes written.
+ */
+int Protocol::encodeHello(unsigned char type, const HelloPacket &packet, char *buffer)
+{
+    int offset = encodeHeader(type, buffer);
+    qToLittleEndian<quint16>(packet.version, buffer + offset);
+    qToLittleEndian<quint16>(0, buffer + offset + 2);
+    qToLittleEndian<quint32>(packet.capabilities, buffer + offset + 4);
+    return ProtocolConstants::HELLO_SIZE;
+}
+
+/**
+ * @brief Serializes a quantized movement packet into the buffer without any allocation.
+ * @param Packet to serialize, speeds already quantized to its bits with quantize.
+ * @param Buffer of at least ProtocolConstants::QUANTIZED16_SIZE bytes.
+ * @return Number of bytes written.
+ */
+int Protocol::encodeQuantized(const QuantizedPacket &packet, char *buffer)
+{
+    bool wide = packet.bits == 16;
+    int offset = encodeHeader(wide ? ProtocolConstants::QUANTIZED16 : ProtocolConstants::QUANTIZED8,
+                              buffer);
+    buffer[3] = char(packet.sequence);
+    for (int i = 0; i < 4; i++) {
+        if (wide) {
+            qToLittleEndian<qint16>(packet.speeds[i], buffer + offset + i * 2);
+        } else {
+            buffer[offset + i] = char(qint8(packet.speeds[i]));
+        }
+    }
+    return wide ? ProtocolConstants::QUANTIZED16_SIZE : ProtocolConstants::QUANTIZED8_SIZE;
+}
+
+/**
+ * @brief Serializes a telemetry sample into the buffer. Used by clients and test tools.
+ * @param Sample to serialize, its type selects the layout.
+ * @param Buffer of at least ProtocolConstants::ENCODER_SIZE bytes.
+ * @return Number of bytes written, 0 for an unknown type.
+ */
+int Protocol::encodeTelemetry(const TelemetrySample &sample, char *buffer)
+{
+    encodeHeader(sample.type, buffer);
+    qToLittleEndian<quint64>(sample.robotTime, buffer + 4);
+    char *fields = buffer + 12;
+    switch (sample.type) {
+    case ProtocolConstants::IMU:
+        for (int i = 0; i < 3; i++) {
+            writeFloat(sample.imu.accel[i], fields + i * 4);
+            writeFloat(sample.imu.gyro[i], fields + 12 + i * 4);
+        }
+        return ProtocolConstants::IMU_SIZE;
+    case ProtocolConstants::ENCODER:
+        for (int i = 0; i < 4; i++) {
+            qToLittleEndian<qint32>(sample.encoder.ticks[i], fields + i * 4);
+            writeFloat(sample.encoder.velocity[i], fields + 16 + i * 4);
+        }
+        return ProtocolConstants::ENCODER_SIZE;
+    case ProtocolConstants::BATTERY:
+        writeFloat(sample.battery.voltage, fields);
+        writeFloat(sample.battery.current, fields + 4);
+        writeFloat(sample.battery.charge, fields + 8);
+        return ProtocolConstants::BATTERY_SIZE;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Parses a movement packet in place from the receive buffer. Used by clients and test
+ * tools.
+ * @param Datagram payload, must already be checked with isBinary.
+ * @param Payload size.
+ * @param Packet to fill.
+ * @return True if the payload was large enough, otherwise false.
+ */
+bool Protocol::decodeMovement(const char *data, qint64 size, MovementPacket &packet)
+{
+    if (size < ProtocolConstants::MOVEMENT_SIZE) {
+        return false;
+    }
+    packet.sequence = qFromLittleEndian<quint32>(data + 4);
+    packet.timestamp = qFromLittleEndian<quint64>(data + 8);
+    for (int i = 0; i < 4; i++) {
+        packet.speeds[i] = readFloat(data + 16 + i * 4);
+    }
+    return true;
+}
+
+/**
+ * @brief Parses a heartbeat packet in place from the receive buffer.
+ * @param Datagram payload, must already be checked with isBinary.
+ * @param Payload size.
+ * @param Packet to fill.
+ * @return True if the payload was large enough, otherwise false.
+ */
+bool Protocol::decodeHeartbeat(const char *data, qint64 size, HeartbeatPacket &packet)
+{
+    if (size < ProtocolConstants::HEARTBEAT_BASE_SIZE) {
+        return false;
+    }
+    packet.echoSequence = qFromLittleEndian<quint32>(data + 4);
+    packet.receivedCount = qFromLittleEndian<quint32>(data + 8);
+    packet.echoReceiveTime = size < ProtocolConstants::HEARTBEAT_RECEIVE_SIZE
+                                 ? 0
+                                 : qFromLittleEndian<quint64>(data + 12);
+    packet.transmitTime = size < ProtocolConstants::HEARTBEAT_SIZE
+                              ? 0
+                              : qFromLittleEndian<quint64>(data + 20);
+    return true;
+}
+
+/**
+ * @brief Parses a discovery announce or reply in place from the receive buffer.
+ * @param Datagram payload, must already be checked with isBinary.
+ * @param Payload size.
+ * @param Packet to fill.
+ * @return True if the payload was large enough, otherwise false.
+ */
+bool Protocol::decodeAnnounce(const char *data, qint64 size, AnnouncePacket &packet)
+{
+    if (size < ProtocolConstants::ANNOUNCE_SIZE) {
+        return false;
+    }
+    packet.nonce = qFromLittleEndian<quint32>(data + 4);
+    return true;
+}
+
+/**
+ * @brief Parses an emergency stop in place from the receive buffer. Used by clients and test
+ * tools.
+ * @param Datagram payload, must already be checked with isBinary.
+ * @param Payload size.
+ * @param Packet to fill.
+ * @return True if the payload was large enough, otherwise false.
+ */
+bool Protocol::decodeStop(const char *data, qint64 size, StopPacket &packet)
+{
+    if (size < ProtocolConstants::STOP_SIZE) {
+        return false;
+    }
+    packet.id = qFromLittleEndian<quint32>(data + 4);
+    return true;
+}
+
+/**
+ * @brief Parses a trajectory chunk in place from the receive buffer. Used by clients and test
+ * tools.
+ * @param Datagram payload, must already be checked with isBinary.
+ * @param Payload size.
+ * @param Packet to fill.
+ * @return True if the point count is valid and all points are in the payload, otherwise false.
+ */
+bool Protocol::decodeTrajectory(const char *data, qint64 size, TrajectoryPacket &packet)
+{
+    if (size < ProtocolConstants::TRAJECTORY_HEADER_SIZE) {
+        return false;
+    }
+    packet.count = static_cast<unsigned char>(data[16]);
+    if (packet.count < 1 || packet.count > ProtocolConstants::MAX_TRAJECTORY_POINTS
+        || size < ProtocolConstants::TRAJECTORY_HEADER_SIZE
+                      + packet.count * ProtocolConstants::TRAJECTORY_POINT_SIZE) {
+        return false;
+    }
+    packet.sequence = qFromLittleEndian<quint32>(data + 4);
+    packet.timestamp = qFromLittleEndian<quint64>(data + 8);
+    const char *point = data + ProtocolConstants::TRAJECTORY_HEADER_SIZE;
+    for (int i = 0; i < packet.count; i++) {
+        packet.points[i].offset = qFromLittleEndian<quint32>(point);
+        for (int j = 0; j < 4; j++) {
+            packet.points[i].speeds[j] = readFloat(point + 4 + j * 4);
+        }
+        point += ProtocolConstants::TRAJECTORY_POINT_SIZE;
+    }
+    return true;
+}
+
+/**
+ * @brief Parses a time sync request or reply in place from the receive buffer. The robot
+ * times are set to 0 for a request.
+ * @param Datagram payload, must already be checked with isBinary.
+ * @param Payload size.
+ * @param Packet to fill.
+ * @return True if the payload was large enough for its type, otherwise false.
+ */
+bool Protocol::decodeTimeSync(const char *data, qint64 size, TimeSyncPacket &packet)
+{
+    bool reply = packetType(data) == ProtocolConstants::TIME_REPLY;
+    int expected = reply ? ProtocolConstants::TIME_REPLY_SIZE
+                         : ProtocolConstants::TIME_REQUEST_SIZE;
+    if (size < expected) {
+        return false;
+    }
+    packet.id = qFromLittleEndian<quint32>(data + 4);
+    packet.originate = qFromLittleEndian<quint64>(data + 8);
+    packet.receive = reply ? qFromLittleEndian<quint64>(data + 16) : 0;
+    packet.transmit = reply ? qFromLittleEndian<quint64>(data + 24) : 0;
+    return true;
+}
+
+/**
+ * @brief Parses a handshake hello or ack in place from the receive buffer.
+ * @param Datagram payload, must already be checked with isBinary.
+ * @param Payload size.
+ * @param Packet to fill.
+ * @return True if the payload was large enough, otherwise false.
+ */
+bool Protocol::decodeHello(const char *data, qint64 size, HelloPacket &packet)
+{
+    if (size < ProtocolConstants::HELLO_SIZE) {
+        return false;
+    }
+    packet.version = qFromLittleEndian<quint16>(data + 4);
+    packet.capabilities = qFromLittleEndian<quint32>(data + 8);
+    return true;
+}
+
+/**
+ * @brief Parses a quantized movement packet in place from the receive buffer. The speeds stay
+ * quantized, dequantize turns them back into -1 to 1.
+ * @param Datagram payload, must already be checked with isBinary.
+ * @param Payload size.
+ * @param Packet to fill.
+ * @return True if the payload is a complete quantized packet, otherwise false.
+ */
+bool Protocol::decodeQuantized(const char *data, qint64 size, QuantizedPacket &packet)
+{
+    unsigned char type = packetType(data);
+    if (type == ProtocolConstants::QUANTIZED16 && size >= ProtocolConstants::QUANTIZED16_SIZE) {
+        packet.bits = 16;
+        for (int i = 0; i < 4; i++) {
+            packet.speeds[i] = qFromLittleEndian<qint16>(data + 4 + i * 2);
+        }
+    } else if (type == ProtocolConstants::QUANTIZED8
+               && size >= ProtocolConstants::QUANTIZED8_SIZE) {
+        packet.bits = 8;
+        for (int i = 0; i < 4; i++) {
+            packet.speeds[i] = qint8(data[4 + i]);
+        }
+    } else {
+        return false;
+    }
+    packet.sequence = quint8(data[3]);
+    return true;
+}
+
+/**
+ * @brief Writes the header of a control channel frame. The payload follows it on the stream.
+ * @param Header to encode.
+ * @param Buffer of at least ProtocolConstants::CONTROL_HEADER_SIZE bytes.
+ * @return Number of bytes written.
+ */
+int Protocol::encodeControlHeader(const ControlHeader &header, char *buffer)
+{
+    int offset = encodeHeader(header.type, buffer);
+    qToLittleEndian<quint32>(header.length, buffer + offset);
+    return ProtocolConstants::CONTROL_HEADER_SIZE;
+}
+
+/**
+ * @brief Parses the header of a control channel frame from the start of the stream buffer.
+ * @param Buffered stream data.
+ * @param Buffered size.
+ * @param Header to fill.
+ * @return True if a complete header with a known magic and version was read, otherwise false.
+ */
+bool Protocol::decodeControlHeader(const char *data, qint64 size, ControlHeader &header)
+{
+    if (size < ProtocolConstants::CONTROL_HEADER_SIZE || !isBinary(data, size)) {
+        return false;
+    }
+    header.type = packetType(data);
+    header.length = qFromLittleEndian<quint32>(data + 4);
+    return true;
+}
+
+/**
+ * @brief Checks if a binary datagram is a complete telemetry packet of a known type.
+ * @param Datagram payload, must already be checked with isBinary.
+ * @param Payload size.
+ * @return True if decodeTelemetry can be called on the payload.
+ */
+bool Protocol::isTelemetry(const char *data, qint64 size)
+{
+    switch (packetType(data)) {
+    case ProtocolConstants::IMU:
+        return size >= ProtocolConstants::IMU_SIZE;
+    case ProtocolConstants::ENCODER:
+        return size >= ProtocolConstants::ENCODER_SIZE;
+    case ProtocolConstants::BATTERY:
+        return size >= ProtocolConstants::BATTERY_SIZE;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Parses a telemetry packet straight from the receive buffer into its destination,
+ * normally a slot of the telemetry ring. Receive time and robot are left to the caller.
+ * @param Datagram payload, must already be checked with isTelemetry.
+ * @param Sample to fill.
+ */
+void Protocol::decodeTelemetry(const char *data, TelemetrySample &sample)
+{
+    sample.type = packetType(data);
+    sample.robotTime = qFromLittleEndian<quint64>(data + 4);
+    const char *fields = data + 12;
+    switch (sample.type) {
+    case ProtocolConstants::IMU:
+        for (int i = 0; i < 3; i++) {
+            sample.imu.accel[i] = readFloat(fields + i * 4);
+            sample.imu.gyro[i] = readFloat(fields + 12 + i * 4);
+        }
+        break;
+    case ProtocolConstants::ENCODER:
+        for (int i = 0; i < 4; i++) {
+            sample.encoder.ticks[i] = qFromLittleEndian<qint32>(fields + i * 4);
+            sample.encoder.velocity[i] = readFloat(fields + 16 + i * 4);
+        }
+        break;
+    case ProtocolConstants::BATTERY:
+        sample.battery.voltage = readFloat(fields);
+        sample.battery.current = readFloat(fields + 4);
+        sample.battery.charge = readFloat(fields + 8);
+        break;
+    }
+}
+
+/**
+ * @brief Checks if a received datagram carries a binary header.
+ * @param Datagram payload.
+ * @param Payload size.
+ * @return True if the payload starts with a known magic and version.
+ */
+bool Protocol::isBinary(const char *data, qint64 size)
+{
+    return size >= ProtocolConstants::HEADER_SIZE
+           && (unsigned char) data[0] == ProtocolConstants::MAGIC
+           && (unsigned char) data[1] == ProtocolConstants::VERSION;
+}
+
+/**
+ * @brief Gets the packet type of a binary datagram. Only valid after isBinary.
+ * @param Datagram payload.
+ * @return Packet type as a constant from ProtocolConstants.
+ */
+unsigned char Protocol::packetType(const char *data)
+{
+    return (unsigned char) data[2];
+}
+
+/**
+ * @brief Quantizes a wheel speed to a signed integer of the given width, rounding to the
+ * nearest step. Speeds outside -1 to 1 are clamped. Dequantizing and quantizing again gives the
+ * same value, so a speed survives any number of round trips at that resolution.
+ * @param Wheel speed, normally -1 to 1.
+ * @param 16 or 8 bits.
+ * @return Quantized speed, within +-(2^(bits-1) - 1).
+ */
+qint16 Protocol::quantize(double speed, int bits)
+{
+    int scale = (1 << (bits - 1)) - 1;
+    return qint16(std::lround(std::clamp(speed, -1.0, 1.0) * scale));
+}
+
+/**
+ * @brief Turns a quantized wheel speed back into -1 to 1.
+ * @param Quantized speed.
+ * @param 16 or 8 bits, the width it was quantized with.
+ * @return Wheel speed.
+ */
+double Protocol::dequantize(qint16 value, int bits)
+{
+    return double(value) / ((1 << (bits - 1)) - 1);
+}
+
+/**
+ * @brief Restores a full sequence from its low 8 bits, as carried by quantized packets and
+ * echoed back in their heartbeats.
+ * @param Low 8 bits of the sequence.
+ * @param Full sequence known to be close, within 128 either way.
+ * @return Sequence nearest to the reference that ends in the low bits.
+ */
+quint32 Protocol::expandSequence(quint8 low, quint32 reference)
+{
+    return reference + quint32(qint32(qint8(quint8(low - quint8(reference)))));
+}
@@ -0,0 +1,261 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include "constants.h"
+
+#include <QHostAddress>
+#include <QtEndian>
+#include <QtGlobal>
+
+/**
+ * Non-owning view of a received datagram. The payload stays in the receive buffer it was read
+ * into and is only valid until the next receive call.
+ */
+struct DatagramView
+{
+    const char *data;
+    qint64 size;
+    QHostAddress senderAddress;
+    quint16 senderPort;
+};
+
+/**
+ * Wire layout of a binary movement packet (all fields little-endian):
+ *
+ *  0  u8   magic      ProtocolConstants::MAGIC
+ *  1  u8   version    ProtocolConstants::VERSION
+ *  2  u8   type       ProtocolConstants::MOVEMENT
+ *  3  u8   flags      Reserved, always 0
+ *  4  u32  sequence   Incremented for every packet sent
+ *  8  u64  timestamp  Server monotonic time in microseconds
+ * 16  f32  speeds[4]  Same order as the legacy text datagram, slots past the drive model's
+ *                      wheel count are 0
+ */
+struct MovementPacket
+{
+    quint32 sequence;
+    quint64 timestamp;
+    float speeds[4];
+};
+
+/**
+ * Wire layout of a binary heartbeat sent by the client (all fields little-endian):
+ *
+ *  0  u8   magic, version, type (ProtocolConstants::HEARTBEAT), flags
+ *  4  u32  echoSequence     Sequence of the last movement packet the client received
+ *  8  u32  receivedCount    Total movement packets the client has received
+ * 12  u64  echoReceiveTime  Client clock in microseconds when the echoed packet arrived,
+ *                           0 if unknown. Missing from older clients' 12 byte heartbeats.
+ * 20  u64  transmitTime     Client clock in microseconds when this heartbeat was sent, 0 if
+ *                           unknown. Missing from older clients' 12 and 20 byte heartbeats.
+ *
+ * transmitTime - echoReceiveTime is how long the client held the echo before answering, which
+ * the server takes off the round trip time. Both are on the client clock, so no clock sync is
+ * needed for it.
+ */
+struct HeartbeatPacket
+{
+    quint32 echoSequence;
+    quint32 receivedCount;
+    quint64 echoReceiveTime;
+    quint64 transmitTime;
+};
+
+/**
+ * Discovery packets (all fields little-endian). The server broadcasts an announce to
+ * ProtocolConstants::DISCOVERY_PORT on every interface, a robot answers from the socket it
+ * wants movement packets on with a reply echoing the nonce.
+ *
+ *  0  u8   magic, version, type (ProtocolConstants::ANNOUNCE or ANNOUNCE_REPLY), flags
+ *  4  u32  nonce   Random per discovery round, stale replies are ignored
+ */
+struct AnnouncePacket
+{
+    quint32 nonce;
+};
+
+/**
+ * Emergency stop sent by the server (all fields little-endian). Every stop is sent several
+ * times, the copies share the id so a robot can act on the first one and ignore the rest.
+ *
+ *  0  u8   magic, version, type (ProtocolConstants::STOP), flags
+ *  4  u32  id   Incremented for every stop
+ */
+struct StopPacket
+{
+    quint32 id;
+};
+
+/**
+ * Version and capability handshake (all fields little-endian). Either side may send a hello,
+ * the other answers with an ack carrying its own version and capabilities. Both then use the
+ * lower version and only features in both capability sets.
+ *
+ *  0  u8   magic, version, type (ProtocolConstants::HELLO or HELLO_ACK), flags
+ *  4  u16  version       Highest protocol version the sender speaks
+ *  6  u16  reserved
+ *  8  u32  capabilities  ProtocolConstants::CAP_* bits
+ */
+struct HelloPacket
+{
+    quint16 version;
+    quint32 capabilities;
+};
+
+/**
+ * NTP style time sync exchange (all fields little-endian). The server sends a request stamped
+ * with its clock, the robot answers with the request time echoed and its own clock at
+ * receiving the request and at sending the reply. Times are in microseconds.
+ *
+ *  0  u8   magic, version, type (ProtocolConstants::TIME_REQUEST or TIME_REPLY), flags
+ *  4  u32  id         Incremented for every request, echoed in the reply
+ *  8  u64  originate  Server clock when the request was sent
+ * 16  u64  receive    Robot clock when the request arrived, reply only
+ * 24  u64  transmit   Robot clock when the reply was sent, reply only
+ */
+struct TimeSyncPacket
+{
+    quint32 id;
+    quint64 originate;
+    quint64 receive;
+    quint64 transmit;
+};
+
+/**
+ * Trajectory chunk sent by the server in place of a movement packet (all fields
+ * little-endian). Carries the current setpoint followed by predicted future ones, a robot
+ * interpolates between the points and keeps following them when packets are lost or late.
+ *
+ *  0  u8   magic, version, type (ProtocolConstants::TRAJECTORY), flags
+ *  4  u32  sequence   Shared with movement packets
+ *  8  u64  timestamp  Server monotonic time in microseconds the first point applies at
+ * 16  u8   count      Number of points, 1 to ProtocolConstants::MAX_TRAJECTORY_POINTS
+ * 17  u8   reserved[3]
+ * 20  points, ProtocolConstants::TRAJECTORY_POINT_SIZE bytes each:
+ *      0  u32  offset     Microseconds after the timestamp, increasing
+ *      4  f32  speeds[4]  Same order as the movement packet
+ */
+struct TrajectoryPoint
+{
+    quint32 offset;
+    float speeds[4];
+};
+
+struct TrajectoryPacket
+{
+    quint32 sequence;
+    quint64 timestamp;
+    int count;
+    TrajectoryPoint points[ProtocolConstants::MAX_TRAJECTORY_POINTS];
+};
+
+/**
+ * Quantized movement packet for links where every byte counts. Each wheel speed in -1 to 1 is
+ * scaled to a signed integer of the configured width, a whole command takes 12 bytes at 16 bit
+ * and 8 bytes at 8 bit. There is no timestamp and the flags byte holds the low 8 bits of the
+ * sequence, heartbeats echo them back in the low byte of echoSequence.
+ *
+ *  0  u8   magic, version
+ *  2  u8   type       ProtocolConstants::QUANTIZED16 or QUANTIZED8
+ *  3  u8   sequence   Low 8 bits of the movement sequence
+ *  4  i16 speeds[4] or i8 speeds[4], same order as the movement packet
+ */
+struct QuantizedPacket
+{
+    quint8 sequence;
+    int bits; // 16 or 8
+    qint16 speeds[4];
+};
+
+/**
+ * Control channel frame, sent on a reliable stream next to the datagrams instead of as a
+ * datagram (all fields little-endian). Frames follow each other back to back, the length says
+ * where the next one starts.
+ *
+ *  0  u8   magic, version, type (ProtocolConstants::CONTROL_*), flags
+ *  4  u32  length   Payload bytes following the header
+ *  8  payload, UTF-8 text for every current message type
+ */
+struct ControlHeader
+{
+    unsigned char type;
+    quint32 length;
+};
+
+/**
+ * Telemetry packets sent by the robot (all fields little-endian). Every packet starts with the
+ * common header followed by a u64 robot timestamp in microseconds at offset 4.
+ *
+ * IMU      (ProtocolConstants::IMU)      12 f32 accel[3] m/s^2, 24 f32 gyro[3] rad/s
+ * Encoder  (ProtocolConstants::ENCODER)  12 i32 ticks[4], 28 f32 velocity[4] normalized -1 to 1
+ * Battery  (ProtocolConstants::BATTERY)  12 f32 voltage V, 16 f32 current A, 20 f32 charge 0-1
+ *
+ * Wheel order matches the movement packet.
+ */
+struct ImuData
+{
+    float accel[3];
+    float gyro[3];
+};
+
+struct EncoderData
+{
+    qint32 ticks[4];
+    float velocity[4];
+};
+
+struct BatteryData
+{
+    float voltage;
+    float current;
+    float charge;
+};
+
+/**
+ * A decoded telemetry packet as stored in the telemetry ring.
+ */
+struct TelemetrySample
+{
+    unsigned char type;  // Packet type from ProtocolConstants
+    unsigned char robot; // Fleet index of the sender
+    quint64 robotTime;   // Robot clock in microseconds
+    qint64 receiveTime;  // LatencyTracker::now() when received, in nanoseconds
+    qint64 sendTime;     // Robot time in the receiveTime timebase, 0 until clocks are synced
+    union {
+        ImuData imu;
+        EncoderData encoder;
+        BatteryData battery;
+    };
+};
+
+namespace Protocol {
+int encodeHeader(unsigned char type, char *buffer);
+int encodeMovement(const MovementPacket &packet, char *buffer);
+int encodeHeartbeat(const HeartbeatPacket &packet, char *buffer);
+int encodeAnnounce(unsigned char type, const AnnouncePacket &packet, char *buffer);
+int encodeStop(const StopPacket &packet, char *buffer);
+int encodeTrajectory(const TrajectoryPacket &packet, char *buffer);
+int encodeTimeSync(unsigned char type, const TimeSyncPacket &packet, char *buffer);
+int encodeHello(unsigned char type, const HelloPacket &packet, char *buffer);
+int encodeQuantized(const QuantizedPacket &packet, char *buffer);
+int encodeTelemetry(const TelemetrySample &sample, char *buffer);
+int encodeControlHeader(const ControlHeader &header, char *buffer);
+bool decodeMovement(const char *data, qint64 size, MovementPacket &packet);
+bool decodeHeartbeat(const char *data, qint64 size, HeartbeatPacket &packet);
+bool decodeAnnounce(const char *data, qint64 size, AnnouncePacket &packet);
+bool decodeStop(const char *data, qint64 size, StopPacket &packet);
+bool decodeTrajectory(const char *data, qint64 size, TrajectoryPacket &packet);
+bool decodeTimeSync(const char *data, qint64 size, TimeSyncPacket &packet);
+bool decodeHello(const char *data, qint64 size, HelloPacket &packet);
+bool decodeQuantized(const char *data, qint64 size, QuantizedPacket &packet);
+bool decodeControlHeader(const char *data, qint64 size, ControlHeader &header);
+qint16 quantize(double speed, int bits);
+double dequantize(qint16 value, int bits);
+quint32 expandSequence(quint8 low, quint32 reference);
+bool isTelemetry(const char *data, qint64 size);
+void decodeTelemetry(const char *data, TelemetrySample &sample);
+bool isBinary(const char *data, qint64 size);
+unsigned char packetType(const char *data);
+} // namespace Protocol
+
+#endif // PROTOCOL_H
@@ -0,0 +1,101 @@
+#include "robotendpoint.h"
+
+#include "constants.h"
+
+#include <QStringList>
+#include <algorithm>
+
+/**
+ * @brief Applies this robot's gain and offset to a setpoint.
+ * @param Four wheel speeds as produced by kinematics.
+ * @param Four adjusted wheel speeds, clamped to the IO range.
+ */
+void RobotEndpoint::apply(const double *speeds, double *out) const
+{
+    for (int i = 0; i < 4; i++) {
+        double speed = speeds[i] * gain;
+        if (speed > 0.0) {
+            speed += offset;
+        } else if (speed < 0.0) {
+            speed -= offset;
+        }
+        out[i] = std::clamp(speed, IOConstants::MIN, IOConstants::MAX);
+    }
+}
+
+/**
+ * @brief Formats the endpoint for log messages.
+ * @return Host name or address and port as "host:port".
+ */
+QString RobotEndpoint::toString() const
+{
+    return (host.isEmpty() ? address.toString() : host) + ':' + QString::number(port);
+}
+
+/**
+ * @brief Parses the fleet setting. Entries are separated by commas and written as
+ * address:port[:gain[:offset]], for example "192.168.1.41:12345, robot2.local:12345:0.9:0.05".
+ * Host names are kept in the endpoint with a null address for the caller to resolve.
+ * @param Setting text.
+ * @param List to fill with the parsed robots, cleared first.
+ * @param Set to a description of the first invalid entry.
+ * @return True if every entry was valid, otherwise false.
+ */
+bool Fleet::parse(const QString &text, QVector<RobotEndpoint> &robots, QString &error)
+{
+    robots.clear();
+    const QStringList entries = text.split(',', Qt::SkipEmptyParts);
+    for (const QString &entry : entries) {
+        const QStringList fields = entry.trimmed().split(':');
+        if (fields.size() < 2 || fields.size() > 4) {
+            error = QString("Expected address:port[:gain[:offset]] but got \"") + entry.trimmed()
+                    + "\"";
+            return false;
+        }
+
+        RobotEndpoint robot;
+        bool portOk = false;
+        bool gainOk = true;
+        bool offsetOk = true;
+        if (!robot.address.setAddress(fields[0])) {
+            robot.host = fields[0];
+        }
+        robot.port = fields[1].toUShort(&portOk);
+        robot.gain = fields.size() > 2 ? fields[2].toDouble(&gainOk) : 1.0;
+        robot.offset = fields.size() > 3 ? fields[3].toDouble(&offsetOk) : 0.0;
+        if ((robot.address.isNull() && !isHostName(robot.host)) || !portOk || robot.port == 0
+            || !gainOk || !offsetOk) {
+            error = QString("Invalid fleet entry \"") + entry.trimmed() + "\"";
+            return false;
+        }
+
+        if (robots.size() == ProtocolConstants::MAX_FLEET_SIZE) {
+            error = QString("Fleet is limited to ")
+                    + QString::number(ProtocolConstants::MAX_FLEET_SIZE) + " robots";
+            return false;
+        }
+        robots.append(robot);
+    }
+    return true;
+}
+
+/**
+ * @brief Checks if a text can be a DNS or mDNS host name. Only the characters are checked,
+ * whether the name exists is left to the resolver.
+ * @param Text to check.
+ * @return True for letters, digits, dots and hyphens up to 253 characters, otherwise false.
+ */
+bool Fleet::isHostName(const QString &text)
+{
+    if (text.isEmpty() || text.size() > 253) {
+        return false;
+    }
+    for (const QChar c : text) {
+        bool allowed = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+                       || c == '-' || c == '.';
+        if (!allowed) {
+            return false;
+        }
+    }
+    return true;
+}
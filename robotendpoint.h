@@ -0,0 +1,29 @@
+#ifndef ROBOTENDPOINT_H
+#define ROBOTENDPOINT_H
+
+#include <QHostAddress>
+#include <QString>
+#include <QVector>
+
+/**
+ * A robot that receives setpoints. Gain scales every wheel speed, offset is added in the
+ * direction of travel to overcome motor deadband. A stopped wheel always stays at 0.
+ */
+struct RobotEndpoint
+{
+    QString host;         // Name the address is resolved from, empty for literal addresses
+    QHostAddress address; // Null while the host is not resolved yet
+    quint16 port;
+    double gain;
+    double offset;
+
+    void apply(const double *speeds, double *out) const;
+    QString toString() const;
+};
+
+namespace Fleet {
+bool parse(const QString &text, QVector<RobotEndpoint> &robots, QString &error);
+bool isHostName(const QString &text);
+} // namespace Fleet
+
+#endif // ROBOTENDPOINT_H
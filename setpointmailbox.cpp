@@ -0,0 +1,42 @@
+#include "setpointmailbox.h"
+
+// Constructor
+SetpointMailbox::SetpointMailbox()
+    : middle(1)
+{
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 4; j++) {
+            buffers[i].speeds[j] = 0.0;
+        }
+        buffers[i].inputTime = 0;
+        buffers[i].kinematicsTime = 0;
+    }
+    back = 0;
+    front = 2;
+}
+
+/**
+ * @brief Publishes a new setpoint, replacing any that has not been fetched yet. Must only be
+ * called from the producer thread.
+ * @param Setpoint to publish.
+ */
+void SetpointMailbox::publish(const Setpoint &setpoint)
+{
+    buffers[back] = setpoint;
+    back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+}
+
+/**
+ * @brief Fetches the newest setpoint. Must only be called from the consumer thread.
+ * @param Setpoint that is filled with the newest published value.
+ * @return True if the setpoint was published since the last fetch, otherwise false.
+ */
+bool SetpointMailbox::fetch(Setpoint &setpoint)
+{
+    bool fresh = middle.load(std::memory_order_relaxed) & FRESH;
+    if (fresh) {
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+    setpoint = buffers[front];
+    return fresh;
+}
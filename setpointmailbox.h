@@ -0,0 +1,36 @@
+#ifndef SETPOINTMAILBOX_H
+#define SETPOINTMAILBOX_H
+
+#include <atomic>
+#include <QtGlobal>
+
+struct Setpoint
+{
+    double speeds[4];
+    qint64 inputTime;      // LatencyTracker time of the input event that caused it
+    qint64 kinematicsTime; // LatencyTracker time the speeds were computed
+};
+
+/**
+ * Lock-free single-producer/single-consumer mailbox that always holds the newest setpoint.
+ * Implemented as a triple buffer: the producer and consumer each own one slot and swap
+ * with the shared middle slot, so neither side ever waits on the other.
+ */
+class SetpointMailbox
+{
+public:
+    SetpointMailbox();
+    void publish(const Setpoint &setpoint);
+    bool fetch(Setpoint &setpoint);
+
+private:
+    static constexpr int INDEX_MASK = 0x3;
+    static constexpr int FRESH = 0x4;
+
+    Setpoint buffers[3];
+    std::atomic<int> middle;
+    int back;
+    int front;
+};
+
+#endif // SETPOINTMAILBOX_H
@@ -47,6 +47,16 @@ void SettingsHandler::resetSettings()
     emit signalConn_CommAddressText(SettingsConstants::D_CONN_COMM_ADDRESS);
     emit signalConn_CommPortText(SettingsConstants::D_CONN_COMM_PORT);
     emit signalConn_CommEnButton(SettingsConstants::D_CONN_COMM_EN);
+    emit signalConn_CommFormatCombo(SettingsConstants::D_CONN_COMM_FORMAT);
+    emit signalConn_CommRateCombo(SettingsConstants::D_CONN_COMM_RATE);
+    emit signalConn_CommFleetText(SettingsConstants::D_CONN_COMM_FLEET);
+    emit signalConn_CommSuppressCombo(SettingsConstants::D_CONN_COMM_SUPPRESS);
+    emit signalConn_CommDiscoveryCombo(SettingsConstants::D_CONN_COMM_DISCOVERY);
+    emit signalConn_CommStopCombo(SettingsConstants::D_CONN_COMM_STOP);
+    emit signalConn_CommStopButtonCombo(SettingsConstants::D_CONN_COMM_STOP_BUTTON);
+    emit signalConn_CommHorizonCombo(SettingsConstants::D_CONN_COMM_HORIZON);
+    emit signalConn_CommQuantizationCombo(SettingsConstants::D_CONN_COMM_QUANTIZATION);
+    emit signalConn_CommDriveCombo(SettingsConstants::D_CONN_COMM_DRIVE);
     emit signalGraph_PerformEnButton(SettingsConstants::D_GRAPH_PERF_EN);
     emit signalGraph_PerformQualCombo(SettingsConstants::D_GRAPH_PERF_QUAL);
     emit signalGraph_PerformPointsSlider(SettingsConstants::D_GRAPH_PERF_POINTS);
@@ -67,6 +77,16 @@ void SettingsHandler::applySettings(QString conn_CamAddressText,
                                     QString conn_CommAddressText,
                                     QString conn_CommPortText,
                                     bool conn_CommEnButton,
+                                    int conn_CommFormatCombo,
+                                    int conn_CommRateCombo,
+                                    QString conn_CommFleetText,
+                                    int conn_CommSuppressCombo,
+                                    int conn_CommDiscoveryCombo,
+                                    int conn_CommStopCombo,
+                                    int conn_CommStopButtonCombo,
+                                    int conn_CommHorizonCombo,
+                                    int conn_CommQuantizationCombo,
+                                    int conn_CommDriveCombo,
                                     bool graph_PerformEnButton,
                                     int graph_PerformQualCombo,
                                     int graph_PerformPointsSlider,
@@ -82,6 +102,16 @@ void SettingsHandler::applySettings(QString conn_CamAddressText,
                  conn_CommAddressText,
                  conn_CommPortText,
                  conn_CommEnButton,
+                 conn_CommFormatCombo,
+                 conn_CommRateCombo,
+                 conn_CommFleetText,
+                 conn_CommSuppressCombo,
+                 conn_CommDiscoveryCombo,
+                 conn_CommStopCombo,
+                 conn_CommStopButtonCombo,
+                 conn_CommHorizonCombo,
+                 conn_CommQuantizationCombo,
+                 conn_CommDriveCombo,
                  graph_PerformEnButton,
                  graph_PerformQualCombo,
                  graph_PerformPointsSlider,
@@ -115,6 +145,36 @@ void SettingsHandler::displaySettings()
             .toString());
     emit signalConn_CommEnButton(
         settings->value(SettingsConstants::CONN_COMM_EN, SettingsConstants::D_CONN_COMM_EN).toBool());
+    emit signalConn_CommFormatCombo(
+        settings->value(SettingsConstants::CONN_COMM_FORMAT, SettingsConstants::D_CONN_COMM_FORMAT)
+            .toInt());
+    emit signalConn_CommRateCombo(
+        settings->value(SettingsConstants::CONN_COMM_RATE, SettingsConstants::D_CONN_COMM_RATE)
+            .toInt());
+    emit signalConn_CommFleetText(
+        settings->value(SettingsConstants::CONN_COMM_FLEET, SettingsConstants::D_CONN_COMM_FLEET)
+            .toString());
+    emit signalConn_CommSuppressCombo(
+        settings->value(SettingsConstants::CONN_COMM_SUPPRESS, SettingsConstants::D_CONN_COMM_SUPPRESS)
+            .toInt());
+    emit signalConn_CommDiscoveryCombo(
+        settings->value(SettingsConstants::CONN_COMM_DISCOVERY, SettingsConstants::D_CONN_COMM_DISCOVERY)
+            .toInt());
+    emit signalConn_CommStopCombo(
+        settings->value(SettingsConstants::CONN_COMM_STOP, SettingsConstants::D_CONN_COMM_STOP)
+            .toInt());
+    emit signalConn_CommStopButtonCombo(
+        settings->value(SettingsConstants::CONN_COMM_STOP_BUTTON, SettingsConstants::D_CONN_COMM_STOP_BUTTON)
+            .toInt());
+    emit signalConn_CommHorizonCombo(
+        settings->value(SettingsConstants::CONN_COMM_HORIZON, SettingsConstants::D_CONN_COMM_HORIZON)
+            .toInt());
+    emit signalConn_CommQuantizationCombo(
+        settings->value(SettingsConstants::CONN_COMM_QUANTIZATION, SettingsConstants::D_CONN_COMM_QUANTIZATION)
+            .toInt());
+    emit signalConn_CommDriveCombo(
+        settings->value(SettingsConstants::CONN_COMM_DRIVE, SettingsConstants::D_CONN_COMM_DRIVE)
+            .toInt());
 
     // Graph
     emit signalGraph_PerformEnButton(
@@ -162,6 +222,16 @@ void SettingsHandler::saveSettings(QString conn_CamAddressText,
                                    QString conn_CommAddressText,
                                    QString conn_CommPortText,
                                    bool conn_CommEnButton,
+                                   int conn_CommFormatCombo,
+                                   int conn_CommRateCombo,
+                                   QString conn_CommFleetText,
+                                   int conn_CommSuppressCombo,
+                                   int conn_CommDiscoveryCombo,
+                                   int conn_CommStopCombo,
+                                   int conn_CommStopButtonCombo,
+                                   int conn_CommHorizonCombo,
+                                   int conn_CommQuantizationCombo,
+                                   int conn_CommDriveCombo,
                                    bool graph_PerformEnButton,
                                    int graph_PerformQualCombo,
                                    int graph_PerformPointsSlider,
@@ -181,6 +251,16 @@ void SettingsHandler::saveSettings(QString conn_CamAddressText,
     settings->setValue(SettingsConstants::CONN_COMM_ADDRESS, conn_CommAddressText);
     settings->setValue(SettingsConstants::CONN_COMM_PORT, conn_CommPortText);
     settings->setValue(SettingsConstants::CONN_COMM_EN, conn_CommEnButton);
+    settings->setValue(SettingsConstants::CONN_COMM_FORMAT, conn_CommFormatCombo);
+    settings->setValue(SettingsConstants::CONN_COMM_RATE, conn_CommRateCombo);
+    settings->setValue(SettingsConstants::CONN_COMM_FLEET, conn_CommFleetText);
+    settings->setValue(SettingsConstants::CONN_COMM_SUPPRESS, conn_CommSuppressCombo);
+    settings->setValue(SettingsConstants::CONN_COMM_DISCOVERY, conn_CommDiscoveryCombo);
+    settings->setValue(SettingsConstants::CONN_COMM_STOP, conn_CommStopCombo);
+    settings->setValue(SettingsConstants::CONN_COMM_STOP_BUTTON, conn_CommStopButtonCombo);
+    settings->setValue(SettingsConstants::CONN_COMM_HORIZON, conn_CommHorizonCombo);
+    settings->setValue(SettingsConstants::CONN_COMM_QUANTIZATION, conn_CommQuantizationCombo);
+    settings->setValue(SettingsConstants::CONN_COMM_DRIVE, conn_CommDriveCombo);
 
     // Graph
     settings->setValue(SettingsConstants::GRAPH_PERF_EN, graph_PerformEnButton);
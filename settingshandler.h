@@ -24,6 +24,16 @@ public:
                        QString conn_CommAddressText,
                        QString conn_CommPortText,
                        bool conn_CommEnButton,
+                       int conn_CommFormatCombo,
+                       int conn_CommRateCombo,
+                       QString conn_CommFleetText,
+                       int conn_CommSuppressCombo,
+                       int conn_CommDiscoveryCombo,
+                       int conn_CommStopCombo,
+                       int conn_CommStopButtonCombo,
+                       int conn_CommHorizonCombo,
+                       int conn_CommQuantizationCombo,
+                       int conn_CommDriveCombo,
                        bool graph_PerformEnButton,
                        int graph_PerformQualCombo,
                        int graph_PerformPointsSlider,
@@ -48,6 +58,16 @@ signals:
     void signalConn_CommAddressText(QString);
     void signalConn_CommPortText(QString);
     void signalConn_CommEnButton(bool);
+    void signalConn_CommFormatCombo(int);
+    void signalConn_CommRateCombo(int);
+    void signalConn_CommFleetText(QString);
+    void signalConn_CommSuppressCombo(int);
+    void signalConn_CommDiscoveryCombo(int);
+    void signalConn_CommStopCombo(int);
+    void signalConn_CommStopButtonCombo(int);
+    void signalConn_CommHorizonCombo(int);
+    void signalConn_CommQuantizationCombo(int);
+    void signalConn_CommDriveCombo(int);
     void signalGraph_PerformEnButton(bool);
     void signalGraph_PerformQualCombo(int);
     void signalGraph_PerformPointsSlider(int);
@@ -69,6 +89,16 @@ private:
                       QString conn_CommAddressText,
                       QString conn_CommPortText,
                       bool conn_CommEnButton,
+                      int conn_CommFormatCombo,
+                      int conn_CommRateCombo,
+                      QString conn_CommFleetText,
+                      int conn_CommSuppressCombo,
+                      int conn_CommDiscoveryCombo,
+                      int conn_CommStopCombo,
+                      int conn_CommStopButtonCombo,
+                      int conn_CommHorizonCombo,
+                      int conn_CommQuantizationCombo,
+                      int conn_CommDriveCombo,
                       bool graph_PerformEnButton,
                       int graph_PerformQualCombo,
                       int graph_PerformPointsSlider,
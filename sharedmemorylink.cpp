@@ -0,0 +1,445 @@
+#include "sharedmemorylink.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Single producer, single consumer ring of datagrams. Head and tail count datagrams forever and
+ * wrap at 2^32, a slot holds datagram i until datagram i + SLOT_COUNT is written. Head and tail
+ * sit on their own cache lines so the two processes do not share a line on every datagram.
+ */
+struct SharedMemoryLink::Ring
+{
+    alignas(64) std::atomic<quint32> head; // Written by the producer, the futex word
+    std::atomic<quint32> sleeping;          // 1 while the consumer sleeps or is about to
+    alignas(64) std::atomic<quint32> tail;  // Written by the consumer
+
+    struct Packet
+    {
+        quint32 size;
+        char data[ProtocolConstants::MAX_PACKET_SIZE];
+    };
+    Packet packets[SharedMemoryConstants::SLOT_COUNT];
+};
+
+struct SharedMemoryLink::Segment
+{
+    std::atomic<quint32> magic; // SharedMemoryConstants::MAGIC once the rings are set up
+    quint32 layout;
+    Ring toRobot;
+    Ring toServer;
+};
+
+// The futex calls operate on the atomics in place
+static_assert(sizeof(std::atomic<quint32>) == sizeof(quint32)
+                  && std::atomic<quint32>::is_always_lock_free,
+              "shared ring counters must be plain lock-free words");
+
+namespace {
+#ifdef Q_OS_LINUX
+/**
+ * @brief Waits on or wakes a futex word. Never FUTEX_PRIVATE_FLAG, the word is shared with
+ * another process.
+ */
+long futex(std::atomic<quint32> *word, int operation, quint32 value, const timespec *timeout)
+{
+    return ::syscall(SYS_futex,
+                     reinterpret_cast<quint32 *>(word),
+                     operation,
+                     value,
+                     timeout,
+                     nullptr,
+                     0);
+}
+#endif
+} // namespace
+
+SharedMemoryLink::SharedMemoryLink()
+{
+    segment = nullptr;
+    incoming = nullptr;
+    outgoing = nullptr;
+    descriptor = -1;
+    owner = false;
+    notified = false;
+    quit = false;
+}
+
+SharedMemoryLink::~SharedMemoryLink()
+{
+    close();
+}
+
+/**
+ * @brief Checks if the shared memory transport is available on this platform.
+ * @return True on Linux, otherwise false.
+ */
+bool SharedMemoryLink::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Checks if a client address selects the shared memory transport.
+ * @param Client address as configured.
+ * @return True if it starts with SharedMemoryConstants::SCHEME, otherwise false.
+ */
+bool SharedMemoryLink::isSharedMemoryAddress(const QString &address)
+{
+    return address.startsWith(SharedMemoryConstants::SCHEME, Qt::CaseInsensitive);
+}
+
+/**
+ * @brief Gets the segment name from a shared memory address such as "shm://sim".
+ * @param Client address as configured.
+ * @return Name after the scheme, empty if the address is not a valid shared memory address.
+ */
+QString SharedMemoryLink::nameFromAddress(const QString &address)
+{
+    if (!isSharedMemoryAddress(address)) {
+        return QString();
+    }
+    QString name = address.mid(int(std::strlen(SharedMemoryConstants::SCHEME)));
+    if (name.contains('/')) {
+        return QString(); // POSIX object names are a single path component
+    }
+    return name;
+}
+
+/**
+ * @brief Creates a fresh segment, replacing one a previous server left behind. Done by the
+ * server, the segment is removed again on close.
+ * @param Segment name without the scheme.
+ * @return True if the link is open, otherwise false and errorString() tells why.
+ */
+bool SharedMemoryLink::create(const QString &name)
+{
+    close();
+    objectName = QString(SharedMemoryConstants::NAME_PREFIX) + name;
+    return map(true);
+}
+
+/**
+ * @brief Attaches to the segment a server created. Done by the robot simulator.
+ * @param Segment name without the scheme.
+ * @return True if the link is open, otherwise false and errorString() tells why.
+ */
+bool SharedMemoryLink::attach(const QString &name)
+{
+    close();
+    objectName = QString(SharedMemoryConstants::NAME_PREFIX) + name;
+    return map(false);
+}
+
+/**
+ * @brief Maps the segment named objectName.
+ * @param True to create it as the server, false to attach to it as the simulator.
+ * @return True if the link is open, otherwise false.
+ */
+bool SharedMemoryLink::map(bool create)
+{
+#ifdef Q_OS_LINUX
+    QByteArray path = objectName.toLocal8Bit();
+    if (create) {
+        ::shm_unlink(path.constData()); // Left behind by a server that crashed
+        descriptor = ::shm_open(path.constData(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    } else {
+        descriptor = ::shm_open(path.constData(), O_RDWR, 0);
+    }
+    if (descriptor < 0) {
+        error = QString::fromLocal8Bit(std::strerror(errno));
+        return false;
+    }
+    owner = create;
+
+    struct stat status;
+    if (create && !(::ftruncate(descriptor, sizeof(Segment)) == 0)) {
+        error = QString::fromLocal8Bit(std::strerror(errno));
+        close();
+        return false;
+    }
+    if (!create
+        && (!(::fstat(descriptor, &status) == 0) || status.st_size < off_t(sizeof(Segment)))) {
+        error = "Segment is not set up yet";
+        close();
+        return false;
+    }
+
+    void *memory = ::mmap(nullptr,
+                          sizeof(Segment),
+                          PROT_READ | PROT_WRITE,
+                          MAP_SHARED,
+                          descriptor,
+                          0);
+    if (memory == MAP_FAILED) {
+        error = QString::fromLocal8Bit(std::strerror(errno));
+        close();
+        return false;
+    }
+
+    if (create) {
+        segment = new (memory) Segment();
+        segment->layout = SharedMemoryConstants::LAYOUT;
+        segment->magic.store(SharedMemoryConstants::MAGIC, std::memory_order_release);
+        incoming = &segment->toServer;
+        outgoing = &segment->toRobot;
+        return true;
+    }
+
+    segment = static_cast<Segment *>(memory);
+    if (!(segment->magic.load(std::memory_order_acquire) == SharedMemoryConstants::MAGIC)
+        || !(segment->layout == SharedMemoryConstants::LAYOUT)) {
+        error = "Segment is not set up yet or from a different version";
+        close();
+        return false;
+    }
+    incoming = &segment->toRobot;
+    outgoing = &segment->toServer;
+    return true;
+#else
+    Q_UNUSED(create)
+    error = "Shared memory transport is only supported on Linux";
+    return false;
+#endif
+}
+
+/**
+ * @brief Stops the waiter thread and unmaps the segment. The server also removes it, a
+ * simulator still attached notices through isOrphaned().
+ */
+void SharedMemoryLink::close()
+{
+    stopWaiting();
+#ifdef Q_OS_LINUX
+    if (segment) {
+        ::munmap(segment, sizeof(Segment));
+    }
+    if (descriptor >= 0) {
+        ::close(descriptor);
+    }
+    if (owner) {
+        ::shm_unlink(objectName.toLocal8Bit().constData());
+    }
+#endif
+    segment = nullptr;
+    incoming = nullptr;
+    outgoing = nullptr;
+    descriptor = -1;
+    owner = false;
+}
+
+/**
+ * @brief Checks if the link is mapped.
+ * @return True between a successful create or attach and close, otherwise false.
+ */
+bool SharedMemoryLink::isOpen() const
+{
+    return segment;
+}
+
+/**
+ * @brief Checks if the server removed the segment this side is still attached to, e.g.
+ * because it restarted. A new segment has to be attached to then.
+ * @return True if the segment no longer has a name, otherwise false.
+ */
+bool SharedMemoryLink::isOrphaned() const
+{
+#ifdef Q_OS_LINUX
+    struct stat status;
+    return descriptor >= 0 && ::fstat(descriptor, &status) == 0 && status.st_nlink == 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Gets the reason the last create or attach failed.
+ * @return Error text.
+ */
+QString SharedMemoryLink::errorString() const
+{
+    return error;
+}
+
+/**
+ * @brief Queues a datagram for the other side and wakes it if it sleeps. Never blocks.
+ * @param Datagram payload.
+ * @param Payload size, at most ProtocolConstants::MAX_PACKET_SIZE bytes.
+ * @return True if the datagram was queued, false if the link is closed or the other side
+ * fell SharedMemoryConstants::SLOT_COUNT datagrams behind.
+ */
+bool SharedMemoryLink::send(const char *data, int size)
+{
+    if (!outgoing || size < 0 || size > ProtocolConstants::MAX_PACKET_SIZE) {
+        return false;
+    }
+    quint32 head = outgoing->head.load(std::memory_order_relaxed);
+    if (head - outgoing->tail.load(std::memory_order_acquire)
+        >= quint32(SharedMemoryConstants::SLOT_COUNT)) {
+        return false;
+    }
+    Ring::Packet &packet = outgoing->packets[head & (SharedMemoryConstants::SLOT_COUNT - 1)];
+    packet.size = quint32(size);
+    std::memcpy(packet.data, data, size);
+
+    // Sequentially consistent against the reader's sleeping flag, so either the reader sees
+    // the new head before it sleeps or this side sees it sleeping and wakes it
+    outgoing->head.store(head + 1, std::memory_order_seq_cst);
+#ifdef Q_OS_LINUX
+    if (outgoing->sleeping.load(std::memory_order_seq_cst)) {
+        futex(&outgoing->head, FUTEX_WAKE, 1, nullptr);
+    }
+#endif
+    return true;
+}
+
+/**
+ * @brief Gets the oldest received datagram in place, it stays in the ring until release.
+ * @param Set to the payload.
+ * @param Set to the payload size.
+ * @return True if there is a datagram, otherwise false.
+ */
+bool SharedMemoryLink::receive(const char *&data, qint64 &size)
+{
+    if (!incoming) {
+        return false;
+    }
+    quint32 tail = incoming->tail.load(std::memory_order_relaxed);
+    if (incoming->head.load(std::memory_order_acquire) == tail) {
+        return false;
+    }
+    const Ring::Packet &packet = incoming->packets[tail & (SharedMemoryConstants::SLOT_COUNT - 1)];
+    data = packet.data;
+    // The size comes from another process, never trust it past the slot
+    size = std::min(qint64(packet.size), qint64(ProtocolConstants::MAX_PACKET_SIZE));
+    return true;
+}
+
+/**
+ * @brief Hands the datagram returned by receive back to the other side.
+ */
+void SharedMemoryLink::release()
+{
+    if (incoming) {
+        incoming->tail.fetch_add(1, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief Sleeps until a datagram arrives.
+ * @param Longest time to sleep in milliseconds.
+ * @return True if a datagram is waiting, false after the timeout or when woken to quit.
+ */
+bool SharedMemoryLink::wait(int timeout)
+{
+    if (!incoming) {
+        return false;
+    }
+    quint32 tail = incoming->tail.load(std::memory_order_relaxed);
+    if (!(incoming->head.load(std::memory_order_acquire) == tail)) {
+        return true;
+    }
+#ifdef Q_OS_LINUX
+    incoming->sleeping.store(1, std::memory_order_seq_cst);
+    quint32 head = incoming->head.load(std::memory_order_seq_cst);
+    if (head == tail) {
+        timespec interval;
+        interval.tv_sec = timeout / 1000;
+        interval.tv_nsec = long(timeout % 1000) * 1000000;
+        // Returns right away if the head moved since it was read
+        futex(&incoming->head, FUTEX_WAIT, head, &interval);
+    }
+    incoming->sleeping.store(0, std::memory_order_relaxed);
+#else
+    Q_UNUSED(timeout)
+#endif
+    return !(incoming->head.load(std::memory_order_acquire) == tail);
+}
+
+/**
+ * @brief Starts a thread that sleeps until datagrams arrive and then calls ready. Ready is
+ * called on that thread and once per batch: it is not called again until the owner read
+ * everything and called receiveFinished, so it can simply queue a read to its own thread.
+ * @param Called from the waiter thread when datagrams are waiting.
+ */
+void SharedMemoryLink::startWaiting(const std::function<void()> &ready)
+{
+    stopWaiting();
+    if (!isOpen()) {
+        return;
+    }
+    readyCallback = ready;
+    notified = false;
+    quit = false;
+    waiter = std::thread(&SharedMemoryLink::run, this);
+}
+
+/**
+ * @brief Tells the waiter thread that every datagram it announced was read.
+ */
+void SharedMemoryLink::receiveFinished()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        notified = false;
+    }
+    wake.notify_one();
+}
+
+/**
+ * @brief Stops the waiter thread, waking it if it sleeps.
+ */
+void SharedMemoryLink::stopWaiting()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_one();
+#ifdef Q_OS_LINUX
+    if (incoming) {
+        futex(&incoming->head, FUTEX_WAKE, INT_MAX, nullptr);
+    }
+#endif
+    if (waiter.joinable()) {
+        waiter.join();
+    }
+}
+
+void SharedMemoryLink::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!quit) {
+        if (notified) {
+            wake.wait(lock);
+            continue;
+        }
+        lock.unlock();
+        bool ready = wait(SharedMemoryConstants::WAIT_TIMEOUT);
+        lock.lock();
+        if (ready && !quit) {
+            notified = true;
+            lock.unlock();
+            readyCallback();
+            lock.lock();
+        }
+    }
+}
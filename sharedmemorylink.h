@@ -0,0 +1,82 @@
+#ifndef SHAREDMEMORYLINK_H
+#define SHAREDMEMORYLINK_H
+
+#include "constants.h"
+
+#include <QString>
+#include <QtGlobal>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * Datagram transport between the server and a robot simulator on the same machine, through a
+ * POSIX shared memory segment instead of the kernel's UDP stack. The segment holds one single
+ * producer, single consumer ring of datagrams per direction, carrying the same wire format as
+ * UDP. A reader sleeps on a futex in the shared ring head and is only woken when it actually
+ * sleeps, so a datagram costs a copy and at most one system call.
+ *
+ * The server creates the segment, the simulator attaches to it. Received datagrams are read in
+ * place:
+ *
+ *     const char *data;
+ *     qint64 size;
+ *     while (link.receive(data, size)) {
+ *         ... decode data ...
+ *         link.release();
+ *     }
+ *
+ * Only available on Linux, isSupported() is false everywhere else.
+ */
+class SharedMemoryLink
+{
+public:
+    SharedMemoryLink();
+    ~SharedMemoryLink();
+
+    static bool isSupported();
+    static bool isSharedMemoryAddress(const QString &address);
+    static QString nameFromAddress(const QString &address);
+    bool create(const QString &name);
+    bool attach(const QString &name);
+    void close();
+    bool isOpen() const;
+    bool isOrphaned() const;
+    QString errorString() const;
+
+    bool send(const char *data, int size);
+    bool receive(const char *&data, qint64 &size);
+    void release();
+    bool wait(int timeout);
+
+    void startWaiting(const std::function<void()> &ready);
+    void receiveFinished();
+    void stopWaiting();
+
+private:
+    struct Ring;
+    struct Segment;
+
+    Segment *segment;
+    Ring *incoming;
+    Ring *outgoing;
+    int descriptor;
+    bool owner; // Created the segment, unlinks it on close
+    QString objectName;
+    QString error;
+
+    // Waiter thread, guarded by mutex
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread waiter;
+    std::function<void()> readyCallback;
+    bool notified; // Ready was called and the owner did not finish receiving yet
+    bool quit;
+
+    bool map(bool create);
+    void run();
+};
+
+#endif // SHAREDMEMORYLINK_H
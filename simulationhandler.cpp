@@ -1,5 +1,8 @@
 #include "simulationhandler.h"
 
+#include <algorithm>
+#include <cmath>
+
 // Coordinate system
 //           | y+
 //           |
@@ -11,10 +14,18 @@
 //
 
 // Constructor
-SimulationHandler::SimulationHandler(LoggerHandler *loggerRef, QSettings *settingsRef)
+SimulationHandler::SimulationHandler(LoggerHandler *loggerRef,
+                                     QSettings *settingsRef,
+                                     TelemetryRing *telemetryRef)
 {
     logger = loggerRef;
     settings = settingsRef;
+    telemetry = telemetryRef;
+    lastEncoderIndex = 0;
+    measuredWheels = false;
+    for (int i = 0; i < 4; i++) {
+        commandedSpeeds[i] = 0.0;
+    }
     loadedMeshesCount = 0;
     expectedLoadedMeshes = 0;
     simulationWidget = NULL; // Start as Null (Error checking this way could be entirely wrong?)
@@ -69,6 +80,10 @@ SimulationHandler::SimulationHandler(LoggerHandler *loggerRef, QSettings *settin
                 });
 
         view->setRootEntity(root);
+
+        telemetryTimer = new QTimer(this);
+        connect(telemetryTimer, &QTimer::timeout, this, &SimulationHandler::updateTelemetry);
+        telemetryTimer->start(50);
     }
 }
 
@@ -277,6 +292,10 @@ void SimulationHandler::setupConnections()
             &Custom3DWindow::passKeyboard_EChanged,
             this,
             &SimulationHandler::passKeyboard_EChanged);
+    connect(view,
+            &Custom3DWindow::passKeyboard_SpacePressed,
+            this,
+            &SimulationHandler::passKeyboard_SpacePressed);
 }
 
 /**
@@ -372,6 +391,41 @@ void SimulationHandler::alignMeshes()
     arrowL->addComponent(arrowLTransform);
 }
 
+/**
+ * @brief Places the wheels of a drive model where its layout puts them and hides the wheels
+ * of unused speed slots. Wheels turned along the robot sit past its ends instead of its sides.
+ * @param Model as a constant from DriveConstants.
+ */
+void SimulationHandler::arrangeWheels(int model)
+{
+    Qt3DCore::QEntity *wheels[] = {FRWheel, BLWheel, FLWheel, BRWheel};
+    Qt3DCore::QTransform *transforms[] = {FRWheelTransform,
+                                          BLWheelTransform,
+                                          FLWheelTransform,
+                                          BRWheelTransform};
+    int count = DriveModel::wheelCount(model);
+    for (int slot = 0; slot < DriveConstants::MAX_WHEELS; slot++) {
+        wheels[slot]->setEnabled(slot < count);
+        if (!(slot < count)) {
+            continue;
+        }
+        const double *layout = DriveModel::layoutRow(model, slot);
+        float yaw = float(layout[2]);
+        float across = std::abs(std::cos(yaw * float(MathConstants::PI) / 180.0f));
+        float along = std::abs(std::sin(yaw * float(MathConstants::PI) / 180.0f));
+        transforms[slot]->setTranslation(QVector3D(
+            float(-layout[0])
+                * (SimulationConstants::INBASE_WIDTH / 2
+                   + across * SimulationConstants::WHEEL_WIDTH / 2),
+            SimulationConstants::WHEEL_DIAMETER / 2 + SimulationConstants::FRAME_THICKNESS,
+            float(layout[1])
+                * (SimulationConstants::INBASE_LENGTH / 2
+                   + along * SimulationConstants::WHEEL_WIDTH / 2)));
+        // Applied after the spin the animations set with rotationX
+        transforms[slot]->setRotationY(yaw);
+    }
+}
+
 /**
  * @brief Generate and load mesh files, also applies materials generated earlier.
  * @param Material for grid.
@@ -787,6 +841,13 @@ void SimulationHandler::updateWithSettings()
                 ->value(SettingsConstants::RENDER_VIEW_DEBUG_EN,
                         SettingsConstants::D_RENDER_VIEW_DEBUG_EN)
                 .toBool());
+
+        arrangeWheels(std::clamp(settings
+                                     ->value(SettingsConstants::CONN_COMM_DRIVE,
+                                             SettingsConstants::D_CONN_COMM_DRIVE)
+                                     .toInt(),
+                                 0,
+                                 DriveConstants::MODEL_COUNT - 1));
     }
 }
 
@@ -837,13 +898,72 @@ void SimulationHandler::updateArrow(double dir, double mag, double z)
 }
 
 /**
- * @brief Updates wheel speed to accurately show the speeds at which the numbers determine.
+ * @brief Updates wheel speed to the commanded speeds, unless fresh encoder telemetry is
+ * driving the wheels.
  * @param FR wheel speed.
  * @param BL wheel speed.
  * @param FL wheel speed.
  * @param BR wheel speed.
  */
 void SimulationHandler::updateWheels(double FR, double BL, double FL, double BR)
+{
+    commandedSpeeds[0] = FR;
+    commandedSpeeds[1] = BL;
+    commandedSpeeds[2] = FL;
+    commandedSpeeds[3] = BR;
+    if (!measuredWheels) {
+        animateWheels(FR, BL, FL, BR);
+    }
+}
+
+/**
+ * @brief Shows the wheel speeds the robot measured with its encoders. Reads the newest encoder
+ * sample in place from the telemetry ring and falls back to the commanded speeds once the
+ * telemetry goes stale.
+ */
+void SimulationHandler::updateTelemetry()
+{
+    quint64 index;
+    bool fresh = false;
+    if (telemetry->latest(ProtocolConstants::ENCODER, index)) {
+        quint64 stamp = telemetry->beginRead(index);
+        if (stamp) {
+            const TelemetrySample &sample = telemetry->at(index);
+            // Encoder velocities use the movement packet order, the same as the wheels here
+            double FR = sample.encoder.velocity[0];
+            double BL = sample.encoder.velocity[1];
+            double FL = sample.encoder.velocity[2];
+            double BR = sample.encoder.velocity[3];
+            qint64 age = LatencyTracker::now() - sample.receiveTime;
+            bool robot = sample.robot == 0;
+            if (telemetry->endRead(index, stamp) && robot
+                && age < TelemetryConstants::FRESH_AGE) {
+                fresh = true;
+                if (!(index == lastEncoderIndex)) {
+                    lastEncoderIndex = index;
+                    animateWheels(FR, BL, FL, BR);
+                }
+            }
+        }
+    }
+
+    if (measuredWheels && !fresh) {
+        animateWheels(commandedSpeeds[0],
+                      commandedSpeeds[1],
+                      commandedSpeeds[2],
+                      commandedSpeeds[3]);
+    }
+    measuredWheels = fresh;
+}
+
+/**
+ * @brief Sets the wheel animations to the given speeds.
+ * @param FR wheel speed.
+ * @param BL wheel speed.
+ * @param FL wheel speed.
+ * @param BR wheel speed.
+ */
+void SimulationHandler::animateWheels(double FR, double BL, double FL, double BR)
 {
     //100000 for slow, 1000 for fast
     updateFRAnimation(FR,
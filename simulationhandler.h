@@ -3,8 +3,11 @@
 
 #include "constants.h"
 #include "custom3dwindow.h"
+#include "drivemodel.h"
 #include "helper.h"
+#include "latencyhistogram.h"
 #include "loggerhandler.h"
+#include "telemetryring.h"
 
 #include <math.h>
 #include <QDebug>
@@ -13,6 +16,7 @@
 #include <QObject>
 #include <QQuaternion>
 #include <QSettings>
+#include <QTimer>
 #include <QVariantAnimation>
 #include <QWidget>
 
@@ -37,7 +41,9 @@ class SimulationHandler : public QObject
 {
     Q_OBJECT
 public:
-    SimulationHandler(LoggerHandler *loggerRef, QSettings *settingsRef);
+    SimulationHandler(LoggerHandler *loggerRef,
+                      QSettings *settingsRef,
+                      TelemetryRing *telemetryRef);
     QWidget *getWidget();
 
 public slots:
@@ -53,12 +59,14 @@ signals:
     void passKeyboard_DChanged(bool);
     void passKeyboard_QChanged(bool);
     void passKeyboard_EChanged(bool);
+    void passKeyboard_SpacePressed();
 
     void meshesLoaded();
 
 private:
     LoggerHandler *logger;
     QSettings *settings;
+    TelemetryRing *telemetry;
 
     Qt3DCore::QEntity *root;
     Qt3DCore::QEntity *FRWheel;
@@ -95,6 +103,11 @@ private:
     float FRcurrentRotation;
     float BLcurrentRotation;
 
+    QTimer *telemetryTimer;
+    quint64 lastEncoderIndex;
+    bool measuredWheels;
+    double commandedSpeeds[4];
+
     void setup3DView();
     void setupConnections();
     void setupMeshes();
@@ -104,6 +117,9 @@ private:
     void setupBRAnimation();
 
     void alignMeshes();
+    void arrangeWheels(int model);
+    void updateTelemetry();
+    void animateWheels(double FR, double BL, double FL, double BR);
 
     void generateMeshes(Qt3DExtras::QDiffuseSpecularMaterial *gridMaterial,
                         Qt3DExtras::QDiffuseSpecularMaterial *innerBaseMaterial,
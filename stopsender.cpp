@@ -0,0 +1,168 @@
+#include "stopsender.h"
+
+#include "protocol.h"
+
+#include <cstring>
+
+StopSender::StopSender()
+{
+    socket = -1;
+    count = 0;
+    for (int i = 0; i < ProtocolConstants::MAX_FLEET_SIZE; i++) {
+        ports[i] = 0;
+        formats[i] = ProtocolConstants::BINARY_FORMAT;
+    }
+    nextId = 1;
+    batchCount = 0;
+    pendingCopies = 0;
+    quit = false;
+
+    if (isSupported()) {
+        sender = std::thread(&StopSender::run, this);
+    }
+}
+
+StopSender::~StopSender()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_one();
+    if (sender.joinable()) {
+        sender.join();
+    }
+}
+
+/**
+ * @brief Checks if stops can be sent from any thread on this platform.
+ * @return True where the batch sender is supported, otherwise false.
+ */
+bool StopSender::isSupported()
+{
+    return BatchSender::isSupported();
+}
+
+/**
+ * @brief Sets the socket stops are written to. Has to be set to -1 before the socket is closed
+ * and set again, followed by all destinations, after every bind.
+ * @param Native descriptor of the bound communication socket or -1.
+ */
+void StopSender::setSocket(qintptr socketDescriptor)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    socket = socketDescriptor;
+    pendingCopies = 0;
+    batchCount = 0;
+    if (!(socket == -1)) {
+        batch.setSocket(socket);
+    }
+}
+
+/**
+ * @brief Sets the address of a robot and the packet format it understands.
+ * @param Robot index below ProtocolConstants::MAX_FLEET_SIZE.
+ * @param Robot address.
+ * @param Robot port.
+ * @param Packet format from ProtocolConstants the robot is driven with, text robots get the
+ * legacy stop.
+ */
+void StopSender::setDestination(int index,
+                                const QHostAddress &address,
+                                quint16 port,
+                                int packetFormat)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    addresses[index] = address;
+    ports[index] = port;
+    formats[index] = packetFormat;
+}
+
+/**
+ * @brief Sets how many robots there are.
+ * @param Robot count up to ProtocolConstants::MAX_FLEET_SIZE.
+ */
+void StopSender::setCount(int robotCount)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    count = robotCount;
+}
+
+/**
+ * @brief Sends the first copy of a stop on the calling thread and schedules the rest. A new
+ * stop replaces the copies still pending for the previous one. Robots without an address yet
+ * are skipped. Safe to call from any thread.
+ * @param Bit mask of robot indices to stop.
+ * @param Set to the id of the stop, also when it could not be sent.
+ * @return True if the stop went out, false if the caller has to send it another way.
+ */
+bool StopSender::stop(quint32 robots, quint32 &id)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    id = nextId++;
+    if (socket == -1 || !isSupported()) {
+        return false;
+    }
+
+    batchCount = 0;
+    for (int i = 0; i < count; i++) {
+        if ((robots & (quint32(1) << i)) && !addresses[i].isNull()) {
+            batch.setDestination(batchCount, addresses[i], ports[i]);
+            batch.setSize(batchCount, encode(id, formats[i], batch.buffer(batchCount)));
+            batchCount++;
+        }
+    }
+    if (batchCount == 0) {
+        return true;
+    }
+
+    batch.send(batchCount);
+    pendingCopies = ProtocolConstants::STOP_COPIES - 1;
+    nextCopy = std::chrono::steady_clock::now()
+               + std::chrono::milliseconds(ProtocolConstants::STOP_SPACING);
+    lock.unlock();
+    wake.notify_one();
+    return true;
+}
+
+/**
+ * @brief Serializes a stop for a packet format. The text format has no stop packet, legacy
+ * clients get a zero speed movement datagram instead.
+ * @param Stop id.
+ * @param Packet format from ProtocolConstants.
+ * @param Buffer of ProtocolConstants::MAX_PACKET_SIZE bytes.
+ * @return Number of bytes written.
+ */
+int StopSender::encode(quint32 id, int packetFormat, char *buffer)
+{
+    if (packetFormat == ProtocolConstants::TEXT_FORMAT) {
+        static const char text[] = "m,0,0,0,0";
+        std::memcpy(buffer, text, sizeof(text) - 1);
+        return int(sizeof(text) - 1);
+    }
+    StopPacket packet;
+    packet.id = id;
+    return Protocol::encodeStop(packet, buffer);
+}
+
+/**
+ * @brief Sender thread, sleeps until copies are pending and sends them at the stop spacing.
+ */
+void StopSender::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!quit) {
+        if (pendingCopies == 0) {
+            wake.wait(lock);
+            continue;
+        }
+        if (wake.wait_until(lock, nextCopy) == std::cv_status::no_timeout) {
+            continue; // Woken by a new stop or shutdown, the deadline is read again
+        }
+        if (pendingCopies > 0 && !(socket == -1)) {
+            batch.send(batchCount);
+            pendingCopies--;
+            nextCopy += std::chrono::milliseconds(ProtocolConstants::STOP_SPACING);
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef STOPSENDER_H
+#define STOPSENDER_H
+
+#include "batchsender.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/**
+ * Emergency stop fast path. Stops are written straight to the communication socket from the
+ * thread that asks for them, bypassing the send scheduler and every event loop, and repeated
+ * by a small sender thread. Needs the batch sender, so isSupported() is false where that is
+ * and callers fall back to queuing the stop on the communication thread.
+ */
+class StopSender
+{
+public:
+    StopSender();
+    ~StopSender();
+
+    static bool isSupported();
+    void setSocket(qintptr socketDescriptor);
+    void setDestination(int index, const QHostAddress &address, quint16 port, int packetFormat);
+    void setCount(int robotCount);
+    bool stop(quint32 robots, quint32 &id);
+    static int encode(quint32 id, int packetFormat, char *buffer);
+
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread sender;
+
+    // Guarded by mutex
+    BatchSender batch;
+    qintptr socket;
+    int count;
+    QHostAddress addresses[ProtocolConstants::MAX_FLEET_SIZE];
+    quint16 ports[ProtocolConstants::MAX_FLEET_SIZE];
+    int formats[ProtocolConstants::MAX_FLEET_SIZE];
+    quint32 nextId;
+    int batchCount; // Destinations of the current stop, packed to the front of the batch
+    int pendingCopies;
+    std::chrono::steady_clock::time_point nextCopy;
+    bool quit;
+
+    void run();
+};
+
+#endif // STOPSENDER_H
@@ -0,0 +1,128 @@
+#include "telemetryrecorder.h"
+
+TelemetryRecorder::TelemetryRecorder(LoggerHandler *loggerRef, TelemetryRing *telemetryRef)
+{
+    logger = loggerRef;
+    telemetry = telemetryRef;
+    cursor = 0;
+    recorded = 0;
+    dropped = 0;
+
+    pollTimer = new QTimer(this);
+    connect(pollTimer, &QTimer::timeout, this, &TelemetryRecorder::poll);
+}
+
+/**
+ * @brief Starts recording samples received from now on.
+ * @param Path of the CSV file, overwritten if it exists.
+ * @return True if the file could be opened, otherwise false.
+ */
+bool TelemetryRecorder::start(const QString &path)
+{
+    stop();
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        logger->write(LoggerConstants::ERR, "Could not open telemetry recording " + path);
+        return false;
+    }
+    stream.setDevice(&file);
+    stream << "receive_ns,robot_us,send_ns,robot,type,values\n";
+
+    cursor = telemetry->head();
+    recorded = 0;
+    dropped = 0;
+    pollTimer->start(TelemetryConstants::RECORD_INTERVAL);
+    logger->write(LoggerConstants::INFO, "Recording telemetry to " + path);
+    return true;
+}
+
+/**
+ * @brief Writes out what is left in the ring and closes the file.
+ */
+void TelemetryRecorder::stop()
+{
+    if (!isRecording()) {
+        return;
+    }
+    pollTimer->stop();
+    poll();
+    stream.flush();
+    stream.setDevice(nullptr);
+    file.close();
+
+    QString summary = QString("Telemetry recording stopped, ") + QString::number(recorded)
+                      + " samples written";
+    if (dropped > 0) {
+        // The ring wrapped before the recorder caught up
+        summary += ", " + QString::number(dropped) + " lost";
+    }
+    logger->write(dropped > 0 ? LoggerConstants::WARNING : LoggerConstants::INFO, summary);
+}
+
+/**
+ * @brief Checks if a recording is running.
+ * @return True while recording, otherwise false.
+ */
+bool TelemetryRecorder::isRecording() const
+{
+    return file.isOpen();
+}
+
+/**
+ * @brief Appends every sample written since the last poll. Samples are formatted in place
+ * from the ring and the line is dropped if the writer overwrote the slot meanwhile.
+ */
+void TelemetryRecorder::poll()
+{
+    quint64 head = telemetry->head();
+    quint64 tail = telemetry->tail();
+    if (cursor < tail) {
+        dropped += tail - cursor;
+        cursor = tail;
+    }
+
+    for (; cursor < head; cursor++) {
+        quint64 stamp = telemetry->beginRead(cursor);
+        if (!stamp) {
+            dropped++;
+            continue;
+        }
+
+        const TelemetrySample &sample = telemetry->at(cursor);
+        QString line = QString::number(sample.receiveTime) + ',' + QString::number(sample.robotTime)
+                       + ',' + QString::number(sample.sendTime) + ','
+                       + QString::number(sample.robot) + ',';
+        switch (sample.type) {
+        case ProtocolConstants::IMU:
+            line += "imu";
+            for (int i = 0; i < 3; i++) {
+                line += ',' + QString::number(sample.imu.accel[i]);
+            }
+            for (int i = 0; i < 3; i++) {
+                line += ',' + QString::number(sample.imu.gyro[i]);
+            }
+            break;
+        case ProtocolConstants::ENCODER:
+            line += "encoder";
+            for (int i = 0; i < 4; i++) {
+                line += ',' + QString::number(sample.encoder.ticks[i]);
+            }
+            for (int i = 0; i < 4; i++) {
+                line += ',' + QString::number(sample.encoder.velocity[i]);
+            }
+            break;
+        case ProtocolConstants::BATTERY:
+            line += "battery," + QString::number(sample.battery.voltage) + ','
+                    + QString::number(sample.battery.current) + ','
+                    + QString::number(sample.battery.charge);
+            break;
+        }
+
+        if (telemetry->endRead(cursor, stamp)) {
+            stream << line << '\n';
+            recorded++;
+        } else {
+            dropped++;
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef TELEMETRYRECORDER_H
+#define TELEMETRYRECORDER_H
+
+#include "loggerhandler.h"
+#include "telemetryring.h"
+
+#include <QFile>
+#include <QObject>
+#include <QTextStream>
+#include <QTimer>
+
+/**
+ * Follows the telemetry ring with its own cursor and appends every sample to a CSV file.
+ */
+class TelemetryRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    TelemetryRecorder(LoggerHandler *loggerRef, TelemetryRing *telemetryRef);
+
+    bool start(const QString &path);
+    void stop();
+    bool isRecording() const;
+
+private:
+    LoggerHandler *logger;
+    TelemetryRing *telemetry;
+
+    QTimer *pollTimer;
+    QFile file;
+    QTextStream stream;
+    quint64 cursor;
+    quint64 recorded;
+    quint64 dropped;
+
+    void poll();
+};
+
+#endif // TELEMETRYRECORDER_H
@@ -0,0 +1,144 @@
+#include "telemetryring.h"
+
+TelemetryRing::TelemetryRing()
+{
+    for (int i = 0; i < TelemetryConstants::CAPACITY; i++) {
+        buffer[i].stamp.store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < TelemetryConstants::TYPE_COUNT; i++) {
+        latestIndex[i].store(0, std::memory_order_relaxed);
+    }
+    writeIndex.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Claims the next slot for writing. Only called from the communication thread. If the
+ * sample is not committed the slot is simply claimed again by the next call.
+ * @return Slot to decode the sample into.
+ */
+TelemetrySample &TelemetryRing::beginWrite()
+{
+    quint64 index = writeIndex.load(std::memory_order_relaxed);
+    Slot &slot = buffer[index & (TelemetryConstants::CAPACITY - 1)];
+    slot.stamp.store(2 * index + 1, std::memory_order_relaxed);
+    // Readers that see the old sample change must also see the odd stamp
+    std::atomic_thread_fence(std::memory_order_release);
+    return slot.sample;
+}
+
+/**
+ * @brief Publishes the sample claimed by beginWrite to readers.
+ */
+void TelemetryRing::commitWrite()
+{
+    quint64 index = writeIndex.load(std::memory_order_relaxed);
+    Slot &slot = buffer[index & (TelemetryConstants::CAPACITY - 1)];
+    slot.stamp.store(2 * (index + 1), std::memory_order_release);
+
+    int type = slot.sample.type - ProtocolConstants::IMU;
+    if (type >= 0 && type < TelemetryConstants::TYPE_COUNT) {
+        latestIndex[type].store(index + 1, std::memory_order_release);
+    }
+    writeIndex.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Gets the index the next sample will be written to.
+ * @return One past the newest sample.
+ */
+quint64 TelemetryRing::head() const
+{
+    return writeIndex.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Gets the oldest index that may still be held by the ring.
+ * @return Oldest index, equal to head() if the ring is empty.
+ */
+quint64 TelemetryRing::tail() const
+{
+    quint64 newest = head();
+    return newest > quint64(TelemetryConstants::CAPACITY)
+               ? newest - TelemetryConstants::CAPACITY
+               : 0;
+}
+
+/**
+ * @brief Looks up the newest sample of a type without scanning the ring.
+ * @param Packet type from ProtocolConstants.
+ * @param Set to the index of the newest sample.
+ * @return True if a sample of that type was ever written, otherwise false.
+ */
+bool TelemetryRing::latest(unsigned char type, quint64 &index) const
+{
+    int slot = type - ProtocolConstants::IMU;
+    if (slot < 0 || slot >= TelemetryConstants::TYPE_COUNT) {
+        return false;
+    }
+    quint64 next = latestIndex[slot].load(std::memory_order_acquire);
+    if (next == 0) {
+        return false;
+    }
+    index = next - 1;
+    return true;
+}
+
+/**
+ * @brief Binary searches the ring by receive time. Slots overwritten during the search count
+ * as older than any time, so the result can only move towards newer samples.
+ * @param Time as returned by LatencyTracker::now().
+ * @return First index received at or after the time, head() if there is none.
+ */
+quint64 TelemetryRing::find(qint64 time) const
+{
+    quint64 low = tail();
+    quint64 high = head();
+    while (low < high) {
+        quint64 middle = low + (high - low) / 2;
+        quint64 stamp = beginRead(middle);
+        qint64 received = stamp ? at(middle).receiveTime : 0;
+        if (!stamp || !endRead(middle, stamp) || received < time) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Starts reading a slot in place.
+ * @param Sample index.
+ * @return Stamp to pass to endRead, 0 if the slot does not hold that index.
+ */
+quint64 TelemetryRing::beginRead(quint64 index) const
+{
+    quint64 stamp = buffer[index & (TelemetryConstants::CAPACITY - 1)].stamp.load(
+        std::memory_order_acquire);
+    return stamp == 2 * (index + 1) ? stamp : 0;
+}
+
+/**
+ * @brief Gets a sample in place. Only meaningful between beginRead and a successful endRead.
+ * @param Sample index.
+ * @return Sample stored in the slot.
+ */
+const TelemetrySample &TelemetryRing::at(quint64 index) const
+{
+    return buffer[index & (TelemetryConstants::CAPACITY - 1)].sample;
+}
+
+/**
+ * @brief Finishes reading a slot in place.
+ * @param Sample index.
+ * @param Stamp returned by beginRead.
+ * @return True if the writer did not touch the slot while it was read, otherwise the values
+ * read must be discarded.
+ */
+bool TelemetryRing::endRead(quint64 index, quint64 stamp) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return buffer[index & (TelemetryConstants::CAPACITY - 1)].stamp.load(
+               std::memory_order_relaxed)
+           == stamp;
+}
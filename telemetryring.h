@@ -0,0 +1,57 @@
+#ifndef TELEMETRYRING_H
+#define TELEMETRYRING_H
+
+#include "constants.h"
+#include "protocol.h"
+
+#include <atomic>
+
+/**
+ * Fixed capacity ring of telemetry samples ordered by receive time. The communication thread
+ * is the only writer and decodes packets straight into a slot. Any number of readers on other
+ * threads access slots in place and confirm afterwards that the slot was not overwritten while
+ * they were reading it:
+ *
+ *     quint64 stamp = ring->beginRead(index);
+ *     if (stamp) {
+ *         const TelemetrySample &sample = ring->at(index);
+ *         ... read fields into locals ...
+ *         if (ring->endRead(index, stamp)) { use the locals }
+ *     }
+ *
+ * Indices grow forever, a slot holds index i until index i + CAPACITY is written.
+ */
+class TelemetryRing
+{
+public:
+    TelemetryRing();
+
+    TelemetrySample &beginWrite();
+    void commitWrite();
+
+    quint64 head() const;
+    quint64 tail() const;
+    bool latest(unsigned char type, quint64 &index) const;
+    quint64 find(qint64 time) const;
+
+    quint64 beginRead(quint64 index) const;
+    const TelemetrySample &at(quint64 index) const;
+    bool endRead(quint64 index, quint64 stamp) const;
+
+private:
+    /**
+     * Stamp is 2 * (index + 1) once the sample for index is complete and odd while the writer
+     * is filling the slot.
+     */
+    struct Slot
+    {
+        std::atomic<quint64> stamp;
+        TelemetrySample sample;
+    };
+
+    Slot buffer[TelemetryConstants::CAPACITY]; // Not named slots, that is a Qt keyword
+    std::atomic<quint64> writeIndex;
+    std::atomic<quint64> latestIndex[TelemetryConstants::TYPE_COUNT]; // Index + 1, 0 if none
+};
+
+#endif // TELEMETRYRING_H
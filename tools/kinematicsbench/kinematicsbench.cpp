@@ -0,0 +1,222 @@
+#include "kinematicsbench.h"
+
+#include "kinematics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+KinematicsBench::KinematicsBench(const KinematicsBenchOptions &optionsRef)
+{
+    options = optionsRef;
+    checksum = 0.0;
+}
+
+/**
+ * @brief Runs the equivalence check and, if it passes, the benchmark, printing the results.
+ * @return Process exit code, 1 if the kernels disagree.
+ */
+int KinematicsBench::run()
+{
+    if (!checkEquivalence()) {
+        return 1;
+    }
+
+    // Fixed seed so runs are comparable
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> uniform(-options.range, options.range);
+    xs.resize(options.samples);
+    ys.resize(options.samples);
+    zs.resize(options.samples);
+    for (int i = 0; i < options.samples; i++) {
+        xs[i] = uniform(random);
+        ys[i] = uniform(random);
+        zs[i] = uniform(random);
+    }
+
+    std::printf("\nBenchmark, %d samples x %d passes\n", options.samples, options.repeat);
+    std::printf("%-12s %12s %14s\n", "kernel", "ns/update", "ns/normalized");
+    double trig = 0.0;
+    for (int kernel = 0; kernel < KinematicsConstants::KERNEL_COUNT; kernel++) {
+        double raw = measure(kernel, false);
+        double normalized = measure(kernel, true);
+        if (kernel == KinematicsConstants::TRIG_KERNEL) {
+            trig = raw;
+        }
+        std::printf("%-12s %12.2f %14.2f", KinematicsConstants::KERNEL_NAMES[kernel], raw,
+                    normalized);
+        if (!(kernel == KinematicsConstants::TRIG_KERNEL) && raw > 0.0) {
+            std::printf("   %.1fx faster", trig / raw);
+        }
+        std::printf("\n");
+    }
+    std::printf("(checksum %g)\n", checksum);
+    return benchmarkBatch() ? 0 : 1;
+}
+
+/**
+ * @brief Compares both kernels on every point of the grid.
+ * @return True if every point is within tolerance, otherwise false.
+ */
+bool KinematicsBench::checkEquivalence()
+{
+    int grid = std::max(options.grid, 2);
+    double maxRaw = 0.0;
+    double maxNormalized = 0.0;
+    quint64 truncatedApart = 0;
+    quint64 failures = 0;
+    quint64 points = 0;
+
+    for (int i = 0; i < grid; i++) {
+        double x = -options.range + 2.0 * options.range * i / (grid - 1);
+        for (int j = 0; j < grid; j++) {
+            double y = -options.range + 2.0 * options.range * j / (grid - 1);
+            for (int k = 0; k < grid; k++) {
+                double z = -options.range + 2.0 * options.range * k / (grid - 1);
+                double trig[4];
+                double closed[4];
+                Kinematics::trigSpeeds(x, y, z, trig);
+                Kinematics::closedFormSpeeds(x, y, z, closed);
+                double rawError = 0.0;
+                for (int w = 0; w < 4; w++) {
+                    rawError = std::max(rawError, std::fabs(trig[w] - closed[w]));
+                }
+
+                double scale = Kinematics::normalize(trig);
+                Kinematics::normalize(closed);
+                double normalizedError = 0.0;
+                for (int w = 0; w < 4; w++) {
+                    normalizedError = std::max(normalizedError, std::fabs(trig[w] - closed[w]));
+                }
+                double normalizedTolerance = scale > 0.0 ? 2.0 * TRUNCATION_STEP / scale
+                                                         : TRUNCATION_STEP;
+
+                if (rawError > RAW_TOLERANCE || normalizedError > normalizedTolerance) {
+                    if (failures < 10) {
+                        std::printf("Mismatch at x %.6f y %.6f z %.6f: raw %.3g, normalized "
+                                    "%.3g\n",
+                                    x, y, z, rawError, normalizedError);
+                    }
+                    failures++;
+                }
+                truncatedApart += normalizedError > 0.0 ? 1 : 0;
+                maxRaw = std::max(maxRaw, rawError);
+                maxNormalized = std::max(maxNormalized, normalizedError);
+                points++;
+            }
+        }
+    }
+
+    std::printf("Equivalence, %d^3 points over +-%.2f\n", grid, options.range);
+    std::printf("  raw speeds         max error %.3g (tolerance %.0e)\n", maxRaw, RAW_TOLERANCE);
+    std::printf("  normalized speeds  max error %.3g, %llu points truncated one step apart\n",
+                maxNormalized, (unsigned long long) truncatedApart);
+    std::printf("  %s, %llu of %llu points outside tolerance\n", failures ? "FAILED" : "passed",
+                (unsigned long long) failures, (unsigned long long) points);
+    return failures == 0;
+}
+
+/**
+ * @brief Times one kernel over the benchmark inputs.
+ * @param Kernel as a constant from KinematicsConstants.
+ * @param True to include the truncation and scaling every update goes through.
+ * @return Nanoseconds per update.
+ */
+double KinematicsBench::measure(int kernel, bool normalized)
+{
+    double sum = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < options.repeat; pass++) {
+        for (int i = 0; i < options.samples; i++) {
+            double speeds[4];
+            Kinematics::calculateSpeeds(kernel, xs[i], ys[i], zs[i], speeds);
+            if (normalized) {
+                Kinematics::normalize(speeds);
+            }
+            sum += speeds[0] + speeds[1] + speeds[2] + speeds[3];
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    checksum += sum;
+    double updates = double(options.samples) * std::max(options.repeat, 1);
+    return std::chrono::duration<double, std::nano>(elapsed).count() / updates;
+}
+
+/**
+ * @brief Runs every supported batch path of every drive model over all samples at once, checks
+ * the results against the scalar path and prints the timings.
+ * @return True if every path matched the scalar path, otherwise false.
+ */
+bool KinematicsBench::benchmarkBatch()
+{
+    std::vector<double> expected[DriveConstants::MAX_WHEELS];
+    std::vector<double> speeds[DriveConstants::MAX_WHEELS];
+    KinematicsBatch batch;
+    batch.x = xs.data();
+    batch.y = ys.data();
+    batch.z = zs.data();
+    batch.count = options.samples;
+
+    std::printf("\nBatch, %d samples x %d passes, default path %s\n", options.samples,
+                options.repeat, KinematicsConstants::BATCH_PATH_NAMES[Kinematics::batchPath()]);
+    std::printf("%-14s %-12s %12s %14s\n", "model", "path", "ns/sample", "Msamples/s");
+    bool matched = true;
+    for (int model = 0; model < DriveConstants::MODEL_COUNT; model++) {
+        int wheels = DriveModel::wheelCount(model);
+        double scalar = 0.0;
+        for (int path = 0; path < KinematicsConstants::BATCH_PATH_COUNT; path++) {
+            const char *name = KinematicsConstants::BATCH_PATH_NAMES[path];
+            if (!Kinematics::isBatchPathSupported(path)) {
+                std::printf("%-14s %-12s not supported\n",
+                            DriveConstants::MODEL_NAMES[model],
+                            name);
+                continue;
+            }
+            for (int w = 0; w < DriveConstants::MAX_WHEELS; w++) {
+                speeds[w].assign(w < wheels ? options.samples : 0, 0.0);
+                batch.speeds[w] = w < wheels ? speeds[w].data() : nullptr;
+            }
+            auto start = std::chrono::steady_clock::now();
+            for (int pass = 0; pass < options.repeat; pass++) {
+                Kinematics::calculateBatchWith(model, path, batch);
+            }
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            double perSample = std::chrono::duration<double, std::nano>(elapsed).count()
+                               / (double(options.samples) * options.repeat);
+
+            quint64 mismatches = 0;
+            if (path == KinematicsConstants::SCALAR_BATCH) {
+                scalar = perSample;
+                for (int w = 0; w < wheels; w++) {
+                    expected[w] = speeds[w];
+                }
+            } else {
+                for (int w = 0; w < wheels; w++) {
+                    for (int i = 0; i < options.samples; i++) {
+                        mismatches += speeds[w][i] == expected[w][i] ? 0 : 1;
+                    }
+                }
+            }
+            for (int w = 0; w < wheels; w++) {
+                checksum += speeds[w][options.samples - 1];
+            }
+
+            std::printf("%-14s %-12s %12.2f %14.1f",
+                        DriveConstants::MODEL_NAMES[model],
+                        name,
+                        perSample,
+                        1000.0 / perSample);
+            if (!(path == KinematicsConstants::SCALAR_BATCH)) {
+                std::printf("   %.1fx scalar", scalar / perSample);
+            }
+            if (mismatches > 0) {
+                std::printf("   FAILED, %llu speeds differ", (unsigned long long) mismatches);
+                matched = false;
+            }
+            std::printf("\n");
+        }
+    }
+    return matched;
+}
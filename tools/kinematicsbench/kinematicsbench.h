@@ -0,0 +1,49 @@
+#ifndef KINEMATICSBENCH_H
+#define KINEMATICSBENCH_H
+
+#include <QtGlobal>
+
+#include <vector>
+
+struct KinematicsBenchOptions
+{
+    int grid;     // Points per axis of the equivalence grid
+    double range; // Grid and samples cover -range to range on every axis
+    int samples;  // Benchmark inputs
+    int repeat;   // Passes over the benchmark inputs per kernel
+};
+
+/**
+ * Checks the closed form kinematics kernel against the trig kernel on a dense (x, y, z) grid,
+ * then times both on random inputs. The range reaches past the unit circle so the magnitude
+ * clamp is covered as well.
+ *
+ * Raw speeds have to agree within RAW_TOLERANCE. Normalized speeds go through the 1e-5
+ * truncation, which rounds a raw speed sitting on a step boundary either way, so they have to
+ * agree within two steps divided by the scale factor.
+ *
+ * The batch paths of every drive model are then checked against the scalar batch, which they
+ * have to match exactly, and timed on one batch holding all samples.
+ */
+class KinematicsBench
+{
+public:
+    static constexpr double RAW_TOLERANCE = 1e-8;
+    static constexpr double TRUNCATION_STEP = 1e-5;
+
+    KinematicsBench(const KinematicsBenchOptions &optionsRef);
+    int run();
+
+private:
+    KinematicsBenchOptions options;
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<double> zs;
+    double checksum; // Sum of every speed computed, printed so the work can not be dropped
+
+    bool checkEquivalence();
+    double measure(int kernel, bool normalized);
+    bool benchmarkBatch();
+};
+
+#endif // KINEMATICSBENCH_H
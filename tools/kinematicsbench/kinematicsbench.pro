@@ -0,0 +1,22 @@
+QT += core
+QT -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = kinematicsbench
+
+# Checks and measures the kinematics kernels the server uses
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../kinematics.cpp \
+    ../../kinematicsbatch.cpp \
+    kinematicsbench.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../constants.h \
+    ../../drivemodel.h \
+    ../../kinematics.h \
+    kinematicsbench.h
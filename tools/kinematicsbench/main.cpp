@@ -0,0 +1,31 @@
+#include "kinematicsbench.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("kinematicsbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Checks the closed form kinematics kernel against the trig "
+                                     "kernel and measures both.");
+    parser.addHelpOption();
+
+    QCommandLineOption gridOption("grid", "Equivalence grid points per axis.", "count", "201");
+    QCommandLineOption rangeOption("range", "Input range on every axis.", "value", "1.5");
+    QCommandLineOption samplesOption("samples", "Benchmark inputs.", "count", "1048576");
+    QCommandLineOption repeatOption("repeat", "Benchmark passes per kernel.", "count", "10");
+    parser.addOptions({gridOption, rangeOption, samplesOption, repeatOption});
+    parser.process(app);
+
+    KinematicsBenchOptions options;
+    options.grid = qMax(2, parser.value(gridOption).toInt());
+    options.range = qMax(0.0, parser.value(rangeOption).toDouble());
+    options.samples = qMax(1, parser.value(samplesOption).toInt());
+    options.repeat = qMax(1, parser.value(repeatOption).toInt());
+
+    KinematicsBench bench(options);
+    return bench.run();
+}
@@ -0,0 +1,160 @@
+#include "benchmark.h"
+
+#include "batchreceiver.h"
+#include "protocol.h"
+
+#include <QUdpSocket>
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+Benchmark::Benchmark(const BenchmarkOptions &optionsRef)
+{
+    options = optionsRef;
+    sending.store(false);
+    sent.store(0);
+    sendErrors.store(0);
+    received = 0;
+    reordered = 0;
+    highestSequence = 0;
+}
+
+/**
+ * @brief Runs the benchmark and prints the results.
+ * @return Process exit code.
+ */
+int Benchmark::run()
+{
+    QUdpSocket receiver;
+    if (!receiver.bind(QHostAddress::LocalHost, 0)) {
+        std::fprintf(stderr, "Could not bind receiver: %s\n", qPrintable(receiver.errorString()));
+        return 1;
+    }
+    receiver.setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 4 * 1024 * 1024);
+
+    BatchReceiver batchReceiver;
+    bool batched = options.batch > 0 && BatchReceiver::isSupported();
+    batchReceiver.setBatchSize(options.batch);
+    char buffer[ProtocolConstants::MAX_PACKET_SIZE];
+
+    std::printf("Benchmarking %d s over 127.0.0.1:%u, rate %s, receive path %s\n",
+                options.seconds, receiver.localPort(),
+                options.rate > 0 ? qPrintable(QString::number(options.rate) + " pps")
+                                 : "unlimited",
+                batched ? qPrintable("recvmmsg x" + QString::number(batchReceiver.batchSize()))
+                        : "QUdpSocket");
+    std::fflush(stdout);
+
+    sending.store(true);
+    quint16 port = receiver.localPort();
+    std::thread sender([this, port]() { send(port); });
+    qint64 start = LatencyTracker::now();
+
+    // Keep draining until the sender finished and the socket stayed quiet for a moment
+    int idle = 0;
+    while (sending.load() || idle < 2) {
+        if (!receiver.waitForReadyRead(50)) {
+            idle++;
+            continue;
+        }
+        idle = 0;
+        if (batched) {
+            int count;
+            while ((count = batchReceiver.receive(receiver.socketDescriptor())) > 0) {
+                for (int i = 0; i < count; i++) {
+                    const DatagramView &view = batchReceiver.datagram(i);
+                    receive(view.data, view.size);
+                }
+            }
+        } else {
+            while (receiver.hasPendingDatagrams()) {
+                qint64 size = receiver.readDatagram(buffer, sizeof(buffer));
+                if (size < 0) {
+                    break;
+                }
+                receive(buffer, size);
+            }
+        }
+    }
+    sender.join();
+    double elapsed = (LatencyTracker::now() - start) / 1e9;
+
+    quint64 total = sent.load();
+    quint64 lost = total > received ? total - received : 0;
+    std::printf("Sent        %llu datagrams (%llu send errors)\n",
+                (unsigned long long) total, (unsigned long long) sendErrors.load());
+    std::printf("Received    %llu datagrams (%llu lost, %.3f%%, %llu reordered)\n",
+                (unsigned long long) received, (unsigned long long) lost,
+                total > 0 ? 100.0 * lost / total : 0.0, (unsigned long long) reordered);
+    std::printf("Throughput  %.0f datagrams/s\n", received / elapsed);
+    std::printf("Latency us  p50 %lld  p99 %lld  p99.9 %lld  max %lld\n",
+                (long long) latency.percentile(50.0), (long long) latency.percentile(99.0),
+                (long long) latency.percentile(99.9), (long long) latency.max());
+    return 0;
+}
+
+/**
+ * @brief Sender thread. Streams movement packets stamped with the shared monotonic clock so
+ * the receiver can compute one way latency.
+ * @param Receiver port on 127.0.0.1.
+ */
+void Benchmark::send(quint16 port)
+{
+    QUdpSocket socket;
+    socket.bind(QHostAddress::LocalHost, 0);
+    char buffer[ProtocolConstants::MOVEMENT_SIZE];
+
+    MovementPacket packet;
+    packet.sequence = 0;
+    for (int i = 0; i < 4; i++) {
+        packet.speeds[i] = 0.5f;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point end = Clock::now() + std::chrono::seconds(options.seconds);
+    Clock::time_point next = Clock::now();
+    Clock::duration period = options.rate > 0 ? Clock::duration(std::chrono::nanoseconds(
+                                 1000000000LL / options.rate))
+                                              : Clock::duration::zero();
+
+    while (Clock::now() < end) {
+        if (options.rate > 0) {
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+
+        packet.sequence++;
+        packet.timestamp = quint64(LatencyTracker::now() / 1000);
+        int size = Protocol::encodeMovement(packet, buffer);
+        if (socket.writeDatagram(buffer, size, QHostAddress::LocalHost, port) < 0) {
+            // Socket buffer full, back off briefly and let the receiver catch up
+            sendErrors.fetch_add(1, std::memory_order_relaxed);
+            packet.sequence--;
+            std::this_thread::yield();
+            continue;
+        }
+        sent.fetch_add(1, std::memory_order_relaxed);
+    }
+    sending.store(false);
+}
+
+/**
+ * @brief Accounts one received datagram.
+ * @param Payload.
+ * @param Payload size.
+ */
+void Benchmark::receive(const char *data, qint64 size)
+{
+    MovementPacket packet;
+    if (!Protocol::decodeMovement(data, size, packet)) {
+        return;
+    }
+    latency.record(LatencyTracker::now() - qint64(packet.timestamp) * 1000);
+    received++;
+    if (packet.sequence < highestSequence) {
+        reordered++;
+    } else {
+        highestSequence = packet.sequence;
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "latencyhistogram.h"
+
+#include <atomic>
+#include <QtGlobal>
+
+struct BenchmarkOptions
+{
+    int seconds;
+    int rate;  // Datagrams per second, 0 sends as fast as the socket accepts
+    int batch; // recvmmsg batch size, 0 reads through QUdpSocket
+};
+
+/**
+ * Loopback throughput benchmark. A sender thread streams timestamped movement packets to a
+ * receiver on the calling thread, which reports datagrams per second, loss and one way
+ * latency percentiles.
+ */
+class Benchmark
+{
+public:
+    Benchmark(const BenchmarkOptions &optionsRef);
+    int run();
+
+private:
+    BenchmarkOptions options;
+    LatencyHistogram latency;
+
+    std::atomic<bool> sending;
+    std::atomic<quint64> sent;
+    std::atomic<quint64> sendErrors;
+    quint64 received;
+    quint64 reordered;
+    quint32 highestSequence;
+
+    void send(quint16 port);
+    void receive(const char *data, qint64 size);
+};
+
+#endif // BENCHMARK_H
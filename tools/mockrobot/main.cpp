@@ -0,0 +1,96 @@
+#include "benchmark.h"
+#include "mockrobot.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("mockrobot");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Stand-in robot for testing the remote control server over "
+                                     "loopback, with an optional throughput benchmark.");
+    parser.addHelpOption();
+
+    QCommandLineOption serverOption("server", "Server address.", "address", "127.0.0.1");
+    QCommandLineOption serverPortOption("server-port", "Server port.", "port", "12345");
+    QCommandLineOption localPortOption("port", "Robot port, 0 picks a free one.", "port", "0");
+    QCommandLineOption lossOption("loss", "Datagram loss in each direction.", "percent", "0");
+    QCommandLineOption delayOption("delay", "One way delay.", "ms", "0");
+    QCommandLineOption jitterOption("jitter", "Random deviation from the delay.", "ms", "0");
+    QCommandLineOption heartbeatOption("heartbeat", "Heartbeat rate.", "Hz", "10");
+    QCommandLineOption telemetryOption("telemetry", "Telemetry rate, 0 disables it.", "Hz", "0");
+    QCommandLineOption seedOption("seed", "Seed for the loss and jitter model.", "seed", "1");
+    QCommandLineOption clockOffsetOption("clock-offset", "Robot clock lead.", "ms", "0");
+    QCommandLineOption clockDriftOption("clock-drift", "Robot clock rate error.", "ppm", "0");
+    QCommandLineOption capabilitiesOption("capabilities",
+                                          "Handshake capability bits, 0 ignores the handshake. "
+                                          "Defaults to everything the mock robot supports.",
+                                          "mask");
+    QCommandLineOption discoverOption("discover",
+                                      "Answer discovery announces and follow that server.");
+    QCommandLineOption recordOption("record", "Record received movement to a CSV file.", "file");
+    QCommandLineOption sharedMemoryOption("shm",
+                                          "Talk to a server on this machine through the shared "
+                                          "memory segment it opened for address shm://name.",
+                                          "name");
+    QCommandLineOption benchmarkOption("benchmark",
+                                       "Run the loopback throughput benchmark instead.",
+                                       "seconds");
+    QCommandLineOption rateOption("rate", "Benchmark send rate, 0 is unlimited.", "pps", "0");
+    QCommandLineOption batchOption("batch", "Benchmark recvmmsg batch size, 0 uses QUdpSocket.",
+                                   "count", "32");
+    parser.addOptions({serverOption, serverPortOption, localPortOption, lossOption, delayOption,
+                       jitterOption, heartbeatOption, telemetryOption, seedOption,
+                       clockOffsetOption, clockDriftOption, capabilitiesOption, discoverOption,
+                       recordOption, sharedMemoryOption, benchmarkOption, rateOption,
+                       batchOption});
+    parser.process(app);
+
+    if (parser.isSet(benchmarkOption)) {
+        BenchmarkOptions options;
+        options.seconds = qMax(1, parser.value(benchmarkOption).toInt());
+        options.rate = parser.value(rateOption).toInt();
+        options.batch = parser.value(batchOption).toInt();
+        Benchmark benchmark(options);
+        return benchmark.run();
+    }
+
+    MockRobotOptions options;
+    options.server = QHostAddress(parser.value(serverOption));
+    options.serverPort = quint16(parser.value(serverPortOption).toUInt());
+    options.localPort = quint16(parser.value(localPortOption).toUInt());
+    options.loss = parser.value(lossOption).toDouble();
+    options.delay = parser.value(delayOption).toInt();
+    options.jitter = parser.value(jitterOption).toInt();
+    options.heartbeatRate = parser.value(heartbeatOption).toInt();
+    options.telemetryRate = parser.value(telemetryOption).toInt();
+    options.seed = parser.value(seedOption).toUInt();
+    options.clockOffset = qMax(0, parser.value(clockOffsetOption).toInt());
+    options.clockDrift = parser.value(clockDriftOption).toDouble();
+    options.discover = parser.isSet(discoverOption);
+    options.capabilities = ProtocolConstants::CAP_BINARY | ProtocolConstants::CAP_TRAJECTORY
+                           | ProtocolConstants::CAP_TIME_SYNC | ProtocolConstants::CAP_STOP
+                           | ProtocolConstants::CAP_QUANTIZED | ProtocolConstants::CAP_CONTROL;
+    if (options.telemetryRate > 0) {
+        options.capabilities |= ProtocolConstants::CAP_IMU | ProtocolConstants::CAP_ENCODER
+                                | ProtocolConstants::CAP_BATTERY;
+    }
+    if (parser.isSet(capabilitiesOption)) {
+        options.capabilities = parser.value(capabilitiesOption).toUInt(nullptr, 0);
+    }
+    options.recordPath = parser.value(recordOption);
+    options.sharedMemory = parser.value(sharedMemoryOption);
+    if (options.server.isNull()) {
+        qCritical("Invalid server address %s", qPrintable(parser.value(serverOption)));
+        return 1;
+    }
+
+    MockRobot robot(options);
+    if (!robot.start()) {
+        return 1;
+    }
+    return app.exec();
+}
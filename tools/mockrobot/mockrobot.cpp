@@ -0,0 +1,722 @@
+#include "mockrobot.h"
+
+#include <cmath>
+#include <cstdio>
+
+MockRobot::MockRobot(const MockRobotOptions &optionsRef)
+{
+    options = optionsRef;
+    random.seed(options.seed);
+
+    binaryReceived = false;
+    trajectoryStart = 0;
+    following = false;
+    lastSequence = 0;
+    lastReceiveTime = 0;
+    receivedCount = 0;
+    receivedSinceStatus = 0;
+    gaps = 0;
+    dropped = 0;
+    lastStopId = 0;
+    stopCopies = 0;
+    reversals = 0;
+    for (int i = 0; i < 4; i++) {
+        speeds[i] = 0.0;
+        ticks[i] = 0.0;
+    }
+    charge = 1.0;
+    controlClient = nullptr;
+    parameters.insert("firmware", "mockrobot");
+
+    socket = new QUdpSocket(this);
+    discoverySocket = new QUdpSocket(this);
+    heartbeatTimer = new QTimer(this);
+    telemetryTimer = new QTimer(this);
+    statusTimer = new QTimer(this);
+    attachTimer = new QTimer(this);
+    controlServer = new QTcpServer(this);
+    localControlServer = new QLocalServer(this);
+
+    connect(socket, &QUdpSocket::readyRead, this, &MockRobot::readPendingDatagrams);
+    connect(discoverySocket, &QUdpSocket::readyRead, this, &MockRobot::readAnnounces);
+    connect(heartbeatTimer, &QTimer::timeout, this, &MockRobot::sendHeartbeat);
+    connect(telemetryTimer, &QTimer::timeout, this, &MockRobot::sendTelemetry);
+    connect(statusTimer, &QTimer::timeout, this, &MockRobot::printStatus);
+    connect(attachTimer, &QTimer::timeout, this, &MockRobot::attachSharedMemory);
+    connect(controlServer, &QTcpServer::newConnection, this, [this]() {
+        acceptControl(controlServer->nextPendingConnection());
+    });
+    connect(localControlServer, &QLocalServer::newConnection, this, [this]() {
+        acceptControl(localControlServer->nextPendingConnection());
+    });
+}
+
+/**
+ * @brief Binds the robot socket or attaches to the shared memory segment, opens the recording
+ * and starts the timers.
+ * @return True if the robot is running, otherwise false.
+ */
+bool MockRobot::start()
+{
+    if (!options.sharedMemory.isEmpty()) {
+        if (!SharedMemoryLink::isSupported()) {
+            std::fprintf(stderr, "Shared memory is only supported on Linux\n");
+            return false;
+        }
+        // The server creates the segment, keep trying until it is up
+        attachSharedMemory();
+        if (!sharedLink.isOpen()) {
+            std::printf("Waiting for the server to create shm://%s\n",
+                        qPrintable(options.sharedMemory));
+            attachTimer->start(SharedMemoryConstants::ATTACH_INTERVAL);
+        }
+    } else if (!socket->bind(QHostAddress::LocalHost, options.localPort)) {
+        std::fprintf(stderr, "Could not bind 127.0.0.1:%u: %s\n", options.localPort,
+                     qPrintable(socket->errorString()));
+        return false;
+    }
+    if ((options.capabilities & ProtocolConstants::CAP_CONTROL) && !startControlServer()) {
+        return false;
+    }
+
+    // Shared so several mock robots on one host can all answer
+    if (options.discover
+        && !discoverySocket->bind(QHostAddress::AnyIPv4,
+                                  ProtocolConstants::DISCOVERY_PORT,
+                                  QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+        std::fprintf(stderr, "Could not bind discovery port %u: %s\n",
+                     ProtocolConstants::DISCOVERY_PORT,
+                     qPrintable(discoverySocket->errorString()));
+        return false;
+    }
+
+    if (!options.recordPath.isEmpty()) {
+        recordFile.setFileName(options.recordPath);
+        if (!recordFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            std::fprintf(stderr, "Could not open %s\n", qPrintable(options.recordPath));
+            return false;
+        }
+        record.setDevice(&recordFile);
+        record << "receive_us,sequence,sent_us,speed0,speed1,speed2,speed3\n";
+    }
+
+    clock.start();
+    heartbeatTimer->start(1000 / qMax(1, options.heartbeatRate));
+    if (options.telemetryRate > 0) {
+        telemetryTimer->start(1000 / options.telemetryRate);
+    }
+    statusTimer->start(1000);
+
+    if (options.sharedMemory.isEmpty()) {
+        std::printf("Mock robot on 127.0.0.1:%u, server %s:%u, loss %.1f%%, delay %d+-%d ms\n",
+                    socket->localPort(), qPrintable(options.server.toString()),
+                    options.serverPort, options.loss, options.delay, options.jitter);
+    } else {
+        std::printf("Mock robot on shm://%s, loss %.1f%%, delay %d+-%d ms\n",
+                    qPrintable(options.sharedMemory), options.loss, options.delay,
+                    options.jitter);
+    }
+    std::fflush(stdout);
+    return true;
+}
+
+/**
+ * @brief Reads every queued datagram and hands it to the impaired link.
+ */
+void MockRobot::readPendingDatagrams()
+{
+    while (socket->hasPendingDatagrams()) {
+        qint64 size = socket->readDatagram(buffer, sizeof(buffer));
+        if (size < 0) {
+            break;
+        }
+        receiveDatagram(buffer, size);
+    }
+}
+
+/**
+ * @brief Reads every datagram the server queued in the shared memory segment, in place.
+ */
+void MockRobot::readSharedMemory()
+{
+    const char *data;
+    qint64 size;
+    while (sharedLink.receive(data, size)) {
+        receiveDatagram(data, size);
+        sharedLink.release();
+    }
+    sharedLink.receiveFinished();
+}
+
+/**
+ * @brief Attaches to the server's shared memory segment, retried by the attach timer until
+ * the server created it.
+ */
+void MockRobot::attachSharedMemory()
+{
+    if (!sharedLink.attach(options.sharedMemory)) {
+        return;
+    }
+    attachTimer->stop();
+    // The waiter thread only queues the read, datagrams are handled on the event loop
+    sharedLink.startWaiting([this]() {
+        QMetaObject::invokeMethod(this, [this]() { readSharedMemory(); }, Qt::QueuedConnection);
+    });
+    std::printf("Attached to shm://%s\n", qPrintable(options.sharedMemory));
+    std::fflush(stdout);
+}
+
+/**
+ * @brief Listens for the server's control channel, on TCP at the robot's own port number or on
+ * the local socket named after the shared memory segment.
+ * @return True if listening, otherwise false.
+ */
+bool MockRobot::startControlServer()
+{
+    if (!options.sharedMemory.isEmpty()) {
+        QString name = ControlConstants::LOCAL_PREFIX + options.sharedMemory;
+        QLocalServer::removeServer(name); // Left behind by a crashed mock robot
+        if (!localControlServer->listen(name)) {
+            std::fprintf(stderr, "Could not serve control channel %s: %s\n", qPrintable(name),
+                         qPrintable(localControlServer->errorString()));
+            return false;
+        }
+        return true;
+    }
+    if (!controlServer->listen(QHostAddress::LocalHost, socket->localPort())) {
+        std::fprintf(stderr, "Could not serve control channel on TCP port %u: %s\n",
+                     socket->localPort(), qPrintable(controlServer->errorString()));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Takes a control connection from the server, replacing the previous one.
+ * @param Connected socket.
+ */
+void MockRobot::acceptControl(QIODevice *client)
+{
+    if (!client) {
+        return;
+    }
+    if (controlClient) {
+        controlClient->close();
+    }
+    controlClient = client;
+    controlBuffer.clear();
+    connect(client, &QIODevice::readyRead, this, &MockRobot::readControl);
+    // QIODevice has no disconnected signal, closing the device is the common ground
+    connect(client, &QIODevice::aboutToClose, this, [this, client]() {
+        if (controlClient == client) {
+            controlClient = nullptr;
+        }
+        client->deleteLater();
+    });
+    if (QTcpSocket *tcp = qobject_cast<QTcpSocket *>(client)) {
+        connect(tcp, &QTcpSocket::disconnected, tcp, &QTcpSocket::close);
+    } else if (QLocalSocket *local = qobject_cast<QLocalSocket *>(client)) {
+        connect(local, &QLocalSocket::disconnected, local, &QLocalSocket::close);
+    }
+    std::printf("Control channel connected\n");
+    std::fflush(stdout);
+}
+
+/**
+ * @brief Reads control frames from the server. The channel is not impaired, it stands for a
+ * reliable stream.
+ */
+void MockRobot::readControl()
+{
+    if (!controlClient) {
+        return;
+    }
+    controlBuffer += controlClient->readAll();
+    int offset = 0;
+    ControlHeader header;
+    while (controlBuffer.size() - offset >= ProtocolConstants::CONTROL_HEADER_SIZE) {
+        if (!Protocol::decodeControlHeader(controlBuffer.constData() + offset,
+                                           controlBuffer.size() - offset,
+                                           header)
+            || header.length > quint32(ControlConstants::MAX_PAYLOAD)) {
+            std::fprintf(stderr, "Invalid control frame, dropping the connection\n");
+            controlClient->close();
+            return;
+        }
+        int frameSize = ProtocolConstants::CONTROL_HEADER_SIZE + int(header.length);
+        if (controlBuffer.size() - offset < frameSize) {
+            break;
+        }
+        receiveControl(header.type,
+                       controlBuffer.mid(offset + ProtocolConstants::CONTROL_HEADER_SIZE,
+                                         int(header.length)));
+        offset += frameSize;
+    }
+    controlBuffer.remove(0, offset);
+}
+
+/**
+ * @brief Acts on a control message. Configuration is stored with the parameters, so it can be
+ * read back.
+ * @param Message type.
+ * @param Payload.
+ */
+void MockRobot::receiveControl(int type, const QByteArray &payload)
+{
+    const QStringList lines = QString::fromUtf8(payload).split('\n', Qt::SkipEmptyParts);
+    QStringList answer;
+    switch (type) {
+    case ProtocolConstants::CONTROL_CONFIG:
+    case ProtocolConstants::CONTROL_PARAM_SET:
+        for (const QString &line : lines) {
+            int separator = line.indexOf('=');
+            if (separator > 0) {
+                parameters.insert(line.left(separator), line.mid(separator + 1));
+                answer.append(line);
+            }
+        }
+        std::printf("%s %s\n",
+                    type == ProtocolConstants::CONTROL_CONFIG ? "Config" : "Set",
+                    qPrintable(answer.join(' ')));
+        std::fflush(stdout);
+        if (type == ProtocolConstants::CONTROL_PARAM_SET) {
+            writeControl(ProtocolConstants::CONTROL_PARAM_VALUE, answer.join('\n').toUtf8());
+        }
+        break;
+    case ProtocolConstants::CONTROL_PARAM_GET:
+        // No names asks for every parameter
+        for (auto it = parameters.cbegin(); it != parameters.cend(); ++it) {
+            if (lines.isEmpty() || lines.contains(it.key())) {
+                answer.append(it.key() + "=" + it.value());
+            }
+        }
+        writeControl(ProtocolConstants::CONTROL_PARAM_VALUE, answer.join('\n').toUtf8());
+        break;
+    case ProtocolConstants::CONTROL_LOG_REQUEST: {
+        QByteArray log = statusLog.join('\n').toUtf8() + '\n';
+        for (int offset = 0; offset < log.size(); offset += 4096) {
+            writeControl(ProtocolConstants::CONTROL_LOG_DATA, log.mid(offset, 4096));
+        }
+        writeControl(ProtocolConstants::CONTROL_LOG_DATA, QByteArray());
+        break;
+    }
+    }
+}
+
+/**
+ * @brief Sends one control frame to the server.
+ * @param Message type.
+ * @param Payload.
+ */
+void MockRobot::writeControl(int type, const QByteArray &payload)
+{
+    if (!controlClient) {
+        return;
+    }
+    ControlHeader header;
+    header.type = (unsigned char) type;
+    header.length = quint32(payload.size());
+    char data[ProtocolConstants::CONTROL_HEADER_SIZE];
+    Protocol::encodeControlHeader(header, data);
+    controlClient->write(data, ProtocolConstants::CONTROL_HEADER_SIZE);
+    controlClient->write(payload);
+}
+
+/**
+ * @brief Decodes a datagram from the server and hands it to the impaired link.
+ * @param Payload, only valid for the duration of this call.
+ * @param Payload size.
+ */
+void MockRobot::receiveDatagram(const char *data, qint64 size)
+{
+    MovementPacket packet;
+    StopPacket stop;
+    TrajectoryPacket chunk;
+    TimeSyncPacket sync;
+    QuantizedPacket quantized;
+    unsigned char type = Protocol::isBinary(data, size) ? Protocol::packetType(data) : 0;
+    if (type == ProtocolConstants::STOP) {
+        if (Protocol::decodeStop(data, size, stop)) {
+            impair([this, stop]() { receiveStop(stop); });
+        }
+    } else if (type == ProtocolConstants::HELLO) {
+        if (!(options.capabilities == 0)) {
+            impair([this]() { answerHello(); });
+        }
+    } else if (type == ProtocolConstants::TIME_REQUEST) {
+        if (Protocol::decodeTimeSync(data, size, sync)) {
+            impair([this, sync]() { answerTimeSync(sync); });
+        }
+    } else if (type == ProtocolConstants::QUANTIZED16 || type == ProtocolConstants::QUANTIZED8) {
+        if (Protocol::decodeQuantized(data, size, quantized)) {
+            impair([this, quantized]() { receiveQuantized(quantized); });
+        }
+    } else if (type == ProtocolConstants::TRAJECTORY) {
+        if (Protocol::decodeTrajectory(data, size, chunk)) {
+            impair([this, chunk]() { receiveTrajectory(chunk); });
+        }
+    } else if (Protocol::decodeMovement(data, size, packet)) {
+        impair([this, packet]() { receiveMovement(packet); });
+    } else if (!Protocol::isBinary(data, size)) {
+        QByteArray text(data, int(size));
+        impair([this, text]() { receiveText(text); });
+    }
+}
+
+/**
+ * @brief Answers server announces from the movement socket, so the server learns which port
+ * to drive, and switches heartbeats and telemetry over to the announcing server.
+ */
+void MockRobot::readAnnounces()
+{
+    while (discoverySocket->hasPendingDatagrams()) {
+        QHostAddress sender;
+        quint16 senderPort;
+        qint64 size = discoverySocket->readDatagram(buffer, sizeof(buffer), &sender, &senderPort);
+        AnnouncePacket announce;
+        if (size < 0 || !Protocol::isBinary(buffer, size)
+            || !(Protocol::packetType(buffer) == ProtocolConstants::ANNOUNCE)
+            || !Protocol::decodeAnnounce(buffer, size, announce)) {
+            continue;
+        }
+
+        if (!(options.server == sender) || !(options.serverPort == senderPort)) {
+            std::printf("Announce from %s:%u, following it\n", qPrintable(sender.toString()),
+                        senderPort);
+            std::fflush(stdout);
+        }
+        options.server = sender;
+        options.serverPort = senderPort;
+        char data[ProtocolConstants::ANNOUNCE_SIZE];
+        int replySize = Protocol::encodeAnnounce(ProtocolConstants::ANNOUNCE_REPLY, announce, data);
+        writeImpaired(QByteArray(data, replySize));
+    }
+}
+
+/**
+ * @brief Takes a binary movement packet that made it through the link.
+ * @param Decoded packet.
+ */
+void MockRobot::receiveMovement(const MovementPacket &packet)
+{
+    if (binaryReceived && packet.sequence != lastSequence + 1) {
+        gaps++;
+    }
+    binaryReceived = true;
+    following = false;
+    lastSequence = packet.sequence;
+    lastReceiveTime = timestamp();
+    receivedCount++;
+    receivedSinceStatus++;
+    for (int i = 0; i < 4; i++) {
+        speeds[i] = packet.speeds[i];
+    }
+
+    if (record.device()) {
+        record << timestamp() << ',' << packet.sequence << ',' << packet.timestamp;
+        for (int i = 0; i < 4; i++) {
+            record << ',' << packet.speeds[i];
+        }
+        record << '\n';
+    }
+}
+
+/**
+ * @brief Takes a quantized movement packet, handled like a movement packet. The full sequence
+ * is restored from its low 8 bits, heartbeats then echo it and the server keeps the low bits.
+ * @param Decoded packet.
+ */
+void MockRobot::receiveQuantized(const QuantizedPacket &packet)
+{
+    MovementPacket movement;
+    movement.sequence = Protocol::expandSequence(packet.sequence, lastSequence + 1);
+    movement.timestamp = 0;
+    for (int i = 0; i < 4; i++) {
+        movement.speeds[i] = float(Protocol::dequantize(packet.speeds[i], packet.bits));
+    }
+    receiveMovement(movement);
+}
+
+/**
+ * @brief Takes an emergency stop. Only the first copy of each stop acts, the rest are counted.
+ * @param Decoded packet.
+ */
+void MockRobot::receiveStop(const StopPacket &packet)
+{
+    stopCopies++;
+    if (packet.id == lastStopId) {
+        return;
+    }
+    lastStopId = packet.id;
+    following = false;
+    for (int i = 0; i < 4; i++) {
+        speeds[i] = 0.0;
+    }
+    std::printf("Emergency stop %u\n", packet.id);
+    std::fflush(stdout);
+    if (record.device()) {
+        record << timestamp() << ",,,0,0,0,0\n";
+    }
+}
+
+/**
+ * @brief Takes a trajectory chunk. Its first point is handled like a movement packet, the
+ * rest are followed until the next packet arrives.
+ * @param Decoded packet.
+ */
+void MockRobot::receiveTrajectory(const TrajectoryPacket &packet)
+{
+    MovementPacket first;
+    first.sequence = packet.sequence;
+    first.timestamp = packet.timestamp;
+    for (int i = 0; i < 4; i++) {
+        first.speeds[i] = packet.points[0].speeds[i];
+    }
+    receiveMovement(first);
+
+    // A wheel may slow down to zero within a chunk, but running it the other way or starting a
+    // stopped one means a prediction carried on after the input was let go
+    bool reversed = false;
+    for (int n = 1; n < packet.count; n++) {
+        for (int i = 0; i < 4; i++) {
+            double from = packet.points[0].speeds[i];
+            double to = packet.points[n].speeds[i];
+            reversed = reversed || (from >= 0.0 && to < 0.0) || (from <= 0.0 && to > 0.0);
+        }
+    }
+    if (reversed) {
+        reversals++;
+        std::printf("Trajectory %u crosses zero\n", packet.sequence);
+    }
+
+    // Clocks are not synchronized, the chunk starts when it arrives
+    trajectory = packet;
+    trajectoryStart = timestamp();
+    following = true;
+}
+
+/**
+ * @brief Sets the speeds to the current point of the trajectory, interpolating linearly
+ * between points and holding the last one once the trajectory ran out.
+ */
+void MockRobot::followTrajectory()
+{
+    if (!following) {
+        return;
+    }
+    quint64 elapsed = timestamp() - trajectoryStart;
+    const TrajectoryPoint *points = trajectory.points;
+    int n = 0;
+    while (n + 1 < trajectory.count && points[n + 1].offset <= elapsed) {
+        n++;
+    }
+    if (n + 1 == trajectory.count) {
+        for (int i = 0; i < 4; i++) {
+            speeds[i] = points[n].speeds[i];
+        }
+        return;
+    }
+    double fraction = double(elapsed - points[n].offset)
+                      / double(points[n + 1].offset - points[n].offset);
+    for (int i = 0; i < 4; i++) {
+        speeds[i] = points[n].speeds[i]
+                    + fraction * (points[n + 1].speeds[i] - points[n].speeds[i]);
+    }
+}
+
+/**
+ * @brief Answers a time sync request that made it through the link. Both robot times are
+ * taken here, the reply then goes through the impaired link like every other datagram.
+ * @param Decoded request.
+ */
+void MockRobot::answerTimeSync(TimeSyncPacket packet)
+{
+    packet.receive = timestamp();
+    char data[ProtocolConstants::TIME_REPLY_SIZE];
+    packet.transmit = timestamp();
+    int size = Protocol::encodeTimeSync(ProtocolConstants::TIME_REPLY, packet, data);
+    writeImpaired(QByteArray(data, size));
+}
+
+/**
+ * @brief Answers a handshake hello with the configured capabilities.
+ */
+void MockRobot::answerHello()
+{
+    HelloPacket packet;
+    packet.version = ProtocolConstants::VERSION;
+    packet.capabilities = options.capabilities;
+    char data[ProtocolConstants::HELLO_SIZE];
+    int size = Protocol::encodeHello(ProtocolConstants::HELLO_ACK, packet, data);
+    writeImpaired(QByteArray(data, size));
+}
+
+/**
+ * @brief Takes a legacy text movement datagram ("m,a,b,c,d") that made it through the link.
+ * @param Datagram payload.
+ */
+void MockRobot::receiveText(const QByteArray &data)
+{
+    QList<QByteArray> fields = data.trimmed().split(',');
+    if (fields.size() != 5 || !(fields[0] == "m")) {
+        return;
+    }
+    receivedCount++;
+    receivedSinceStatus++;
+    following = false;
+    for (int i = 0; i < 4; i++) {
+        speeds[i] = fields[i + 1].toDouble();
+    }
+
+    if (record.device()) {
+        record << timestamp() << ",,," << fields[1] << ',' << fields[2] << ',' << fields[3]
+               << ',' << fields[4] << '\n';
+    }
+}
+
+/**
+ * @brief Sends a heartbeat. Binary once the server spoke binary, otherwise the legacy empty
+ * datagram.
+ */
+void MockRobot::sendHeartbeat()
+{
+    if (!binaryReceived) {
+        writeImpaired(QByteArray());
+        return;
+    }
+
+    HeartbeatPacket packet;
+    packet.echoSequence = lastSequence;
+    packet.echoReceiveTime = lastReceiveTime;
+    packet.receivedCount = receivedCount;
+    packet.transmitTime = timestamp();
+    char data[ProtocolConstants::HEARTBEAT_SIZE];
+    int size = Protocol::encodeHeartbeat(packet, data);
+    writeImpaired(QByteArray(data, size));
+}
+
+/**
+ * @brief Sends one IMU, encoder and battery packet synthesized from the commanded speeds, as
+ * if the wheels tracked the command perfectly.
+ */
+void MockRobot::sendTelemetry()
+{
+    const double interval = 1.0 / options.telemetryRate;
+    TelemetrySample sample;
+    sample.robot = 0;
+    sample.receiveTime = 0;
+    sample.robotTime = timestamp();
+    char data[ProtocolConstants::MAX_PACKET_SIZE];
+    followTrajectory();
+
+    // Wheels in movement order FR, BL, FL, BR, robot forward is +x and left is +y
+    double forward = (speeds[0] + speeds[1] + speeds[2] + speeds[3]) / 4.0;
+    double left = (speeds[0] + speeds[1] - speeds[2] - speeds[3]) / 4.0;
+    double turn = (speeds[0] - speeds[1] - speeds[2] + speeds[3]) / 4.0;
+    sample.type = ProtocolConstants::IMU;
+    sample.imu.accel[0] = float(forward * 0.5);
+    sample.imu.accel[1] = float(left * 0.5);
+    sample.imu.accel[2] = 9.81f;
+    sample.imu.gyro[0] = 0.0f;
+    sample.imu.gyro[1] = 0.0f;
+    sample.imu.gyro[2] = float(turn * MathConstants::PI);
+    writeImpaired(QByteArray(data, Protocol::encodeTelemetry(sample, data)));
+
+    sample.type = ProtocolConstants::ENCODER;
+    for (int i = 0; i < 4; i++) {
+        ticks[i] += speeds[i] * 2048.0 * interval; // 2048 ticks per second at full speed
+        sample.encoder.ticks[i] = qint32(ticks[i]);
+        sample.encoder.velocity[i] = float(speeds[i]);
+    }
+    writeImpaired(QByteArray(data, Protocol::encodeTelemetry(sample, data)));
+
+    double load = (std::fabs(speeds[0]) + std::fabs(speeds[1]) + std::fabs(speeds[2])
+                   + std::fabs(speeds[3]))
+                  / 4.0;
+    double current = 0.3 + 2.5 * load;
+    charge = qMax(0.0, charge - current * interval / 7200.0); // 2 Ah pack
+    sample.type = ProtocolConstants::BATTERY;
+    sample.battery.voltage = float(6.4 + 2.0 * charge - 0.1 * current);
+    sample.battery.current = float(current);
+    sample.battery.charge = float(charge);
+    writeImpaired(QByteArray(data, Protocol::encodeTelemetry(sample, data)));
+}
+
+/**
+ * @brief Sends a datagram to the server through the impaired link.
+ * @param Payload.
+ */
+void MockRobot::writeImpaired(const QByteArray &data)
+{
+    impair([this, data]() {
+        if (options.sharedMemory.isEmpty()) {
+            socket->writeDatagram(data, options.server, options.serverPort);
+        } else if (!sharedLink.send(data.constData(), data.size())) {
+            dropped++; // Server not attached or a whole ring behind
+        }
+    });
+}
+
+/**
+ * @brief Runs an action after the link drop and delay model. Delays are drawn per datagram,
+ * so jitter larger than the send interval reorders datagrams like a real link would.
+ * @param Action delivering the datagram.
+ */
+void MockRobot::impair(const std::function<void()> &action)
+{
+    if (options.loss > 0.0 && random.bounded(100.0) < options.loss) {
+        dropped++;
+        return;
+    }
+
+    int delay = options.delay;
+    if (options.jitter > 0) {
+        delay += random.bounded(-options.jitter, options.jitter + 1);
+    }
+    if (delay <= 0) {
+        action();
+    } else {
+        QTimer::singleShot(delay, Qt::PreciseTimer, this, action);
+    }
+}
+
+/**
+ * @brief Prints a one line summary of the last second.
+ */
+void MockRobot::printStatus()
+{
+    if (sharedLink.isOpen() && sharedLink.isOrphaned()) {
+        // The server closed or restarted, its next segment is a new one
+        sharedLink.close();
+        std::printf("Server closed shm://%s, waiting for it\n", qPrintable(options.sharedMemory));
+        attachTimer->start(SharedMemoryConstants::ATTACH_INTERVAL);
+    }
+    followTrajectory();
+    QString line = QString::asprintf("rx %u/s  total %u  gaps %u  dropped %u  stop copies %u  "
+                                     "reversals %u  speeds %.3f %.3f %.3f %.3f",
+                                     receivedSinceStatus, receivedCount, gaps, dropped,
+                                     stopCopies, reversals, speeds[0], speeds[1], speeds[2],
+                                     speeds[3]);
+    std::printf("%s\n", qPrintable(line));
+    std::fflush(stdout);
+    // Kept for the control channel's log download, the last ten minutes
+    statusLog.append(line);
+    if (statusLog.size() > 600) {
+        statusLog.removeFirst();
+    }
+    receivedSinceStatus = 0;
+    if (record.device()) {
+        record.flush();
+    }
+}
+
+/**
+ * @brief Gets the robot clock, offset and drifting against the host clock as configured.
+ * @return Microseconds since the robot started plus the clock offset.
+ */
+quint64 MockRobot::timestamp()
+{
+    double elapsed = clock.nsecsElapsed() / 1000.0;
+    return quint64(elapsed * (1.0 + options.clockDrift / 1000000.0))
+           + quint64(options.clockOffset) * 1000;
+}
@@ -0,0 +1,121 @@
+#ifndef MOCKROBOT_H
+#define MOCKROBOT_H
+
+#include "protocol.h"
+#include "sharedmemorylink.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLocalServer>
+#include <QMap>
+#include <QObject>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QTcpServer>
+#include <QTextStream>
+#include <QTimer>
+#include <QUdpSocket>
+
+#include <functional>
+
+struct MockRobotOptions
+{
+    QHostAddress server;
+    quint16 serverPort;
+    quint16 localPort;
+    double loss;   // Percent of datagrams dropped in each direction
+    int delay;     // Added one way delay in milliseconds
+    int jitter;    // Maximum random deviation from the delay in milliseconds
+    int heartbeatRate; // Hz
+    int telemetryRate; // Hz, 0 disables telemetry
+    quint32 seed;
+    int clockOffset;   // Milliseconds the robot clock starts ahead
+    double clockDrift; // ppm the robot clock runs fast
+    bool discover; // Answer server announces and follow the server that sent them
+    quint32 capabilities; // Announced in the handshake, 0 ignores hellos like a legacy robot
+                          // CAP_CONTROL serves a control channel on the robot's port
+    QString recordPath;
+    QString sharedMemory; // Segment name, empty talks UDP
+};
+
+/**
+ * Stand-in robot. Receives movement packets or trajectory chunks, echoes their sequence numbers
+ * in heartbeats and optionally streams telemetry, all through a link with configurable loss,
+ * delay and jitter. Trajectory chunks are followed between packets as a real robot would. The
+ * link is UDP or, for a server on the same machine, a shared memory segment. A control channel
+ * takes configuration, keeps parameters and hands out the status lines printed so far as its
+ * log.
+ */
+class MockRobot : public QObject
+{
+    Q_OBJECT
+public:
+    MockRobot(const MockRobotOptions &optionsRef);
+    bool start();
+
+private:
+    MockRobotOptions options;
+
+    QUdpSocket *socket;
+    QUdpSocket *discoverySocket;
+    SharedMemoryLink sharedLink;
+    QTimer *attachTimer;
+    QTimer *heartbeatTimer;
+    QTimer *telemetryTimer;
+    QTimer *statusTimer;
+    QElapsedTimer clock;
+    QRandomGenerator random;
+    QFile recordFile;
+    QTextStream record;
+    QTcpServer *controlServer;
+    QLocalServer *localControlServer; // Used instead of TCP with shared memory
+    QIODevice *controlClient;         // Connected server, nullptr while none is
+    QByteArray controlBuffer;
+    QMap<QString, QString> parameters;
+    QStringList statusLog; // Recent status lines, sent when the server asks for the log
+
+    bool binaryReceived;
+    quint32 lastSequence;
+    quint64 lastReceiveTime; // Robot clock when lastSequence arrived
+    quint32 receivedCount;
+    quint32 receivedSinceStatus;
+    quint32 gaps;
+    quint32 dropped;
+    quint32 lastStopId;
+    quint32 stopCopies;
+    quint32 reversals; // Trajectory chunks with a point across zero from their first point
+    double speeds[4];
+    TrajectoryPacket trajectory;
+    quint64 trajectoryStart; // Local time the first point of the trajectory applied at
+    bool following;
+    double ticks[4];
+    double charge;
+    char buffer[ProtocolConstants::MAX_PACKET_SIZE];
+
+    void readPendingDatagrams();
+    void readSharedMemory();
+    void attachSharedMemory();
+    void receiveDatagram(const char *data, qint64 size);
+    void readAnnounces();
+    bool startControlServer();
+    void acceptControl(QIODevice *client);
+    void readControl();
+    void receiveControl(int type, const QByteArray &payload);
+    void writeControl(int type, const QByteArray &payload);
+    void receiveMovement(const MovementPacket &packet);
+    void receiveText(const QByteArray &data);
+    void receiveStop(const StopPacket &packet);
+    void receiveTrajectory(const TrajectoryPacket &packet);
+    void receiveQuantized(const QuantizedPacket &packet);
+    void answerTimeSync(TimeSyncPacket packet);
+    void answerHello();
+    void followTrajectory();
+    void sendHeartbeat();
+    void sendTelemetry();
+    void writeImpaired(const QByteArray &data);
+    void impair(const std::function<void()> &action);
+    void printStatus();
+    quint64 timestamp();
+};
+
+#endif // MOCKROBOT_H
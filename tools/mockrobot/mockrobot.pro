@@ -0,0 +1,30 @@
+QT += core gui network
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = mockrobot
+
+# Shares the wire protocol and measurement code with the server
+INCLUDEPATH += ../..
+
+# shm_open lives in librt on glibc before 2.34
+linux: LIBS += -lrt
+
+SOURCES += \
+    ../../batchreceiver.cpp \
+    ../../latencyhistogram.cpp \
+    ../../protocol.cpp \
+    ../../sharedmemorylink.cpp \
+    benchmark.cpp \
+    main.cpp \
+    mockrobot.cpp
+
+HEADERS += \
+    ../../batchreceiver.h \
+    ../../constants.h \
+    ../../latencyhistogram.h \
+    ../../protocol.h \
+    ../../sharedmemorylink.h \
+    benchmark.h \
+    mockrobot.h
@@ -0,0 +1,214 @@
+#include "trace.h"
+#include "latencyhistogram.h"
+
+#include <QFile>
+#include <QHostAddress>
+#include <QStringList>
+#include <QTextStream>
+
+#include <algorithm>
+
+namespace {
+/**
+ * Stamp is 2 * (index + 1) once the record for index is complete and odd while a writer is
+ * filling the slot, the same scheme as TelemetryRing. Unlike the telemetry ring any thread may
+ * write, so writers claim their index with a fetch_add.
+ */
+struct TraceSlot
+{
+    std::atomic<quint64> stamp;
+    TraceRecord record;
+};
+
+TraceSlot buffer[TraceConstants::CAPACITY]; // Zero initialized, so every slot starts out empty
+std::atomic<quint64> writeIndex(0);
+
+const char *const categoryNames[TraceConstants::CATEGORY_COUNT] = {"send",
+                                                                   "receive",
+                                                                   "input",
+                                                                   "camera"};
+
+const char *const eventNames[TraceConstants::EVENT_COUNT] = {"movement_sent",
+                                                             "send_failed",
+                                                             "send_replaced",
+                                                             "datagram",
+                                                             "text_datagram",
+                                                             "key_pressed",
+                                                             "key_released",
+                                                             "camera_connect"};
+
+QString categoryName(quint32 category)
+{
+    for (int i = 0; i < TraceConstants::CATEGORY_COUNT; i++) {
+        if (category == 1u << i) {
+            return categoryNames[i];
+        }
+    }
+    return QString::number(category);
+}
+
+/**
+ * @brief Formats the arguments of a record for the dump. Addresses and text payloads are
+ * stored as integers and only decoded here.
+ * @param Record to format.
+ * @return Arguments separated by spaces.
+ */
+QString formatArguments(const TraceRecord &record)
+{
+    switch (record.event) {
+    case TraceConstants::DATAGRAM:
+    case TraceConstants::CAMERA_CONNECT:
+        return QHostAddress(quint32(record.args[0])).toString() + " "
+               + QString::number(record.args[1]) + " " + QString::number(record.args[2]);
+    case TraceConstants::TEXT_DATAGRAM: {
+        char text[8];
+        int length = int(std::min<quint64>(record.args[1], sizeof(text)));
+        for (int i = 0; i < length; i++) {
+            text[i] = char(record.args[2] >> (8 * i));
+        }
+        return QString::number(record.args[0]) + " " + QString::number(record.args[1]) + " \""
+               + QString::fromLatin1(text, length) + "\"";
+    }
+    case TraceConstants::SEND_FAILED:
+        return QString::number(record.args[0]) + " " + QString::number(record.args[1]) + " "
+               + QString::number(qint64(record.args[2]));
+    }
+    return QString::number(record.args[0]) + " " + QString::number(record.args[1]) + " "
+           + QString::number(record.args[2]);
+}
+} // namespace
+
+std::atomic<quint32> Trace::enabledCategories(0);
+
+/**
+ * @brief Checks if trace points were compiled into this build.
+ * @return True if REMOTECONTROL_TRACE was defined, otherwise false.
+ */
+bool Trace::isCompiledIn()
+{
+#ifdef REMOTECONTROL_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Switches categories on and off. Takes effect for every thread right away.
+ * @param Mask of TraceConstants category bits to record.
+ */
+void Trace::setCategories(quint32 mask)
+{
+    enabledCategories.store(mask, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Turns a category list as stored in the settings into a mask.
+ * @param Comma separated category names such as "send,receive", or "all".
+ * @return Mask of TraceConstants category bits, unknown names are ignored.
+ */
+quint32 Trace::parseCategories(const QString &names)
+{
+    quint32 mask = 0;
+    const QStringList list = names.split(',', Qt::SkipEmptyParts);
+    for (const QString &name : list) {
+        QString trimmed = name.trimmed().toLower();
+        if (trimmed == "all") {
+            mask = (1u << TraceConstants::CATEGORY_COUNT) - 1;
+        }
+        for (int i = 0; i < TraceConstants::CATEGORY_COUNT; i++) {
+            if (trimmed == categoryNames[i]) {
+                mask |= 1u << i;
+            }
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief Appends a record to the trace ring, overwriting the oldest one once the ring is full.
+ * Safe to call from any thread and never allocates. Use the TRACE macro instead of calling
+ * this directly so the call compiles away in release builds.
+ * @param Category bit from TraceConstants.
+ * @param Event from TraceConstants.
+ * @param First argument.
+ * @param Second argument.
+ * @param Third argument.
+ */
+void Trace::record(quint32 category, quint16 event, quint64 a, quint64 b, quint64 c)
+{
+    quint64 index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+    TraceSlot &slot = buffer[index & (TraceConstants::CAPACITY - 1)];
+    slot.stamp.store(2 * index + 1, std::memory_order_relaxed);
+    // Readers that see the old record change must also see the odd stamp
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.record.time = LatencyTracker::now();
+    slot.record.category = category;
+    slot.record.event = event;
+    slot.record.args[0] = a;
+    slot.record.args[1] = b;
+    slot.record.args[2] = c;
+    slot.stamp.store(2 * (index + 1), std::memory_order_release);
+}
+
+/**
+ * @brief Packs the start of a payload into a record argument, so text datagrams can be told
+ * apart in the dump without copying them anywhere.
+ * @param Payload.
+ * @param Payload size in bytes.
+ * @return Up to the first 8 bytes, the first one in the lowest byte.
+ */
+quint64 Trace::packBytes(const char *data, qint64 size)
+{
+    quint64 packed = 0;
+    for (int i = 0; i < 8 && i < size; i++) {
+        packed |= quint64(quint8(data[i])) << (8 * i);
+    }
+    return packed;
+}
+
+/**
+ * @brief Gets the number of records written since the start, including overwritten ones.
+ * @return Record count.
+ */
+quint64 Trace::recorded()
+{
+    return writeIndex.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Writes the records still held by the ring to a text file, oldest first. Records that
+ * are overwritten while the dump runs are skipped.
+ * @param Path of the file.
+ * @return True if the file was written, otherwise false.
+ */
+bool Trace::dump(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream out(&file);
+    quint64 head = recorded();
+    quint64 tail = head > quint64(TraceConstants::CAPACITY) ? head - TraceConstants::CAPACITY
+                                                             : 0;
+    out << "# " << head << " records traced, " << head - tail << " kept\n";
+    out << "# time_ns category event arguments\n";
+    for (quint64 index = tail; index < head; index++) {
+        const TraceSlot &slot = buffer[index & (TraceConstants::CAPACITY - 1)];
+        quint64 stamp = slot.stamp.load(std::memory_order_acquire);
+        if (!(stamp == 2 * (index + 1))) {
+            continue;
+        }
+        TraceRecord record = slot.record;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (!(slot.stamp.load(std::memory_order_relaxed) == stamp)) {
+            continue;
+        }
+        out << record.time << " " << categoryName(record.category) << " "
+            << (record.event < TraceConstants::EVENT_COUNT ? eventNames[record.event] : "?")
+            << " " << formatArguments(record) << "\n";
+    }
+    return true;
+}
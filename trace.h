@@ -0,0 +1,67 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "constants.h"
+
+#include <QString>
+
+#include <atomic>
+
+/**
+ * One trace event as stored in the trace ring. Arguments are raw integers whose meaning
+ * depends on the event (see TraceConstants), they are only turned into text when the ring is
+ * dumped so tracing a packet costs a few stores instead of string formatting.
+ */
+struct TraceRecord
+{
+    qint64 time;      // LatencyTracker::now() in nanoseconds
+    quint32 category; // One TraceConstants category bit
+    quint16 event;    // Event from TraceConstants
+    quint64 args[3];
+};
+
+/**
+ * Trace points are written with the TRACE macro:
+ *
+ *     TRACE(TraceConstants::RECEIVE, TraceConstants::DATAGRAM, address, port, size);
+ *
+ * Builds without REMOTECONTROL_TRACE defined (release builds by default) compile every trace
+ * point to nothing, the arguments are not even evaluated. Otherwise a point costs one relaxed
+ * load while its category is switched off.
+ */
+#ifdef REMOTECONTROL_TRACE
+#define TRACE(category, event, a, b, c) \
+    do { \
+        if (Trace::isEnabled(category)) { \
+            Trace::record(category, event, quint64(a), quint64(b), quint64(c)); \
+        } \
+    } while (false)
+#else
+#define TRACE(category, event, a, b, c) \
+    do { \
+    } while (false)
+#endif
+
+namespace Trace {
+extern std::atomic<quint32> enabledCategories;
+
+/**
+ * @brief Checks if trace points of a category are recorded.
+ * @param Category bit from TraceConstants.
+ * @return True if the category is switched on, otherwise false.
+ */
+inline bool isEnabled(quint32 category)
+{
+    return enabledCategories.load(std::memory_order_relaxed) & category;
+}
+
+bool isCompiledIn();
+void setCategories(quint32 mask);
+quint32 parseCategories(const QString &names);
+void record(quint32 category, quint16 event, quint64 a, quint64 b, quint64 c);
+quint64 packBytes(const char *data, qint64 size);
+quint64 recorded();
+bool dump(const QString &path);
+} // namespace Trace
+
+#endif // TRACE_H
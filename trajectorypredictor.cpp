@@ -0,0 +1,114 @@
+#include "trajectorypredictor.h"
+
+#include <algorithm>
+#include <cmath>
+
+TrajectoryPredictor::TrajectoryPredictor()
+{
+    reset();
+}
+
+/**
+ * @brief Forgets the history, done when the communication settings change.
+ */
+void TrajectoryPredictor::reset()
+{
+    newest = HISTORY - 1;
+    count = 0;
+    for (int i = 0; i < 4; i++) {
+        rates[i] = 0.0;
+    }
+}
+
+/**
+ * @brief Adds the setpoint of a send tick. Has to be called on every tick, also when nothing
+ * changed, so a held input flattens the fitted trend.
+ * @param Tick time in microseconds.
+ * @param Four wheel speeds in packet order.
+ */
+void TrajectoryPredictor::add(quint64 time, const double *speeds)
+{
+    newest = (newest + 1) & (HISTORY - 1);
+    times[newest] = time;
+    for (int i = 0; i < 4; i++) {
+        history[newest][i] = speeds[i];
+    }
+    count = std::min(count + 1, HISTORY);
+    fit();
+}
+
+/**
+ * @brief Fits the rate of every wheel with a least squares line through the setpoints inside
+ * the window. Kept at 0 until the window holds at least two setpoints.
+ */
+void TrajectoryPredictor::fit()
+{
+    int samples = 0;
+    double sumT = 0.0;
+    double sumTT = 0.0;
+    double sumS[4] = {0.0, 0.0, 0.0, 0.0};
+    double sumTS[4] = {0.0, 0.0, 0.0, 0.0};
+    for (int n = 0; n < count; n++) {
+        int index = (newest - n) & (HISTORY - 1);
+        quint64 age = times[newest] - times[index];
+        if (age > quint64(ProtocolConstants::TRAJECTORY_WINDOW)) {
+            break;
+        }
+        // Relative to the newest setpoint so the sums stay small
+        double t = -double(age);
+        samples++;
+        sumT += t;
+        sumTT += t * t;
+        for (int i = 0; i < 4; i++) {
+            sumS[i] += history[index][i];
+            sumTS[i] += t * history[index][i];
+        }
+    }
+
+    double denominator = samples * sumTT - sumT * sumT;
+    for (int i = 0; i < 4; i++) {
+        rates[i] = samples < 2 || denominator <= 0.0
+                       ? 0.0
+                       : (samples * sumTS[i] - sumT * sumS[i]) / denominator;
+    }
+}
+
+/**
+ * @brief Predicts evenly spaced setpoints starting at the newest one, clamped to the speed
+ * range on the side of zero the newest setpoint is on.
+ * @param Number of points, up to ProtocolConstants::MAX_TRAJECTORY_POINTS.
+ * @param Time between points in microseconds.
+ * @param Receives the points in packet order, the first one is the newest setpoint.
+ */
+void TrajectoryPredictor::predict(int points, int spacing, double (*out)[4]) const
+{
+    const double damping = ProtocolConstants::TRAJECTORY_DAMPING;
+    for (int n = 0; n < points; n++) {
+        // Integral of a rate fading with the damping time constant
+        double reach = damping * (1.0 - std::exp(-double(n) * spacing / damping));
+        for (int i = 0; i < 4; i++) {
+            double last = count == 0 ? 0.0 : history[newest][i];
+            // A trend may slow a wheel down to zero but never reverse it, a stopped one stays
+            double low = last >= 0.0 ? 0.0 : IOConstants::MIN;
+            double high = last <= 0.0 ? 0.0 : IOConstants::MAX;
+            out[n][i] = std::clamp(last + rates[i] * reach, low, high);
+        }
+    }
+}
+
+/**
+ * @brief Checks if the prediction is flat, a chunk of it then says no more than a movement
+ * packet and can be suppressed like one.
+ * @return True if no wheel is changing, otherwise false.
+ */
+bool TrajectoryPredictor::isSteady() const
+{
+    // Less than the finest suppression step over the whole damping reach
+    const double limit = 0.001 / ProtocolConstants::TRAJECTORY_DAMPING;
+    for (int i = 0; i < 4; i++) {
+        if (std::abs(rates[i]) >= limit) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+#ifndef TRAJECTORYPREDICTOR_H
+#define TRAJECTORYPREDICTOR_H
+
+#include "constants.h"
+
+/**
+ * Predicts the next wheel speed setpoints from the recent ones for trajectory chunks. The
+ * trend of every wheel is fitted over ProtocolConstants::TRAJECTORY_WINDOW and continued with
+ * an exponentially fading rate, so a prediction never runs further than rate * damping away
+ * from the last setpoint and a steady input predicts itself. A prediction never crosses zero,
+ * so a wheel slowing down stops at zero instead of running backward, and a wheel at zero is
+ * predicted to stay there.
+ */
+class TrajectoryPredictor
+{
+public:
+    TrajectoryPredictor();
+    void reset();
+    void add(quint64 time, const double *speeds);
+    void predict(int points, int spacing, double (*out)[4]) const;
+    bool isSteady() const;
+
+private:
+    static constexpr int HISTORY = 32; // Power of 2, covers the window at the highest send rate
+
+    quint64 times[HISTORY]; // us
+    double history[HISTORY][4];
+    int newest;
+    int count;
+    double rates[4]; // Speed change per microsecond, refitted on every add
+
+    void fit();
+};
+
+#endif // TRAJECTORYPREDICTOR_H